@@ -1,11 +1,13 @@
 #include "args.h"
 
+#include "run_mode_benchmark.h"
 #include "run_mode_cross_validation.h"
 #include "run_mode_injure_pool.h"
 #include "run_mode_learn.h"
 #include "run_mode_predict.h"
 #include "run_mode_research.h"
 #include "run_mode_tests.h"
+#include "run_mode_to_binary.h"
 #include "run_mode_to_svm_light.h"
 #include "run_mode_to_vowpal_wabbit.h"
 
@@ -20,6 +22,8 @@ int main(int argc, const char** argv) {
     modeChooser.Add("injure-pool", &DoInjurePool, "create injured pool from source features");
     modeChooser.Add("to-vowpal-wabbit", &ToVowpalWabbit, "create VowpalWabbit-compatible pool");
     modeChooser.Add("to-svm-light", &ToSVMLight, "create SVMLight-compatible pool");
+    modeChooser.Add("to-binary", &ToBinary, "create memory-mapped binary pool");
+    modeChooser.Add("bench", &DoBenchmark, "run performance benchmarks");
     modeChooser.Add("test", &DoTest, "run tests");
 
     return modeChooser.Run(argc, argv);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+inline size_t ResidentSetSize() {
+    std::ifstream statmIn("/proc/self/statm");
+
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    statmIn >> totalPages >> residentPages;
+    return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+// the high water mark of the resident set size since the start or the last reset
+inline size_t PeakResidentSetSize() {
+    std::ifstream statusIn("/proc/self/status");
+
+    std::string field;
+    while (statusIn >> field) {
+        if (field == "VmHWM:") {
+            size_t kilobytes = 0;
+            statusIn >> kilobytes;
+            return kilobytes * 1024;
+        }
+    }
+    return 0;
+}
+
+inline void ResetPeakResidentSetSize() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
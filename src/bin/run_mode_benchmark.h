@@ -0,0 +1,778 @@
+#pragma once
+
+#include "args.h"
+#include "memory_usage.h"
+#include "run_mode_learn.h"
+#include "timer.h"
+
+#include "../lib/binary_pool.h"
+#include "../lib/features_reader.h"
+#include "../lib/ldl_decomposition.h"
+#include "../lib/pool.h"
+#include "../lib/vector_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+struct TBenchmarkOptions {
+    std::string Benchmark = "threads";
+
+    std::string FeaturesPath;
+    std::string FormatName = "auto";
+    size_t InstancesCount = 1000000;
+    size_t FeaturesCount = 20;
+    size_t ReplicasCount = 1;
+    size_t NonZerosCount = 10;
+
+    TLearnOptions LearnOptions;
+
+    TBenchmarkOptions() {
+        LearnOptions.ThreadsCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    void AddOpts(TArgsParser& argsParser) {
+        argsParser.AddHandler("benchmark", &Benchmark, "benchmark to run, one from: threads, batch, simd, bslr, ldl, sparse, online, streams, parse, load, streaming, binary, formats, memory").Optional();
+
+        argsParser.AddHandler("features", &FeaturesPath, "features or binary pool file path, random pool is generated if empty").Optional();
+        argsParser.AddHandler("format", &FormatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
+        argsParser.AddHandler("instances", &InstancesCount, "random pool instances count, pool size for the memory benchmark").Optional();
+        argsParser.AddHandler("replicas", &ReplicasCount, "features file copies concatenated for the load and streaming benchmarks").Optional();
+        argsParser.AddHandler("features-count", &FeaturesCount, "random pool features count, maximal matrix size for the ldl benchmark").Optional();
+        argsParser.AddHandler("non-zeros", &NonZerosCount, "non-zero features per instance for the sparse benchmark").Optional();
+
+        LearnOptions.AddOpts(argsParser);
+    }
+};
+
+TPool MakeBenchmarkPool(const size_t instancesCount, const size_t featuresCount) {
+    std::mt19937 mersenne;
+    std::normal_distribution<double> randGen;
+
+    std::vector<double> coefficients(featuresCount);
+    for (double& coefficient : coefficients) {
+        coefficient = randGen(mersenne);
+    }
+
+    TPool pool;
+    pool.reserve(instancesCount);
+    for (size_t instanceIdx = 0; instanceIdx < instancesCount; ++instanceIdx) {
+        TInstance instance;
+        instance.Features.resize(featuresCount);
+        for (double& feature : instance.Features) {
+            feature = randGen(mersenne);
+        }
+        instance.Goal = std::inner_product(instance.Features.begin(), instance.Features.end(), coefficients.begin(), randGen(mersenne));
+        instance.Weight = 1.;
+
+        pool.push_back(instance);
+    }
+
+    return pool;
+}
+
+void BenchmarkThreads(const TPool& pool, const TLearnOptions& learnOptions) {
+    const size_t maxThreadsCount = learnOptions.ThreadsCount;
+
+    double singleThreadTime = 0.;
+    for (size_t threadsCount = 1;; threadsCount = std::min(2 * threadsCount, maxThreadsCount)) {
+        TLearnOptions threadsLearnOptions = learnOptions;
+        threadsLearnOptions.ThreadsCount = threadsCount;
+
+        TTimer timer;
+        Solve(pool.Iterator(), threadsLearnOptions);
+        const double learningTime = timer.GetSecondsPassed();
+
+        if (threadsCount == 1) {
+            singleThreadTime = learningTime;
+        }
+
+        std::cout << "threads: " << threadsCount << "\t"
+                  << "time: " << learningTime << "s\t"
+                  << "speedup: " << singleThreadTime / learningTime << std::endl;
+
+        if (threadsCount >= maxThreadsCount) {
+            break;
+        }
+    }
+}
+
+void BenchmarkBatches(const TPool& pool, const TLearnOptions& learnOptions) {
+    double perInstanceTime = 0.;
+    for (const size_t batchSize : {0, 16, 64, 256, 1024}) {
+        TLearnOptions batchLearnOptions = learnOptions;
+        batchLearnOptions.ThreadsCount = 1;
+        batchLearnOptions.BatchSize = batchSize;
+
+        TTimer timer;
+        Solve(pool.Iterator(), batchLearnOptions);
+        const double learningTime = timer.GetSecondsPassed();
+
+        if (!batchSize) {
+            perInstanceTime = learningTime;
+        }
+
+        std::cout << "batch: " << batchSize << "\t"
+                  << "time: " << learningTime << "s\t"
+                  << "instances per second: " << pool.size() / learningTime << "\t"
+                  << "speedup: " << perInstanceTime / learningTime << std::endl;
+    }
+}
+
+void BenchmarkVectorKernels(const TPool& pool, const TLearnOptions& learnOptions) {
+    double scalarTime = 0.;
+    for (const NVectorKernels::EInstructionSet instructionSet : {NVectorKernels::IS_SCALAR, NVectorKernels::IS_AVX2, NVectorKernels::IS_AVX512}) {
+        if (!NVectorKernels::IsSupported(instructionSet)) {
+            std::cout << NVectorKernels::ToString(instructionSet) << ": not supported" << std::endl;
+            continue;
+        }
+        NVectorKernels::SetActive(instructionSet);
+
+        TTimer timer;
+        const TLinearModel linearModel = Solve(pool.Iterator(), learnOptions);
+        const double learningTime = timer.GetSecondsPassed();
+
+        TTimer predictionTimer;
+        TRegressionMetricsCalculator::Build(pool.Iterator(), linearModel);
+        const double predictionTime = predictionTimer.GetSecondsPassed();
+
+        if (instructionSet == NVectorKernels::IS_SCALAR) {
+            scalarTime = learningTime;
+        }
+
+        std::cout << NVectorKernels::ToString(instructionSet) << ":\t"
+                  << "learn time: " << learningTime << "s\t"
+                  << "speedup: " << scalarTime / learningTime << "\t"
+                  << "prediction time: " << predictionTime << "s" << std::endl;
+    }
+    NVectorKernels::SetActive(NVectorKernels::BestSupported());
+}
+
+// the best simple regressions with a solver per feature against the vectorized ones keeping the features statistics in arrays
+template <typename TPerFeatureSolver, typename TVectorizedSolver>
+void BenchmarkBestSLRLayouts(const TPool& pool) {
+    TTimer perFeatureTimer;
+    const TLinearModel perFeatureModel = Solve<TPerFeatureSolver>(pool.Iterator());
+    const double perFeatureTime = perFeatureTimer.GetSecondsPassed();
+
+    TTimer vectorizedTimer;
+    const TLinearModel vectorizedModel = Solve<TVectorizedSolver>(pool.Iterator());
+    const double vectorizedTime = vectorizedTimer.GetSecondsPassed();
+
+    double maxCoefficientsDiff = fabs(perFeatureModel.Intercept - vectorizedModel.Intercept);
+    for (size_t featureNumber = 0; featureNumber < perFeatureModel.Coefficients.size() && featureNumber < vectorizedModel.Coefficients.size(); ++featureNumber) {
+        maxCoefficientsDiff = std::max(maxCoefficientsDiff, fabs(perFeatureModel.Coefficients[featureNumber] - vectorizedModel.Coefficients[featureNumber]));
+    }
+
+    std::cout << TVectorizedSolver::Name() << ":\t"
+              << "per-feature time: " << perFeatureTime << "s\t"
+              << "vectorized time: " << vectorizedTime << "s\t"
+              << "speedup: " << perFeatureTime / vectorizedTime << "\t"
+              << "max coefficients difference: " << maxCoefficientsDiff << std::endl;
+}
+
+void BenchmarkBestSLR(const TPool& pool) {
+    BenchmarkBestSLRLayouts<TTypedBestSLRSolver<TFastSLRSolver>, TFastBestSLRSolver>(pool);
+    BenchmarkBestSLRLayouts<TTypedBestSLRSolver<TKahanSLRSolver>, TKahanBestSLRSolver>(pool);
+    BenchmarkBestSLRLayouts<TTypedBestSLRSolver<TWelfordSLRSolver>, TWelfordBestSLRSolver>(pool);
+    BenchmarkBestSLRLayouts<TTypedBestSLRSolver<TNormalizedWelfordSLRSolver>, TNormalizedWelfordBestSLRSolver>(pool);
+}
+
+// the vector-of-vectors decomposition used before TLDLDecomposition, kept as the baseline
+namespace NReferenceLDL {
+    // LDL matrix decomposition, see http://en.wikipedia.org/wiki/Cholesky_decomposition#LDL_decomposition_2
+    bool LDLDecomposition(const std::vector<double>& linearizedOLSMatrix,
+                          const double regularizationThreshold,
+                          const double regularizationParameter,
+                          std::vector<double>& decompositionTrace,
+                          std::vector<std::vector<double>>& decompositionMatrix)
+    {
+        const size_t featuresCount = decompositionTrace.size();
+
+        size_t olsMatrixElementIdx = 0;
+        for (size_t rowNumber = 0; rowNumber < featuresCount; ++rowNumber) {
+            double& decompositionTraceElement = decompositionTrace[rowNumber];
+            decompositionTraceElement = linearizedOLSMatrix[olsMatrixElementIdx] + regularizationParameter;
+
+            std::vector<double>& decompositionRow = decompositionMatrix[rowNumber];
+            for (size_t i = 0; i < rowNumber; ++i) {
+                decompositionTraceElement -= decompositionRow[i] * decompositionRow[i] * decompositionTrace[i];
+            }
+
+            if (fabs(decompositionTraceElement) < regularizationThreshold) {
+                return false;
+            }
+
+            ++olsMatrixElementIdx;
+            decompositionRow[rowNumber] = 1.;
+            for (size_t columnNumber = rowNumber + 1; columnNumber < featuresCount; ++columnNumber) {
+                std::vector<double>& secondDecompositionRow = decompositionMatrix[columnNumber];
+                double& decompositionMatrixElement = secondDecompositionRow[rowNumber];
+
+                decompositionMatrixElement = linearizedOLSMatrix[olsMatrixElementIdx];
+
+                for (size_t j = 0; j < rowNumber; ++j) {
+                    decompositionMatrixElement -= decompositionRow[j] * secondDecompositionRow[j] * decompositionTrace[j];
+                }
+
+                decompositionMatrixElement /= decompositionTraceElement;
+
+                decompositionRow[columnNumber] = decompositionMatrixElement;
+                ++olsMatrixElementIdx;
+            }
+        }
+
+        return true;
+    }
+
+    void LDLDecomposition(const std::vector<double>& linearizedOLSMatrix,
+                          std::vector<double>& decompositionTrace,
+                          std::vector<std::vector<double>>& decompositionMatrix)
+    {
+        const double regularizationThreshold = 1e-5;
+        double regularizationParameter = 0.;
+
+        while (!LDLDecomposition(linearizedOLSMatrix,
+                                 regularizationThreshold,
+                                 regularizationParameter,
+                                 decompositionTrace,
+                                 decompositionMatrix))
+        {
+            regularizationParameter = regularizationParameter ? 2 * regularizationParameter : 1e-5;
+        }
+    }
+
+    std::vector<double> SolveLower(const std::vector<std::vector<double>>& decompositionMatrix,
+                                   const std::vector<double>& decompositionTrace,
+                                   const std::vector<double>& olsVector)
+    {
+        const size_t featuresCount = olsVector.size();
+
+        std::vector<double> solution(featuresCount);
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            double& solutionElement = solution[featureNumber];
+            solutionElement = olsVector[featureNumber];
+
+            const std::vector<double>& decompositionRow = decompositionMatrix[featureNumber];
+            for (size_t i = 0; i < featureNumber; ++i) {
+                solutionElement -= solution[i] * decompositionRow[i];
+            }
+        }
+
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            solution[featureNumber] /= decompositionTrace[featureNumber];
+        }
+
+        return solution;
+    }
+
+    std::vector<double> SolveUpper(const std::vector<std::vector<double>>& decompositionMatrix,
+                                   const std::vector<double>& lowerSolution)
+    {
+        const size_t featuresCount = lowerSolution.size();
+
+        std::vector<double> solution(featuresCount);
+        for (size_t featureNumber = featuresCount; featureNumber > 0; --featureNumber) {
+            double& solutionElement = solution[featureNumber - 1];
+            solutionElement = lowerSolution[featureNumber - 1];
+
+            const std::vector<double>& decompositionRow = decompositionMatrix[featureNumber - 1];
+            for (size_t i = featureNumber; i < featuresCount; ++i) {
+                solutionElement -= solution[i] * decompositionRow[i];
+            }
+        }
+
+        return solution;
+    }
+
+    std::vector<double> Solve(const std::vector<double>& olsMatrix, const std::vector<double>& olsVector) {
+        const size_t featuresCount = olsVector.size();
+
+        std::vector<double> decompositionTrace(featuresCount);
+        std::vector<std::vector<double>> decompositionMatrix(featuresCount, std::vector<double>(featuresCount));
+
+        LDLDecomposition(olsMatrix, decompositionTrace, decompositionMatrix);
+
+        return SolveUpper(decompositionMatrix, SolveLower(decompositionMatrix, decompositionTrace, olsVector));
+    }
+}
+
+// random symmetric positive definite matrix with a dominant diagonal as a packed upper triangle
+std::vector<double> MakeBenchmarkMatrix(const size_t size) {
+    std::mt19937 mersenne;
+    std::uniform_real_distribution<double> randGen(-1., 1.);
+
+    std::vector<double> linearizedMatrix;
+    for (size_t row = 0; row < size; ++row) {
+        linearizedMatrix.push_back(size + 1.);
+        for (size_t column = row + 1; column < size; ++column) {
+            linearizedMatrix.push_back(randGen(mersenne));
+        }
+    }
+    return linearizedMatrix;
+}
+
+void BenchmarkLDL(const size_t maxSize) {
+    for (const size_t size : {10, 30, 100, 300, 1000, 2000, 4000}) {
+        if (size > maxSize) {
+            break;
+        }
+
+        const std::vector<double> linearizedMatrix = MakeBenchmarkMatrix(size);
+        const std::vector<double> rightHandSide(size, 1.);
+        const size_t repeatsCount = std::max<size_t>(1, 100000000 / (size * size * size));
+
+        TTimer referenceTimer;
+        for (size_t repeatIdx = 0; repeatIdx < repeatsCount; ++repeatIdx) {
+            std::vector<double> decompositionTrace(size);
+            std::vector<std::vector<double>> decompositionMatrix(size, std::vector<double>(size));
+            NReferenceLDL::LDLDecomposition(linearizedMatrix, decompositionTrace, decompositionMatrix);
+            NReferenceLDL::SolveUpper(decompositionMatrix, NReferenceLDL::SolveLower(decompositionMatrix, decompositionTrace, rightHandSide));
+        }
+        const double referenceTime = referenceTimer.GetSecondsPassed() / repeatsCount;
+
+        TLDLDecomposition decomposition;
+        std::vector<double> solution;
+
+        TTimer timer;
+        for (size_t repeatIdx = 0; repeatIdx < repeatsCount; ++repeatIdx) {
+            decomposition.DecomposeRegularized(linearizedMatrix, size);
+            decomposition.Solve(rightHandSide, solution);
+        }
+        const double time = timer.GetSecondsPassed() / repeatsCount;
+
+        std::cout << "size: " << size << "\t"
+                  << "vector of vectors: " << referenceTime << "s\t"
+                  << "contiguous: " << time << "s\t"
+                  << "speedup: " << referenceTime / time << std::endl;
+    }
+}
+
+void BenchmarkSparse(const size_t instancesCount, const size_t featuresCount, const size_t nonZerosCount) {
+    std::mt19937 mersenne;
+    std::normal_distribution<double> randGen;
+    std::uniform_int_distribution<size_t> featureGen(0, featuresCount - 1);
+
+    // the rows are kept sparse, a dense pool of thousands of features would not fit the memory
+    std::vector<std::vector<TSparseFeature>> rows(instancesCount);
+    std::vector<double> goals(instancesCount);
+    for (size_t instanceIdx = 0; instanceIdx < instancesCount; ++instanceIdx) {
+        std::vector<TSparseFeature>& row = rows[instanceIdx];
+        for (size_t nonZeroIdx = 0; nonZeroIdx < nonZerosCount; ++nonZeroIdx) {
+            row.push_back({featureGen(mersenne), randGen(mersenne)});
+            goals[instanceIdx] += row.back().Value * (row.back().Index % 10);
+        }
+        std::sort(row.begin(), row.end(), [](const TSparseFeature& left, const TSparseFeature& right) {
+            return left.Index < right.Index;
+        });
+        row.erase(std::unique(row.begin(), row.end(), [](const TSparseFeature& left, const TSparseFeature& right) {
+            return left.Index == right.Index;
+        }), row.end());
+        goals[instanceIdx] += randGen(mersenne);
+    }
+
+    TFastLRSolver fastSolver;
+    std::vector<double> features(featuresCount);
+    TTimer fastTimer;
+    for (size_t instanceIdx = 0; instanceIdx < instancesCount; ++instanceIdx) {
+        for (const TSparseFeature& feature : rows[instanceIdx]) {
+            features[feature.Index] = feature.Value;
+        }
+        fastSolver.Add(features, goals[instanceIdx]);
+        for (const TSparseFeature& feature : rows[instanceIdx]) {
+            features[feature.Index] = 0.;
+        }
+    }
+    const double fastTime = fastTimer.GetSecondsPassed();
+
+    TSparseLRSolver sparseSolver;
+    TTimer sparseTimer;
+    for (size_t instanceIdx = 0; instanceIdx < instancesCount; ++instanceIdx) {
+        sparseSolver.Add(rows[instanceIdx], goals[instanceIdx]);
+    }
+    const double sparseTime = sparseTimer.GetSecondsPassed();
+
+    TTimer solveTimer;
+    const TLinearModel sparseModel = sparseSolver.Solve();
+    const double solveTime = solveTimer.GetSecondsPassed();
+
+    const TLinearModel fastModel = fastSolver.Solve();
+    double maxCoefficientsDiff = fabs(sparseModel.Intercept - fastModel.Intercept);
+    for (size_t featureNumber = 0; featureNumber < fastModel.Coefficients.size() && featureNumber < sparseModel.Coefficients.size(); ++featureNumber) {
+        maxCoefficientsDiff = std::max(maxCoefficientsDiff, fabs(sparseModel.Coefficients[featureNumber] - fastModel.Coefficients[featureNumber]));
+    }
+
+    std::cout << "instances: " << instancesCount << ", features: " << featuresCount << ", non-zeros: " << nonZerosCount << std::endl;
+    std::cout << "fast LR adds:\t" << fastTime << "s" << std::endl;
+    std::cout << "sparse LR adds:\t" << sparseTime << "s\t" << "speedup: " << fastTime / sparseTime << std::endl;
+    std::cout << "sparse LR solve:\t" << solveTime << "s\t" << "max coefficients difference: " << maxCoefficientsDiff << std::endl;
+}
+
+// time to fresh coefficients after every appended instance
+template <typename TSolver>
+double BenchmarkAppendAndSolve(const TPool& pool, const size_t instancesCount) {
+    TSolver solver;
+
+    TTimer timer;
+    for (size_t instanceIdx = 0; instanceIdx < instancesCount; ++instanceIdx) {
+        const TInstanceView instance = pool[instanceIdx];
+        solver.Add(instance.Features, instance.Goal, instance.Weight);
+        solver.Solve();
+    }
+    return timer.GetSecondsPassed() / instancesCount;
+}
+
+void BenchmarkOnline(const TPool& pool) {
+    const size_t instancesCount = std::min<size_t>(pool.size(), 10000);
+
+    const double refactorizationTime = BenchmarkAppendAndSolve<TWelfordLRSolver>(pool, instancesCount);
+    const double updateTime = BenchmarkAppendAndSolve<TOnlineLRSolver>(pool, instancesCount);
+
+    std::cout << "appended instances: " << instancesCount << "\t"
+              << "refactorization: " << refactorizationTime << "s per instance\t"
+              << "rank-one update: " << updateTime << "s per instance\t"
+              << "speedup: " << refactorizationTime / updateTime << std::endl;
+}
+
+void BenchmarkStreams(const TPool& pool, const TLearnOptions& learnOptions) {
+    for (const std::string learningMode : {"welford_lr", "decayed_welford_lr", "window_welford_lr"}) {
+        TLearnOptions streamLearnOptions = learnOptions;
+        streamLearnOptions.LearningMode = learningMode;
+        streamLearnOptions.ThreadsCount = 1;
+        streamLearnOptions.FixedSolvers = false;
+
+        TTimer timer;
+        Solve(pool.Iterator(), streamLearnOptions);
+        const double learningTime = timer.GetSecondsPassed();
+
+        std::cout << learningMode << ":\t"
+                  << "time: " << learningTime << "s\t"
+                  << "instances per second: " << pool.size() / learningTime << std::endl;
+    }
+}
+
+void BenchmarkParsing(const std::string& featuresPath) {
+    double streamTime = 0.;
+    size_t instancesCount = 0;
+    {
+        TTimer timer;
+        std::ifstream featuresIn(featuresPath);
+
+        TPool pool;
+        std::string featuresString;
+        while (getline(featuresIn, featuresString)) {
+            if (!featuresString.empty()) {
+                pool.push_back(TInstance::FromFeaturesString(featuresString));
+            }
+        }
+        streamTime = timer.GetSecondsPassed();
+        instancesCount = pool.size();
+    }
+
+    TTimer timer;
+    TPool pool;
+    const size_t bytesRead = pool.ReadFromFeatures(featuresPath);
+    const double readerTime = timer.GetSecondsPassed();
+
+    std::cout << "instances: " << instancesCount << ", size: " << bytesRead / 1e6 << " MB" << std::endl;
+    std::cout << "string streams:\t" << bytesRead / 1e6 / streamTime << " MB/s" << std::endl;
+    std::cout << "features reader:\t" << bytesRead / 1e6 / readerTime << " MB/s\t"
+              << "speedup: " << streamTime / readerTime << std::endl;
+}
+
+// concatenates the copies of the features file in the temporary directory, returns the path of the result
+std::string WriteReplicatedFeatures(const std::string& featuresPath, const size_t replicasCount, const std::string& fileName) {
+    const std::string replicatedPath = (std::filesystem::temp_directory_path() / fileName).string();
+
+    TTimer timer("replicated pool written in");
+
+    std::ifstream featuresIn(featuresPath, std::ios::binary);
+    const std::string features((std::istreambuf_iterator<char>(featuresIn)), std::istreambuf_iterator<char>());
+
+    std::ofstream replicatedOut(replicatedPath, std::ios::binary);
+    for (size_t replicaIdx = 0; replicaIdx < replicasCount; ++replicaIdx) {
+        replicatedOut << features;
+        if (!features.empty() && features.back() != '\n') {
+            replicatedOut << '\n';
+        }
+    }
+
+    return replicatedPath;
+}
+
+void BenchmarkLoading(const std::string& featuresPath, const size_t replicasCount, const size_t maxThreadsCount) {
+    const std::string replicatedPath = WriteReplicatedFeatures(featuresPath, replicasCount, "linear_regression_load_benchmark.features");
+
+    double singleThreadTime = 0.;
+    for (size_t threadsCount = 1;; threadsCount = std::min(2 * threadsCount, maxThreadsCount)) {
+        TTimer timer;
+        TPool pool;
+        const size_t bytesRead = pool.ReadFromFeatures(replicatedPath, threadsCount);
+        const double loadingTime = timer.GetSecondsPassed();
+
+        if (threadsCount == 1) {
+            singleThreadTime = loadingTime;
+        }
+
+        std::cout << "threads: " << threadsCount << "\t"
+                  << "instances: " << pool.size() << "\t"
+                  << "time: " << loadingTime << "s\t"
+                  << bytesRead / 1e6 / loadingTime << " MB/s\t"
+                  << "speedup: " << singleThreadTime / loadingTime << std::endl;
+
+        if (threadsCount >= maxThreadsCount) {
+            break;
+        }
+    }
+
+    std::filesystem::remove(replicatedPath);
+}
+
+void BenchmarkStreaming(const std::string& featuresPath, const size_t replicasCount, TLearnOptions learnOptions) {
+    const std::string replicatedPath = WriteReplicatedFeatures(featuresPath, replicasCount, "linear_regression_stream_benchmark.features");
+    learnOptions.ThreadsCount = 1;
+    learnOptions.BatchSize = 0;
+
+    const size_t residentSetSizeBefore = ResidentSetSize();
+
+    ResetPeakResidentSetSize();
+    TTimer streamTimer;
+    TFeaturesStreamIterator streamIterator(replicatedPath);
+    const TLinearModel streamModel = Solve(streamIterator, learnOptions);
+    const double streamTime = streamTimer.GetSecondsPassed();
+    const size_t streamPeak = PeakResidentSetSize();
+    const size_t bytesRead = streamIterator.GetBytesRead();
+
+    size_t inMemoryPeak = 0;
+    double inMemoryTime = 0.;
+    TLinearModel inMemoryModel;
+    {
+        ResetPeakResidentSetSize();
+        TTimer inMemoryTimer;
+        TPool pool;
+        pool.ReadFromFeatures(replicatedPath);
+        inMemoryModel = Solve(pool.Iterator(), learnOptions);
+        inMemoryTime = inMemoryTimer.GetSecondsPassed();
+        inMemoryPeak = PeakResidentSetSize();
+    }
+
+    double maxCoefficientsDiff = fabs(streamModel.Intercept - inMemoryModel.Intercept);
+    for (size_t featureNumber = 0; featureNumber < streamModel.Coefficients.size(); ++featureNumber) {
+        maxCoefficientsDiff = std::max(maxCoefficientsDiff, fabs(streamModel.Coefficients[featureNumber] - inMemoryModel.Coefficients[featureNumber]));
+    }
+
+    std::cout << "method: " << learnOptions.LearningMode << ", instances: " << streamIterator.GetInstanceIdx() + 1 << ", file size: " << bytesRead / 1e6 << " MB" << std::endl;
+    std::cout << "in memory:\t" << inMemoryTime << "s\t" << bytesRead / 1e6 / inMemoryTime << " MB/s\t"
+              << "peak RSS growth: " << (inMemoryPeak - residentSetSizeBefore) / 1e6 << " MB" << std::endl;
+    std::cout << "streamed:\t" << streamTime << "s\t" << bytesRead / 1e6 / streamTime << " MB/s\t"
+              << "peak RSS growth: " << (streamPeak - residentSetSizeBefore) / 1e6 << " MB" << std::endl;
+    std::cout << "max coefficients difference: " << maxCoefficientsDiff << std::endl;
+
+    std::filesystem::remove(replicatedPath);
+}
+
+void BenchmarkBinaryPool(const std::string& featuresPath, const TLearnOptions& learnOptions) {
+    TTimer featuresTimer;
+    TPool pool;
+    const size_t featuresSize = pool.ReadFromFeatures(featuresPath, learnOptions.ThreadsCount);
+    const double featuresTime = featuresTimer.GetSecondsPassed();
+
+    const std::string binaryPath = (std::filesystem::temp_directory_path() / "linear_regression_binary_benchmark.bin").string();
+    size_t binarySize = 0;
+    {
+        TTimer timer("binary pool written in");
+        binarySize = NBinaryPool::Write(pool, binaryPath);
+    }
+
+    TTimer mappingTimer;
+    TMappedPool mappedPool;
+    const bool isMapped = mappedPool.Open(binaryPath);
+    const double mappingTime = mappingTimer.GetSecondsPassed();
+
+    TTimer binaryTimer;
+    TPool binaryPool;
+    const bool isRead = binaryPool.ReadFromBinary(binaryPath);
+    const double binaryTime = binaryTimer.GetSecondsPassed();
+
+    if (!isMapped || !isRead) {
+        std::cerr << "could not read binary pool from " << binaryPath << std::endl;
+        std::filesystem::remove(binaryPath);
+        return;
+    }
+
+    std::cout << "instances: " << pool.size() << ", features size: " << featuresSize / 1e6 << " MB, binary size: " << binarySize / 1e6 << " MB" << std::endl;
+    std::cout << "features file read:\t" << featuresTime << "s" << std::endl;
+    std::cout << "binary pool mapped:\t" << mappingTime << "s" << std::endl;
+    std::cout << "binary pool read:\t" << binaryTime << "s\t" << "speedup: " << featuresTime / binaryTime << std::endl;
+
+    std::filesystem::remove(binaryPath);
+}
+
+void BenchmarkFormats(const std::string& featuresPath, const TLearnOptions& learnOptions) {
+    TTimer featuresTimer;
+    TPool pool;
+    const size_t featuresSize = pool.ReadFromFeatures(featuresPath, learnOptions.ThreadsCount);
+    const double featuresTime = featuresTimer.GetSecondsPassed();
+
+    std::cout << "instances: " << pool.size() << ", features: " << pool.FeaturesCount() << std::endl;
+    std::cout << "features:\t" << featuresTime << "s\t" << featuresSize / 1e6 / featuresTime << " MB/s" << std::endl;
+
+    const std::pair<EPoolFormat, std::string> formats[] = {
+        {PF_SVM_LIGHT, "svm-light"},
+        {PF_VOWPAL_WABBIT, "vowpal-wabbit"},
+    };
+    for (const auto& formatAndName : formats) {
+        const std::string formatPath = (std::filesystem::temp_directory_path() / ("linear_regression_formats_benchmark." + formatAndName.second)).string();
+        {
+            std::ofstream formatOut(formatPath);
+            if (formatAndName.first == PF_SVM_LIGHT) {
+                pool.PrintForSVMLight(formatOut);
+            } else {
+                pool.PrintForVowpalWabbit(formatOut);
+            }
+        }
+
+        TTimer timer;
+        TPool formatPool;
+        const size_t formatSize = formatPool.ReadFromFeatures(formatPath, learnOptions.ThreadsCount, formatAndName.first);
+        const double formatTime = timer.GetSecondsPassed();
+
+        std::cout << formatAndName.second << ":\t" << formatTime << "s\t"
+                  << formatSize / 1e6 / formatTime << " MB/s\t"
+                  << "speedup vs features: " << featuresTime / formatTime << std::endl;
+
+        std::filesystem::remove(formatPath);
+    }
+}
+
+void BenchmarkMemory(const TPool& sourcePool, const size_t instancesCount) {
+    const size_t residentSetSizeBefore = ResidentSetSize();
+
+    TPool pool;
+    pool.reserve(instancesCount);
+    for (size_t instanceIdx = 0; instanceIdx < instancesCount; ++instanceIdx) {
+        pool.push_back(sourcePool[instanceIdx % sourcePool.size()]);
+    }
+
+    const double bytesPerInstance = double(ResidentSetSize() - residentSetSizeBefore) / instancesCount;
+    std::cout << "instances: " << pool.size() << ", features: " << pool.FeaturesCount() << std::endl;
+    std::cout << "resident bytes per instance: " << bytesPerInstance << ", "
+              << "allocated bytes per instance: " << double(pool.AllocatedBytes()) / instancesCount << ", "
+              << "features bytes per instance: " << pool.FeaturesCount() * sizeof(double) << std::endl;
+    std::cout << "50M instances would take " << bytesPerInstance * 50e6 / 1e9 << " GB" << std::endl;
+}
+
+int DoBenchmark(int argc, const char** argv) {
+    TBenchmarkOptions benchmarkOptions;
+    {
+        TArgsParser argsParser;
+        benchmarkOptions.AddOpts(argsParser);
+        argsParser.DoParse(argc, argv);
+    }
+    if (!benchmarkOptions.LearnOptions.Check()) {
+        return 1;
+    }
+
+    if (benchmarkOptions.Benchmark == "parse") {
+        if (benchmarkOptions.FeaturesPath.empty()) {
+            std::cerr << "parse benchmark needs a features file" << std::endl;
+            return 1;
+        }
+        BenchmarkParsing(benchmarkOptions.FeaturesPath);
+        return 0;
+    }
+
+    if (benchmarkOptions.Benchmark == "load") {
+        if (benchmarkOptions.FeaturesPath.empty()) {
+            std::cerr << "load benchmark needs a features file" << std::endl;
+            return 1;
+        }
+        BenchmarkLoading(benchmarkOptions.FeaturesPath, benchmarkOptions.ReplicasCount, benchmarkOptions.LearnOptions.ThreadsCount);
+        return 0;
+    }
+
+    if (benchmarkOptions.Benchmark == "streaming") {
+        if (benchmarkOptions.FeaturesPath.empty()) {
+            std::cerr << "streaming benchmark needs a features file" << std::endl;
+            return 1;
+        }
+        BenchmarkStreaming(benchmarkOptions.FeaturesPath, benchmarkOptions.ReplicasCount, benchmarkOptions.LearnOptions);
+        return 0;
+    }
+
+    if (benchmarkOptions.Benchmark == "binary") {
+        if (benchmarkOptions.FeaturesPath.empty()) {
+            std::cerr << "binary benchmark needs a features file" << std::endl;
+            return 1;
+        }
+        BenchmarkBinaryPool(benchmarkOptions.FeaturesPath, benchmarkOptions.LearnOptions);
+        return 0;
+    }
+
+    if (benchmarkOptions.Benchmark == "formats") {
+        if (benchmarkOptions.FeaturesPath.empty()) {
+            std::cerr << "formats benchmark needs a features file" << std::endl;
+            return 1;
+        }
+        BenchmarkFormats(benchmarkOptions.FeaturesPath, benchmarkOptions.LearnOptions);
+        return 0;
+    }
+
+    if (benchmarkOptions.Benchmark == "sparse") {
+        BenchmarkSparse(benchmarkOptions.InstancesCount, benchmarkOptions.FeaturesCount, benchmarkOptions.NonZerosCount);
+        return 0;
+    }
+
+    if (benchmarkOptions.Benchmark == "ldl") {
+        BenchmarkLDL(benchmarkOptions.FeaturesCount);
+        return 0;
+    }
+
+    EPoolFormat format;
+    if (!ParsePoolFormat(benchmarkOptions.FormatName, format)) {
+        std::cerr << "unknown pool format: " << benchmarkOptions.FormatName << std::endl;
+        return 1;
+    }
+
+    TPool pool;
+    {
+        TTimer timer("pool prepared in");
+        if (benchmarkOptions.FeaturesPath.empty()) {
+            pool = MakeBenchmarkPool(benchmarkOptions.InstancesCount, benchmarkOptions.FeaturesCount);
+        } else {
+            if (!pool.Read(benchmarkOptions.FeaturesPath, benchmarkOptions.LearnOptions.ThreadsCount, format)) {
+                std::cerr << "could not read pool from " << benchmarkOptions.FeaturesPath << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::cout << "method: " << benchmarkOptions.LearnOptions.LearningMode << ", "
+              << "instances: " << pool.size() << ", "
+              << "features: " << pool.FeaturesCount() << std::endl;
+
+    if (benchmarkOptions.Benchmark == "memory") {
+        BenchmarkMemory(pool, benchmarkOptions.InstancesCount);
+    } else if (benchmarkOptions.Benchmark == "threads") {
+        BenchmarkThreads(pool, benchmarkOptions.LearnOptions);
+    } else if (benchmarkOptions.Benchmark == "batch") {
+        BenchmarkBatches(pool, benchmarkOptions.LearnOptions);
+    } else if (benchmarkOptions.Benchmark == "simd") {
+        BenchmarkVectorKernels(pool, benchmarkOptions.LearnOptions);
+    } else if (benchmarkOptions.Benchmark == "bslr") {
+        BenchmarkBestSLR(pool);
+    } else if (benchmarkOptions.Benchmark == "online") {
+        BenchmarkOnline(pool);
+    } else if (benchmarkOptions.Benchmark == "streams") {
+        BenchmarkStreams(pool, benchmarkOptions.LearnOptions);
+    } else {
+        std::cerr << "unknown benchmark: " << benchmarkOptions.Benchmark << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
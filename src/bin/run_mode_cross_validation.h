@@ -3,100 +3,355 @@
 #include "args.h"
 #include "run_mode_learn.h"
 
+#include "../lib/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
 
 struct TCrossValidationResult {
     double MeanDeterminationCoefficient;
+    // CPU time of the learning jobs summed over the threads, comparable to a sequential learning time
     double LearningTimeInSeconds;
+    double LearningWallTimeInSeconds;
 };
 
-TCrossValidationResult CrossValidation(
-    const TPool& pool,
-    const size_t foldsCount,
-    const size_t runsCount,
-    const std::string& learningMode,
-    const std::string verboseMode,
-    const bool verbose) {
-    double learningTime = 0;
-
-    TPool::TCVIterator learnIterator = pool.LearnIterator(foldsCount);
-    TPool::TCVIterator testIterator = pool.TestIterator(foldsCount);
-
-    TMeanCalculator meanDCCalculator;
-    for (size_t runIdx = 0; runIdx < runsCount; ++runIdx) {
-        learnIterator.ResetShuffle();
-        testIterator.ResetShuffle();
-
-        TMeanCalculator meanFoldDCCalculator;
-        for (size_t fold = 0; fold < foldsCount; ++fold) {
-            learnIterator.SetTestFold(fold);
-            testIterator.SetTestFold(fold);
-
-            TLinearModel linearModel;
-            {
-                TTimer timer;
-                linearModel = Solve(learnIterator, learningMode);
-                learningTime += timer.GetSecondsPassed();
+// the folds of a run depend on its number only, whatever the threads count and the order of the jobs
+inline uint32_t CrossValidationRunSeed(const size_t runIdx) {
+    return std::mt19937::default_seed + runIdx;
+}
+
+// The independent jobs of a cross-validation over a shared pool: a learning job learns a fold, or all the folds
+// of a run from the fold statistics, and an evaluation job scores the models of a fold once they are learned.
+// Several learning modes are learned together, feeding every instance to all of their solvers in a single pass,
+// and scored in a single pass over the test fold too.
+// The jobs write to their own slots only, so they may run on any threads in any order.
+class TCrossValidationJobs {
+private:
+    TPoolView Pool;
+    size_t FoldsCount;
+    size_t RunsCount;
+    TLearnOptions LearnOptions;
+    std::vector<std::string> LearningModes;
+    bool UseFoldStatistics;
+
+    std::vector<TPool::TCVIterator> LearnIterators;
+    std::vector<TPool::TCVIterator> TestIterators;
+
+    // the models of every learning mode for every fold of every run
+    std::vector<std::vector<std::vector<TLinearModel>>> FoldModels;
+    // the determination coefficients of the modes, mode by mode for every evaluation job
+    std::vector<double> DeterminationCoefficients;
+
+public:
+    // every job learns on learnOptions.ThreadsCount threads unless SetLearningThreadsCount is called;
+    // the learning modes are the one of the options if none are given
+    TCrossValidationJobs(const TPoolView& pool, const size_t foldsCount, const size_t runsCount, const TLearnOptions& learnOptions, const std::vector<std::string>& learningModes = {})
+        : TCrossValidationJobs(pool, RunIterators(pool.GetPool(), foldsCount, runsCount), learnOptions, learningModes)
+    {
+    }
+
+    // the jobs over the folds of the run iterators given, which may be shared by the views of the same pool
+    TCrossValidationJobs(const TPoolView& pool, const std::vector<TPool::TCVIterator>& runIterators, const TLearnOptions& learnOptions, const std::vector<std::string>& learningModes = {})
+        : Pool(pool)
+        , FoldsCount(runIterators.empty() ? 0 : runIterators.front().GetFoldsCount())
+        , RunsCount(runIterators.size())
+        , LearnOptions(learnOptions)
+        , LearningModes(learningModes.empty() ? std::vector<std::string>{learnOptions.LearningMode} : learningModes)
+        , UseFoldStatistics(learnOptions.FoldStatistics)
+        , FoldModels(RunsCount, std::vector<std::vector<TLinearModel>>(FoldsCount))
+        , DeterminationCoefficients(RunsCount * FoldsCount * LearningModes.size())
+    {
+        for (const std::string& learningMode : LearningModes) {
+            TLearnOptions modeLearnOptions = learnOptions;
+            modeLearnOptions.LearningMode = learningMode;
+            UseFoldStatistics &= !modeLearnOptions.IsStreamingMethod();
+        }
+
+        for (const TPool::TCVIterator& runIterator : runIterators) {
+            LearnIterators.push_back(runIterator.LearnSide(pool.GetTransform()));
+            TestIterators.push_back(runIterator.TestSide(pool.GetTransform()));
+        }
+    }
+
+    // an iterator with the folds of every run of a cross-validation over the pool
+    static std::vector<TPool::TCVIterator> RunIterators(const TPool& pool, const size_t foldsCount, const size_t runsCount) {
+        std::vector<TPool::TCVIterator> runIterators;
+        for (size_t runIdx = 0; runIdx < runsCount; ++runIdx) {
+            runIterators.push_back(pool.LearnIterator(foldsCount));
+            runIterators.back().ResetShuffle(CrossValidationRunSeed(runIdx));
+        }
+        return runIterators;
+    }
+
+    void SetLearningThreadsCount(const size_t threadsCount) {
+        LearnOptions.ThreadsCount = threadsCount;
+    }
+
+    const std::vector<std::string>& GetLearningModes() const {
+        return LearningModes;
+    }
+
+    size_t LearnJobsCount() const {
+        return UseFoldStatistics ? RunsCount : RunsCount * FoldsCount;
+    }
+
+    // returns false, reporting the error, if the learning modes cannot be learned together
+    bool Learn(const size_t learnJobIdx) {
+        if (UseFoldStatistics) {
+            return SolveFolds(Pool, LearnIterators[learnJobIdx], FoldsCount, LearningModes, LearnOptions, FoldModels[learnJobIdx]);
+        }
+
+        TPool::TCVIterator learnIterator = LearnIterators[learnJobIdx / FoldsCount];
+        learnIterator.SetTestFold(learnJobIdx % FoldsCount);
+        return Solve(learnIterator, LearningModes, LearnOptions, FoldModels[learnJobIdx / FoldsCount][learnJobIdx % FoldsCount]);
+    }
+
+    // an evaluation job for every fold of every run
+    size_t EvaluationJobsCount() const {
+        return RunsCount * FoldsCount;
+    }
+
+    // the evaluation jobs [begin, end) of the models learned by the learning job
+    std::pair<size_t, size_t> LearnedEvaluationJobs(const size_t learnJobIdx) const {
+        return UseFoldStatistics ? std::make_pair(learnJobIdx * FoldsCount, (learnJobIdx + 1) * FoldsCount) : std::make_pair(learnJobIdx, learnJobIdx + 1);
+    }
+
+    void Evaluate(const size_t evaluationJobIdx) {
+        TPool::TCVIterator testIterator = TestIterators[evaluationJobIdx / FoldsCount];
+        testIterator.SetTestFold(evaluationJobIdx % FoldsCount);
+        const std::vector<TLinearModel>& linearModels = FoldModels[evaluationJobIdx / FoldsCount][evaluationJobIdx % FoldsCount];
+
+        std::vector<TRegressionMetricsCalculator> calculators(LearningModes.size());
+        for (; testIterator.IsValid(); ++testIterator) {
+            for (size_t modeIdx = 0; modeIdx < LearningModes.size(); ++modeIdx) {
+                calculators[modeIdx].Add(linearModels[modeIdx].Prediction(*testIterator), testIterator->Goal, testIterator->Weight);
+            }
+        }
+        for (size_t modeIdx = 0; modeIdx < LearningModes.size(); ++modeIdx) {
+            DeterminationCoefficients[evaluationJobIdx * LearningModes.size() + modeIdx] = calculators[modeIdx].DeterminationCoefficient();
+        }
+    }
+
+    // mean determination coefficient of the learning mode over the runs once all the jobs are done
+    double MeanDeterminationCoefficient(const size_t modeIdx, const std::string& verboseMode, const bool verbose) const {
+        TMeanCalculator meanDCCalculator;
+        for (size_t runIdx = 0; runIdx < RunsCount; ++runIdx) {
+            TMeanCalculator meanFoldDCCalculator;
+            for (size_t fold = 0; fold < FoldsCount; ++fold) {
+                const double determinationCoefficient = DeterminationCoefficients[(runIdx * FoldsCount + fold) * LearningModes.size() + modeIdx];
+
+                if (verbose && verboseMode == "folds") {
+                    std::cout << "    ";
+                    if (RunsCount > 1) {
+                        std::cout << "    run #" << runIdx << ", ";
+                    }
+                    std::cout << "fold #" << fold << ": R^2 = " << determinationCoefficient << std::endl;
+                }
+
+                meanFoldDCCalculator.Add(determinationCoefficient);
             }
-            const double determinationCoefficient = TRegressionMetricsCalculator::Build(testIterator, linearModel).DeterminationCoefficient();
 
-            if (verbose && verboseMode == "folds") {
-                std::cout << "    ";
-                if (runsCount > 1) {
+            if (verbose && verboseMode != "overall") {
+                if (RunsCount > 1) {
                     std::cout << "    run #" << runIdx << ", ";
                 }
-                std::cout << "fold #" << fold << ": R^2 = " << determinationCoefficient << std::endl;
+                std::cout << "CV R^2: " << meanFoldDCCalculator.GetMean() << std::endl;
             }
 
-            meanFoldDCCalculator.Add(determinationCoefficient);
+            meanDCCalculator.Add(meanFoldDCCalculator.GetMean());
         }
 
-        if (verbose && verboseMode != "overall") {
-            if (runsCount > 1) {
-                std::cout << "    run #" << runIdx << ", ";
-            }
-            std::cout << "CV R^2: " << meanFoldDCCalculator.GetMean() << std::endl;
+        if (verbose && RunsCount > 1) {
+            std::cout << "CV RMSE over " << RunsCount << " runs: " << meanDCCalculator.GetMean() << std::endl;
         }
 
-        meanDCCalculator.Add(meanFoldDCCalculator.GetMean());
+        return meanDCCalculator.GetMean();
     }
+};
+
+// Runs the cross-validation jobs of the learning modes on learnOptions.ThreadsCount threads; the threads left over
+// by the learning jobs go to the learning of each job. The modes are learned together, so they share the learning time.
+// The results are empty if the modes cannot be learned together.
+std::vector<TCrossValidationResult> CrossValidation(
+    const TPoolView& pool,
+    const size_t foldsCount,
+    const size_t runsCount,
+    const TLearnOptions& learnOptions,
+    const std::vector<std::string>& learningModes,
+    const std::string verboseMode,
+    const bool verbose) {
+    TCrossValidationJobs cvJobs(pool, foldsCount, runsCount, learnOptions, learningModes);
+
+    const size_t jobThreadsCount = std::max<size_t>(1, std::min(learnOptions.ThreadsCount, cvJobs.LearnJobsCount()));
+    cvJobs.SetLearningThreadsCount(std::max<size_t>(1, learnOptions.ThreadsCount / jobThreadsCount));
 
-    if (verbose && runsCount > 1) {
-        std::cout << "CV RMSE over " << runsCount << " runs: " << meanDCCalculator.GetMean() << std::endl;
+    // the CPU time of every job is taken on its own thread, so that the work of the other threads of the process is not counted;
+    // the helper threads of a job learning on several threads are not counted either
+    TTimer learningWallTimer;
+    std::vector<double> learnJobCPUTimes(cvJobs.LearnJobsCount());
+    std::atomic<bool> learned{true};
+    ParallelFor(cvJobs.LearnJobsCount(), jobThreadsCount, [&cvJobs, &learnJobCPUTimes, &learned](const size_t learnJobIdx) {
+        TThreadCPUTimer cpuTimer;
+        if (learned && !cvJobs.Learn(learnJobIdx)) {
+            learned = false;
+        }
+        learnJobCPUTimes[learnJobIdx] = cpuTimer.GetSecondsPassed();
+    });
+    if (!learned) {
+        return {};
     }
+    const double learningTime = std::accumulate(learnJobCPUTimes.begin(), learnJobCPUTimes.end(), 0.);
+    const double learningWallTime = learningWallTimer.GetSecondsPassed();
 
-    return {meanDCCalculator.GetMean(), learningTime};
+    ParallelFor(cvJobs.EvaluationJobsCount(), learnOptions.ThreadsCount, [&cvJobs](const size_t evaluationJobIdx) {
+        cvJobs.Evaluate(evaluationJobIdx);
+    });
+
+    std::vector<TCrossValidationResult> results;
+    for (size_t modeIdx = 0; modeIdx < cvJobs.GetLearningModes().size(); ++modeIdx) {
+        if (verbose && cvJobs.GetLearningModes().size() > 1) {
+            std::cout << cvJobs.GetLearningModes()[modeIdx] << ":" << std::endl;
+        }
+        results.push_back({cvJobs.MeanDeterminationCoefficient(modeIdx, verboseMode, verbose), learningTime, learningWallTime});
+    }
+    if (verbose) {
+        std::cout << "learning time: " << learningTime << "s CPU, " << learningWallTime << "s wall" << std::endl;
+    }
+
+    return results;
+}
+
+// returns false for the methods having no closed-form leave-one-out; skippedCount gets the instances with a leverage close to one
+inline bool LeaveOneOutCrossValidation(const TPool& pool, const TLearnOptions& learnOptions, TRegressionMetricsCalculator& rmc, size_t& skippedCount) {
+    const std::string& learningMode = learnOptions.LearningMode;
+    if (learningMode == "fast_lr") {
+        rmc = LeaveOneOutMetrics<TFastLRSolver>(pool, learnOptions.ThreadsCount, learnOptions.BatchSize, &skippedCount);
+        return true;
+    }
+    if (learningMode == "welford_lr") {
+        rmc = LeaveOneOutMetrics<TWelfordLRSolver>(pool, learnOptions.ThreadsCount, learnOptions.BatchSize, &skippedCount);
+        return true;
+    }
+    if (learningMode == "normalized_welford_lr") {
+        rmc = LeaveOneOutMetrics<TNormalizedWelfordLRSolver>(pool, learnOptions.ThreadsCount, learnOptions.BatchSize, &skippedCount);
+        return true;
+    }
+    return false;
 }
 
 int DoCrossValidation(int argc, const char** argv) {
     std::string featuresPath;
+    std::string formatName = "auto";
 
-    std::string learningMode = "welford_lr";
+    TLearnOptions learnOptions;
     size_t foldsCount = 5;
     size_t runsCount = 1;
 
     std::string verboseMode = "folds";
+    bool leaveOneOut = false;
+    std::string learningModesList;
 
     {
         TArgsParser argsParser;
-        argsParser.AddHandler("features", &featuresPath, "features file path").Required();
-        argsParser.AddHandler("method", &learningMode, "learning mode, one from: fast_bslr, kahan_bslr, welford_bslr, fast_lr, welford_lr, normalized_welford_lr").Optional();
+        argsParser.AddHandler("features", &featuresPath, "features or binary pool file path").Required();
+        argsParser.AddHandler("format", &formatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
+        learnOptions.AddOpts(argsParser);
 
         argsParser.AddHandler("folds", &foldsCount, "cross-validation folds count").Optional();
-        argsParser.AddHandler("runs", &runsCount, "cross-validation runs count").Optional();
+        argsParser.AddHandler("runs", &runsCount, "cross-validation runs count, the folds and the runs are learned in parallel on --threads threads").Optional();
+        argsParser.AddHandler("loo", &leaveOneOut, "closed-form leave-one-out cross-validation for LR methods, 0 or 1").Optional();
+        argsParser.AddHandler("fold-statistics", &learnOptions.FoldStatistics, "learn all the folds from one pass over per-fold statistics instead of a pass per fold, 0 or 1").Optional();
+        argsParser.AddHandler("methods", &learningModesList, "comma-separated learning modes cross-validated together, feeding every instance to all of them in a single pass; --method if empty").Optional();
 
         argsParser.AddHandler("verbose", &verboseMode, "verbose mode, one of: folds, cv, overall").Optional();
 
         argsParser.DoParse(argc, argv);
     }
+    if (!learnOptions.Check()) {
+        return 1;
+    }
+
+    EPoolFormat format;
+    if (!ParsePoolFormat(formatName, format)) {
+        std::cerr << "unknown pool format: " << formatName << std::endl;
+        return 1;
+    }
 
     TPool pool;
     {
         TTimer timer("pool read in");
-        pool.ReadFromFeatures(featuresPath);
+        const size_t bytesRead = pool.Read(featuresPath, learnOptions.ThreadsCount, format);
+        if (!bytesRead) {
+            std::cerr << "could not read pool from " << featuresPath << std::endl;
+            return 1;
+        }
+        std::cout << "parse throughput: " << bytesRead / 1e6 / timer.GetSecondsPassed() << " MB/s" << std::endl;
     }
 
-    CrossValidation(pool, foldsCount, runsCount, learningMode, verboseMode, true);
+    if (leaveOneOut) {
+        TRegressionMetricsCalculator rmc;
+        size_t skippedCount = 0;
+        {
+            TTimer timer("leave-one-out done in");
+            if (!LeaveOneOutCrossValidation(pool, learnOptions, rmc, skippedCount)) {
+                std::cerr << "leave-one-out needs an LR method" << std::endl;
+                return 1;
+            }
+        }
+        if (skippedCount) {
+            std::cout << "LOO skipped " << skippedCount << " instances with leverage close to 1" << std::endl;
+        }
+        std::cout << "LOO rmse: " << rmc.RMSE() << std::endl;
+        std::cout << "LOO R^2:  " << rmc.DeterminationCoefficient() << std::endl;
+
+        return 0;
+    }
+
+    if (learnOptions.RidgePath) {
+        std::vector<double> ridgeParameters;
+        if (!learnOptions.PrepareRidgePath(ridgeParameters)) {
+            return 1;
+        }
+
+        const TRidgePathResult ridgePathResult = RidgePathCrossValidation(pool, foldsCount, runsCount, learnOptions, ridgeParameters);
+
+        for (size_t parameterIdx = 0; parameterIdx < ridgePathResult.RidgeParameters.size(); ++parameterIdx) {
+            std::cout << "ridge parameter " << ridgePathResult.RidgeParameters[parameterIdx] << ": CV R^2 = " << ridgePathResult.MeanDeterminationCoefficients[parameterIdx] << std::endl;
+        }
+        std::cout << "CV-best ridge parameter: " << ridgePathResult.RidgeParameters[ridgePathResult.BestIdx] << std::endl;
+
+        return 0;
+    }
+
+    std::vector<std::string> learningModes;
+    {
+        std::stringstream ss(learningModesList);
+        std::string learningMode;
+        while (std::getline(ss, learningMode, ',')) {
+            learningModes.push_back(learningMode);
+        }
+    }
+    if (learningModes.empty()) {
+        learningModes.push_back(learnOptions.LearningMode);
+    }
+    for (const std::string& learningMode : learningModes) {
+        TLearnOptions modeLearnOptions = learnOptions;
+        modeLearnOptions.LearningMode = learningMode;
+
+        TFusedSolver fusedSolver;
+        if (!modeLearnOptions.IsStreamingMethod() && !MakeFusedSolver({learningMode}, modeLearnOptions, pool.FeaturesCount(), fusedSolver)) {
+            std::cerr << "unknown learning mode: " << learningMode << std::endl;
+            return 1;
+        }
+    }
+
+    if (CrossValidation(pool, foldsCount, runsCount, learnOptions, learningModes, verboseMode, true).empty()) {
+        return 1;
+    }
 
     return 0;
 }
@@ -6,20 +6,32 @@
 
 int DoInjurePool(int argc, const char** argv) {
     std::string featuresPath;
+    size_t threadsCount = 1;
+    std::string formatName = "auto";
     double injureFactor = 1e-3;
     double injureOffset = 1e+3;
 
     {
         TArgsParser argsParser;
-        argsParser.AddHandler("features", &featuresPath, "features file path").Required();
+        argsParser.AddHandler("features", &featuresPath, "features or binary pool file path").Required();
+        argsParser.AddHandler("threads", &threadsCount, "features loading threads count").Optional();
+        argsParser.AddHandler("format", &formatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
         argsParser.AddHandler("injure-factor", &injureFactor, "pool injure factor, feature = feature * factor + offset").Optional();
         argsParser.AddHandler("injure-offset", &injureOffset, "pool injure offset, feature = feature * factor + offset").Optional();
         argsParser.DoParse(argc, argv);
     }
 
+    EPoolFormat format;
+    if (!ParsePoolFormat(formatName, format)) {
+        std::cerr << "unknown pool format: " << formatName << std::endl;
+        return 1;
+    }
+
     TPool pool;
-    pool.ReadFromFeatures(featuresPath);
-    pool = pool.InjuredPool(injureFactor, injureOffset);
-    pool.PrintForFeatures(std::cout);
+    if (!pool.Read(featuresPath, threadsCount, format)) {
+        std::cerr << "could not read pool from " << featuresPath << std::endl;
+        return 1;
+    }
+    pool.InjuredView(injureFactor, injureOffset).PrintForFeatures(std::cout);
     return 0;
 }
@@ -1,72 +1,521 @@
 #pragma once
 
 #include "args.h"
+#include "memory_usage.h"
 #include "timer.h"
 
+#include "../lib/fixed_linear_regression.h"
+#include "../lib/fused_solver.h"
 #include "../lib/linear_regression.h"
 #include "../lib/simple_linear_regression.h"
 
+#include "../lib/binary_pool.h"
+#include "../lib/features_pipeline.h"
+#include "../lib/features_reader.h"
 #include "../lib/metrics.h"
 #include "../lib/pool.h"
 
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
 #include <time.h>
 
-template <typename TIteratorType>
-TLinearModel Solve(TIteratorType iterator, const std::string& learningMode) {
-    TLinearModel linearModel;
+struct TLearnOptions {
+    std::string LearningMode = "welford_lr";
+    size_t ThreadsCount = 1;
+    size_t BatchSize = 0;
+    bool FixedSolvers = true;
+    bool FoldStatistics = true;
+
+    double HalfLife = 1e5;
+    size_t WindowSize = 100000;
+
+    bool RidgePath = false;
+    std::string RidgeParameters = "0,1e-4,1e-3,1e-2,0.1,1,10,100,1000";
+
+    void AddOpts(TArgsParser& argsParser) {
+        argsParser.AddHandler("method", &LearningMode, "learning mode, one from: fast_bslr, kahan_bslr, welford_bslr, normalized_welford_bslr, fast_lr, sparse_lr, welford_lr, normalized_welford_lr, online_lr, decayed_welford_lr, window_welford_lr").Optional();
+        argsParser.AddHandler("threads", &ThreadsCount, "learning and features loading threads count").Optional();
+        argsParser.AddHandler("batch", &BatchSize, "instances per batched update for LR methods, 0 to add instances one by one").Optional();
+        argsParser.AddHandler("fixed-solvers", &FixedSolvers, "use LR solvers specialized for the features count on narrow pools, 0 or 1").Optional();
+        argsParser.AddHandler("half-life", &HalfLife, "instances count halving the weight of an instance for decayed_welford_lr").Optional();
+        argsParser.AddHandler("window", &WindowSize, "instances count in the window of window_welford_lr").Optional();
+        argsParser.AddHandler("ridge-path", &RidgePath, "learn LR models for every ridge parameter and choose the best one by cross-validation, 0 or 1").Optional();
+        argsParser.AddHandler("ridge-parameters", &RidgeParameters, "comma-separated ridge regularization parameters for --ridge-path").Optional();
+    }
+
+    // reports the option values no solver can learn with
+    bool Check() const {
+        // a tiny half-life underflows the per-instance decay factor, which the weights are divided by
+        const double decayFactor = std::pow(0.5, 1. / HalfLife);
+        if (!(HalfLife > 0.) || !std::isnormal(decayFactor)) {
+            std::cerr << "half-life has to be positive and large enough for a normal decay factor: " << HalfLife << " gives " << decayFactor << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // the comma-separated non-negative ridge parameters; false if some of them is not a number
+    bool ParseRidgeParameters(std::vector<double>& ridgeParameters) const {
+        ridgeParameters.clear();
+
+        std::stringstream ss(RidgeParameters);
+        std::string parameter;
+        while (std::getline(ss, parameter, ',')) {
+            char* parameterEnd = nullptr;
+            const double ridgeParameter = std::strtod(parameter.c_str(), &parameterEnd);
+            if (parameter.empty() || *parameterEnd || !(ridgeParameter >= 0.) || std::isinf(ridgeParameter)) {
+                return false;
+            }
+            ridgeParameters.push_back(ridgeParameter);
+        }
+
+        return true;
+    }
+
+    // methods depending on the order of the instances, which are learned in a single sequential pass
+    bool IsStreamingMethod() const {
+        return LearningMode == "decayed_welford_lr" || LearningMode == "window_welford_lr";
+    }
+
+    bool HasRidgePath() const {
+        return LearningMode == "fast_lr" || LearningMode == "welford_lr" || LearningMode == "normalized_welford_lr";
+    }
+
+    // the ridge parameters of --ridge-path, reporting the invalid ones; false if there is no path to learn
+    bool PrepareRidgePath(std::vector<double>& ridgeParameters) const {
+        if (!ParseRidgeParameters(ridgeParameters)) {
+            std::cerr << "bad ridge parameters: " << RidgeParameters << std::endl;
+            return false;
+        }
+        if (!HasRidgePath() || ridgeParameters.empty()) {
+            std::cerr << "ridge path needs an LR method and some ridge parameters" << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+template <typename TSolver>
+struct TSolverType {
+    using TType = TSolver;
+};
+
+// calls func(TSolverType<TFixedSolver<featuresCount>>()) if the sequence has a fixed-size solver for the features count, returns false otherwise
+template <template <size_t> class TFixedSolver, typename TFunc, size_t... FixedFeaturesCounts>
+bool ForFixedSolver(const size_t featuresCount, std::index_sequence<FixedFeaturesCounts...>, TFunc& func) {
+    return ((featuresCount == FixedFeaturesCounts && (func(TSolverType<TFixedSolver<FixedFeaturesCounts>>()), true)) || ...);
+}
+
+template <template <size_t> class TFixedSolver, typename TSolver, typename TFunc>
+void ForLRSolver(const TLearnOptions& learnOptions, const size_t featuresCount, TFunc& func) {
+    if (learnOptions.FixedSolvers && learnOptions.BatchSize <= 1 && ForFixedSolver<TFixedSolver>(featuresCount, TFixedFeaturesCounts(), func)) {
+        return;
+    }
+    func(TSolverType<TSolver>());
+}
+
+// calls func(TSolverType<TSolver>()) for the solver chosen by the learning mode and the features count
+template <typename TFunc>
+void ForLearningSolver(const TLearnOptions& learnOptions, const size_t featuresCount, TFunc&& func) {
+    const std::string& learningMode = learnOptions.LearningMode;
+
     if (learningMode == "fast_bslr") {
-        linearModel = Solve<TFastBestSLRSolver>(iterator);
+        func(TSolverType<TFastBestSLRSolver>());
     }
     if (learningMode == "kahan_bslr") {
-        linearModel = Solve<TKahanBestSLRSolver>(iterator);
+        func(TSolverType<TKahanBestSLRSolver>());
     }
     if (learningMode == "welford_bslr") {
-        linearModel = Solve<TWelfordBestSLRSolver>(iterator);
+        func(TSolverType<TWelfordBestSLRSolver>());
     }
     if (learningMode == "normalized_welford_bslr") {
-        linearModel = Solve<TNormalizedWelfordBestSLRSolver>(iterator);
+        func(TSolverType<TNormalizedWelfordBestSLRSolver>());
     }
     if (learningMode == "fast_lr") {
-        linearModel = Solve<TFastLRSolver>(iterator);
+        ForLRSolver<TFixedFastLRSolver, TFastLRSolver>(learnOptions, featuresCount, func);
+    }
+    if (learningMode == "sparse_lr") {
+        func(TSolverType<TSparseLRSolver>());
     }
     if (learningMode == "welford_lr") {
-        linearModel = Solve<TWelfordLRSolver>(iterator);
+        ForLRSolver<TFixedWelfordLRSolver, TWelfordLRSolver>(learnOptions, featuresCount, func);
     }
     if (learningMode == "normalized_welford_lr") {
-        linearModel = Solve<TNormalizedWelfordLRSolver>(iterator);
+        ForLRSolver<TFixedNormalizedWelfordLRSolver, TNormalizedWelfordLRSolver>(learnOptions, featuresCount, func);
+    }
+    if (learningMode == "online_lr") {
+        func(TSolverType<TOnlineLRSolver>());
+    }
+}
+
+template <typename TSolver, typename TIteratorType>
+TLinearModel SolveSequentially(TIteratorType iterator, TSolver solver) {
+    for (; iterator.IsValid(); ++iterator) {
+        solver.Add(iterator->Features, iterator->Goal, iterator->Weight);
     }
+    return solver.Solve();
+}
+
+template <typename TIteratorType>
+TLinearModel Solve(TIteratorType iterator, const TLearnOptions& learnOptions) {
+    if (learnOptions.LearningMode == "decayed_welford_lr") {
+        return SolveSequentially(iterator, TDecayedWelfordLRSolver(learnOptions.HalfLife));
+    }
+    if (learnOptions.LearningMode == "window_welford_lr") {
+        return SolveSequentially(iterator, TWindowWelfordLRSolver(learnOptions.WindowSize));
+    }
+
+    const size_t featuresCount = iterator.IsValid() ? iterator->Features.size() : 0;
+
+    TLinearModel linearModel;
+    ForLearningSolver(learnOptions, featuresCount, [&](auto solverType) {
+        using TSolver = typename decltype(solverType)::TType;
+        linearModel = ParallelSolve<TSolver>(iterator, learnOptions.ThreadsCount, learnOptions.BatchSize);
+    });
     return linearModel;
 }
 
+// models of all the cross-validation folds from a single pass over the pool; false if the learning mode has no solver
+inline bool SolveFolds(const TPoolView& pool, const TPool::TCVIterator& cvIterator, const size_t foldsCount, const TLearnOptions& learnOptions, std::vector<TLinearModel>& linearModels) {
+    bool solved = false;
+    ForLearningSolver(learnOptions, pool.FeaturesCount(), [&](auto solverType) {
+        using TSolver = typename decltype(solverType)::TType;
+        linearModels = SolveFolds<TSolver>(pool, cvIterator.GetInstanceFoldNumbers(), foldsCount, learnOptions.ThreadsCount);
+        solved = true;
+    });
+    return solved;
+}
+
+// the solvers of the learning modes in a single set; false if some mode has no mergeable solver
+inline bool MakeFusedSolver(const std::vector<std::string>& learningModes, const TLearnOptions& learnOptions, const size_t featuresCount, TFusedSolver& fusedSolver) {
+    fusedSolver = TFusedSolver();
+    for (const std::string& learningMode : learningModes) {
+        TLearnOptions modeLearnOptions = learnOptions;
+        modeLearnOptions.LearningMode = learningMode;
+
+        const size_t solversCount = fusedSolver.size();
+        ForLearningSolver(modeLearnOptions, featuresCount, [&](auto solverType) {
+            using TSolver = typename decltype(solverType)::TType;
+            fusedSolver.AddSolver<TSolver>();
+        });
+        if (fusedSolver.size() != solversCount + 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void PrintUnfusedModes(const std::vector<std::string>& learningModes) {
+    std::cerr << "could not learn the modes together:";
+    for (const std::string& learningMode : learningModes) {
+        std::cerr << " " << learningMode;
+    }
+    std::cerr << std::endl;
+}
+
+// models of all the learning modes; the non-streaming ones are learned together in a single pass if there are several of them.
+// Returns false, reporting the modes, if some of them have no solver to be learned together with the others.
+template <typename TIteratorType>
+bool Solve(TIteratorType iterator, const std::vector<std::string>& learningModes, const TLearnOptions& learnOptions, std::vector<TLinearModel>& linearModels) {
+    linearModels.assign(learningModes.size(), TLinearModel());
+
+    std::vector<std::string> fusedModes;
+    std::vector<size_t> fusedModeIndices;
+    for (size_t modeIdx = 0; modeIdx < learningModes.size(); ++modeIdx) {
+        TLearnOptions modeLearnOptions = learnOptions;
+        modeLearnOptions.LearningMode = learningModes[modeIdx];
+        if (learningModes.size() == 1 || modeLearnOptions.IsStreamingMethod()) {
+            linearModels[modeIdx] = Solve(iterator, modeLearnOptions);
+        } else {
+            fusedModes.push_back(learningModes[modeIdx]);
+            fusedModeIndices.push_back(modeIdx);
+        }
+    }
+
+    if (fusedModes.empty()) {
+        return true;
+    }
+
+    TFusedSolver fusedSolver;
+    if (!MakeFusedSolver(fusedModes, learnOptions, iterator.IsValid() ? iterator->Features.size() : 0, fusedSolver)) {
+        PrintUnfusedModes(fusedModes);
+        return false;
+    }
+    for (; iterator.IsValid(); ++iterator) {
+        fusedSolver.Add(iterator->Features, iterator->Goal, iterator->Weight);
+    }
+
+    const std::vector<TLinearModel> fusedModels = fusedSolver.Solve();
+    for (size_t fusedIdx = 0; fusedIdx < fusedModels.size(); ++fusedIdx) {
+        linearModels[fusedModeIndices[fusedIdx]] = fusedModels[fusedIdx];
+    }
+    return true;
+}
+
+// models of every learning mode for every fold, all of them from a single pass over the pool; the modes have to be mergeable.
+// Returns false, reporting the modes, if some of them have no solver to be learned together with the others.
+inline bool SolveFolds(const TPoolView& pool,
+                       const TPool::TCVIterator& cvIterator,
+                       const size_t foldsCount,
+                       const std::vector<std::string>& learningModes,
+                       const TLearnOptions& learnOptions,
+                       std::vector<std::vector<TLinearModel>>& foldModels)
+{
+    foldModels.clear();
+    if (learningModes.size() == 1) {
+        TLearnOptions modeLearnOptions = learnOptions;
+        modeLearnOptions.LearningMode = learningModes.front();
+
+        std::vector<TLinearModel> linearModels;
+        if (!SolveFolds(pool, cvIterator, foldsCount, modeLearnOptions, linearModels)) {
+            std::cerr << "unknown learning mode: " << modeLearnOptions.LearningMode << std::endl;
+            return false;
+        }
+        for (const TLinearModel& linearModel : linearModels) {
+            foldModels.push_back({linearModel});
+        }
+        return true;
+    }
+
+    TFusedSolver fusedSolver;
+    if (!MakeFusedSolver(learningModes, learnOptions, pool.FeaturesCount(), fusedSolver)) {
+        PrintUnfusedModes(learningModes);
+        return false;
+    }
+    foldModels = SolveFolds(pool, cvIterator.GetInstanceFoldNumbers(), foldsCount, learnOptions.ThreadsCount, fusedSolver);
+    return true;
+}
+
+// models for every ridge parameter from a single pass and a single eigendecomposition; empty for the methods without ridge paths
+template <typename TIteratorType>
+std::vector<TLinearModel> SolveRidgePath(TIteratorType iterator, const TLearnOptions& learnOptions, const std::vector<double>& ridgeParameters) {
+    const std::string& learningMode = learnOptions.LearningMode;
+    const size_t threadsCount = learnOptions.ThreadsCount;
+    const size_t batchSize = learnOptions.BatchSize;
+
+    if (learningMode == "fast_lr") {
+        return ParallelAccumulate<TFastLRSolver>(iterator, threadsCount, batchSize).RidgePath(ridgeParameters);
+    }
+    if (learningMode == "welford_lr") {
+        return ParallelAccumulate<TWelfordLRSolver>(iterator, threadsCount, batchSize).RidgePath(ridgeParameters);
+    }
+    if (learningMode == "normalized_welford_lr") {
+        return ParallelAccumulate<TNormalizedWelfordLRSolver>(iterator, threadsCount, batchSize).RidgePath(ridgeParameters);
+    }
+    return {};
+}
+
+struct TRidgePathResult {
+    std::vector<double> RidgeParameters;
+    std::vector<double> MeanDeterminationCoefficients;
+
+    size_t BestIdx = 0;
+};
+
+TRidgePathResult RidgePathCrossValidation(const TPool& pool,
+                                          const size_t foldsCount,
+                                          const size_t runsCount,
+                                          const TLearnOptions& learnOptions,
+                                          const std::vector<double>& ridgeParameters)
+{
+    TRidgePathResult result;
+    result.RidgeParameters = ridgeParameters;
+
+    TPool::TCVIterator learnIterator = pool.LearnIterator(foldsCount);
+    TPool::TCVIterator testIterator = pool.TestIterator(foldsCount);
+
+    std::vector<TMeanCalculator> meanDCCalculators(result.RidgeParameters.size());
+    for (size_t runIdx = 0; runIdx < runsCount; ++runIdx) {
+        learnIterator.ResetShuffle();
+        testIterator.ResetShuffle();
+
+        for (size_t fold = 0; fold < foldsCount; ++fold) {
+            learnIterator.SetTestFold(fold);
+            testIterator.SetTestFold(fold);
+
+            const std::vector<TLinearModel> linearModels = SolveRidgePath(learnIterator, learnOptions, result.RidgeParameters);
+            for (size_t modelIdx = 0; modelIdx < linearModels.size(); ++modelIdx) {
+                meanDCCalculators[modelIdx].Add(TRegressionMetricsCalculator::Build(testIterator, linearModels[modelIdx]).DeterminationCoefficient());
+            }
+        }
+    }
+
+    for (size_t parameterIdx = 0; parameterIdx < meanDCCalculators.size(); ++parameterIdx) {
+        result.MeanDeterminationCoefficients.push_back(meanDCCalculators[parameterIdx].GetMean());
+        if (result.MeanDeterminationCoefficients[parameterIdx] > result.MeanDeterminationCoefficients[result.BestIdx]) {
+            result.BestIdx = parameterIdx;
+        }
+    }
+
+    return result;
+}
+
+inline void PrintStreamStats(const TFeaturesStreamIterator&) {
+}
+
+inline void PrintStreamStats(const TFeaturesPipelineIterator& iterator) {
+    for (const TPipelineStageStats& stats : iterator.GetPipeline().GetStats()) {
+        std::cout << stats.Name << ":\t"
+                  << "items: " << stats.ItemsCount << "\t"
+                  << "input stalls: " << stats.InputStalls.Count << " (" << stats.InputStalls.Seconds << "s)";
+        if (stats.OutputCapacity) {
+            std::cout << "\t" << "output stalls: " << stats.OutputStalls.Count << " (" << stats.OutputStalls.Seconds << "s)\t"
+                      << "output queues occupancy: " << stats.MeanOutputOccupancy << " of " << stats.OutputCapacity;
+        }
+        std::cout << std::endl;
+    }
+}
+
+template <typename TIterator>
+TLinearModel SolveStream(TIterator learnIterator, const TLearnOptions& learnOptions) {
+    TTimer timer("model learned in");
+    const TLinearModel linearModel = Solve(learnIterator, learnOptions);
+    std::cout << "instances streamed: " << learnIterator.GetInstanceIdx() + 1 << ", "
+              << "stream throughput: " << learnIterator.GetBytesRead() / 1e6 / timer.GetSecondsPassed() << " MB/s" << std::endl;
+    PrintStreamStats(learnIterator);
+    return linearModel;
+}
+
+// the streams stop at a row wider than the first one, which the pool in memory would widen to
+template <typename TIterator>
+bool CheckStreamWidth(const TIterator& iterator) {
+    if (!iterator.GetWideInstanceFeaturesCount()) {
+        return true;
+    }
+    std::cerr << "instance #" << iterator.GetInstanceIdx() + 1 << " has " << iterator.GetWideInstanceFeaturesCount()
+              << " features, more than the streamed rows; set --features-count to the widest row" << std::endl;
+    return false;
+}
+
+// learns in a single pass over the instances read from the file one by one, the pool is never kept in memory;
+// the parallel and the batched accumulation need the whole pool, so the stream is learned on a single thread,
+// while the reading and the parsing may run on the threads of a pipeline
+int DoStreamingLearn(const std::string& featuresPath,
+                     const EPoolFormat format,
+                     const size_t featuresCount,
+                     const size_t parsersCount,
+                     const std::string& modelPath,
+                     TLearnOptions learnOptions)
+{
+    if (learnOptions.RidgePath) {
+        std::cerr << "ridge path cross-validation needs the pool in memory" << std::endl;
+        return 1;
+    }
+    learnOptions.ThreadsCount = 1;
+    learnOptions.BatchSize = 0;
+
+    TLinearModel linearModel;
+    if (parsersCount) {
+        const TFeaturesPipelineIterator pipelineIterator(featuresPath, format, parsersCount, featuresCount);
+        if (!pipelineIterator.IsOpen()) {
+            std::cerr << "could not read pool from " << featuresPath << std::endl;
+            return 1;
+        }
+        linearModel = SolveStream(pipelineIterator, learnOptions);
+        if (!CheckStreamWidth(pipelineIterator)) {
+            return 1;
+        }
+    } else {
+        const TFeaturesStreamIterator streamIterator(featuresPath, format, featuresCount);
+        if (!streamIterator.IsOpen()) {
+            std::cerr << "could not read pool from " << featuresPath << std::endl;
+            return 1;
+        }
+        linearModel = SolveStream(streamIterator, learnOptions);
+        if (!CheckStreamWidth(streamIterator)) {
+            return 1;
+        }
+    }
+    std::cout << "peak RSS: " << PeakResidentSetSize() / 1e6 << " MB" << std::endl;
+
+    if (!modelPath.empty()) {
+        linearModel.SaveToFile(modelPath);
+    }
+
+    // the standard input cannot be read twice
+    if (featuresPath != "-") {
+        TRegressionMetricsCalculator rmc = TRegressionMetricsCalculator::Build(TFeaturesStreamIterator(featuresPath, format, featuresCount), linearModel);
+        std::cout << "learn rmse: " << rmc.RMSE() << std::endl;
+        std::cout << "learn R^2:  " << rmc.DeterminationCoefficient() << std::endl;
+    }
+
+    return 0;
+}
+
 int DoLearn(int argc, const char** argv) {
     std::string featuresPath;
+    std::string formatName = "auto";
     std::string modelPath;
+    bool streaming = false;
+    size_t featuresCount = 0;
+    size_t parsersCount = 0;
+    size_t foldsCount = 5;
 
-    std::string learningMode = "welford_lr";
+    TLearnOptions learnOptions;
 
     {
         TArgsParser argsParser;
 
-        argsParser.AddHandler("features", &featuresPath, "features file path").Required();
+        argsParser.AddHandler("features", &featuresPath, "features or binary pool file path").Required();
+        argsParser.AddHandler("format", &formatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
 
         argsParser.AddHandler("model", &modelPath, "resulting model path").Optional();
-        argsParser.AddHandler("method", &learningMode, "learning mode, one from: fast_bslr, kahan_bslr, welford_bslr, fast_lr, welford_lr, normalized_welford_lr").Optional();
+        argsParser.AddHandler("stream", &streaming, "learn in a single pass without keeping the pool in memory, - reading the standard input, 0 or 1").Optional();
+        argsParser.AddHandler("features-count", &featuresCount, "features count of the streamed instances, the first one's if 0").Optional();
+        argsParser.AddHandler("parsers", &parsersCount, "parsing threads of the stream pipeline, 0 to read and parse on the learning thread").Optional();
+        learnOptions.AddOpts(argsParser);
+        argsParser.AddHandler("folds", &foldsCount, "cross-validation folds count choosing the ridge parameter of --ridge-path").Optional();
 
         argsParser.DoParse(argc, argv);
     }
+    if (!learnOptions.Check()) {
+        return 1;
+    }
+
+    EPoolFormat format;
+    if (!ParsePoolFormat(formatName, format)) {
+        std::cerr << "unknown pool format: " << formatName << std::endl;
+        return 1;
+    }
+
+    // binary pools are mapped rather than read, so they take no memory besides the page cache anyway
+    const bool isBinaryPool = format == PF_BINARY || (format == PF_AUTO && featuresPath != "-" && NBinaryPool::IsBinaryPool(featuresPath));
+    if (streaming && !isBinaryPool) {
+        return DoStreamingLearn(featuresPath, format, featuresCount, parsersCount, modelPath, learnOptions);
+    }
 
     TPool pool;
     {
         TTimer timer("pool read in");
-        pool.ReadFromFeatures(featuresPath);
+        const size_t bytesRead = pool.Read(featuresPath, learnOptions.ThreadsCount, format);
+        if (!bytesRead) {
+            std::cerr << "could not read pool from " << featuresPath << std::endl;
+            return 1;
+        }
+        std::cout << "parse throughput: " << bytesRead / 1e6 / timer.GetSecondsPassed() << " MB/s" << std::endl;
     }
 
     TPool::TSimpleIterator learnIterator(pool);
     TLinearModel linearModel;
-    {
+    if (learnOptions.RidgePath) {
+        std::vector<double> ridgeParameters;
+        if (!learnOptions.PrepareRidgePath(ridgeParameters)) {
+            return 1;
+        }
+
+        TTimer timer("model learned in");
+
+        const TRidgePathResult ridgePathResult = RidgePathCrossValidation(pool, foldsCount, 1, learnOptions, ridgeParameters);
+        const double bestRidgeParameter = ridgePathResult.RidgeParameters[ridgePathResult.BestIdx];
+        linearModel = SolveRidgePath(learnIterator, learnOptions, {bestRidgeParameter}).front();
+
+        std::cout << "CV-best ridge parameter: " << bestRidgeParameter << " (CV R^2 = " << ridgePathResult.MeanDeterminationCoefficients[ridgePathResult.BestIdx] << ")" << std::endl;
+    } else {
         TTimer timer("model learned in");
-        linearModel = Solve(learnIterator, learningMode);
+        linearModel = Solve(learnIterator, learnOptions);
     }
+    std::cout << "peak RSS: " << PeakResidentSetSize() / 1e6 << " MB" << std::endl;
 
     if (!modelPath.empty()) {
         linearModel.SaveToFile(modelPath);
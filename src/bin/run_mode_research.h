@@ -4,11 +4,18 @@
 #include "run_mode_cross_validation.h"
 
 #include "../lib/pool.h"
+#include "../lib/thread_pool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <numeric>
 
 struct TResearchOptions {
     std::string FeaturesPath;
+    size_t ThreadsCount = 1;
+    std::string FormatName = "auto";
 
     size_t FoldsCount = 5;
     size_t RunsCount = 1;
@@ -16,14 +23,19 @@ struct TResearchOptions {
     size_t TasksCount = 5;
     double DegradeFactor = 0.1;
 
+    bool Fused = false;
+
     void AddOpts(TArgsParser& argsParser) {
-        argsParser.AddHandler("features", &FeaturesPath, "features file path").Required();
+        argsParser.AddHandler("features", &FeaturesPath, "features or binary pool file path").Required();
+        argsParser.AddHandler("threads", &ThreadsCount, "features loading and research threads count").Optional();
+        argsParser.AddHandler("format", &FormatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
 
         argsParser.AddHandler("tasks", &TasksCount, "number of research tasks").Optional();
         argsParser.AddHandler("degrade", &DegradeFactor, "task-to-task degrade level").Optional();
 
         argsParser.AddHandler("folds", &FoldsCount, "cross-validation folds count").Optional();
         argsParser.AddHandler("runs", &RunsCount, "cross-validation runs count").Optional();
+        argsParser.AddHandler("fused", &Fused, "learn all the methods in a single pass over the pool, sharing the learning time, 0 or 1").Optional();
     }
 
     std::vector<std::pair<double, double>> GetInjureFactorsAndOffsets() const {
@@ -45,60 +57,156 @@ struct TResearchOptions {
 int DoResearchMethods(const TResearchOptions& researchOptions,
                       const std::vector<std::string>& learningModes)
 {
+    EPoolFormat format;
+    if (!ParsePoolFormat(researchOptions.FormatName, format)) {
+        std::cerr << "unknown pool format: " << researchOptions.FormatName << std::endl;
+        return 1;
+    }
+
     TPool pool;
-    pool.ReadFromFeatures(researchOptions.FeaturesPath);
+    if (!pool.Read(researchOptions.FeaturesPath, researchOptions.ThreadsCount, format)) {
+        std::cerr << "could not read pool from " << researchOptions.FeaturesPath << std::endl;
+        return 1;
+    }
 
     const std::vector<std::pair<double, double>> injureFactorsAndOffsets = researchOptions.GetInjureFactorsAndOffsets();
+    const size_t tasksCount = injureFactorsAndOffsets.size();
+
+    // the methods learned together in a single pass make a group sharing the learning time
+    std::vector<std::vector<std::string>> methodGroups;
+    if (researchOptions.Fused) {
+        methodGroups.push_back(learningModes);
+    } else {
+        for (const std::string& learningMode : learningModes) {
+            methodGroups.push_back({learningMode});
+        }
+    }
+    const size_t groupsCount = methodGroups.size();
 
-    std::vector<std::vector<double>> scores(learningModes.size());
-    std::vector<double> fullLearnTime(learningModes.size());
+    // the learning jobs of a group on a task: their CPU times and their spans from the start of the research
+    struct TLearnJobTimes {
+        std::vector<double> CPUTimes;
+        std::vector<double> Starts;
+        std::vector<double> Finishes;
+    };
 
+    // the tasks share the pool read, each of them seeing it through its injure transform
+    std::vector<TPoolView> injuredPools;
     for (const std::pair<double, double>& injureFactorAndOffset : injureFactorsAndOffsets) {
-        const double injureFactor = injureFactorAndOffset.first;
-        const double injureOffset = injureFactorAndOffset.second;
-
-        const TPool injuredPool = pool.InjuredPool(injureFactor, injureOffset);
-
-        std::cerr << "injure factor: " << injureFactor << std::endl;
-        std::cerr << "injure offset: " << injureOffset << std::endl;
-
-        for (size_t methodIdx = 0; methodIdx < learningModes.size(); ++methodIdx) {
-            const TCrossValidationResult cvResult = CrossValidation(injuredPool, researchOptions.FoldsCount, researchOptions.RunsCount, learningModes[methodIdx], "", false);
-
-            std::stringstream ss;
-            ss << "   ";
-            ss << learningModes[methodIdx];
-            while (ss.str().size() < 50) {
-                ss << " ";
-            }
-
-            ss.precision(5);
-
-            ss << "time: " << cvResult.LearningTimeInSeconds << "    "
-               << "R^2: " << cvResult.MeanDeterminationCoefficient;
-
-            std::cerr << ss.str() << std::endl;
-
-            scores[methodIdx].push_back(cvResult.MeanDeterminationCoefficient);
-            fullLearnTime[methodIdx] += cvResult.LearningTimeInSeconds;
+        injuredPools.push_back(pool.InjuredView(injureFactorAndOffset.first, injureFactorAndOffset.second));
+    }
+    // the folds are the same for all the tasks and the methods, so their partitions are shared
+    const std::vector<TPool::TCVIterator> runIterators = TCrossValidationJobs::RunIterators(pool, researchOptions.FoldsCount, researchOptions.RunsCount);
+    std::vector<std::unique_ptr<TCrossValidationJobs>> cvJobs(tasksCount * groupsCount);
+    std::vector<TLearnJobTimes> learnJobTimes(tasksCount * groupsCount);
+
+    // A task job sets up the cross-validations of every group and adds their learning jobs, each of which adds the evaluation
+    // jobs of the folds it has learned; the jobs learn on a single thread each, and the workers steal them
+    // from each other, so the cheap methods do not wait behind the expensive ones.
+    TTimer researchTimer;
+    size_t stealsCount = 0;
+    std::atomic<bool> learned{true};
+    {
+        TWorkStealingPool workers(researchOptions.ThreadsCount);
+        for (size_t taskIdx = 0; taskIdx < tasksCount; ++taskIdx) {
+            workers.Add([&, taskIdx]() {
+                for (size_t groupIdx = 0; groupIdx < groupsCount; ++groupIdx) {
+                    TLearnOptions learnOptions;
+                    learnOptions.LearningMode = methodGroups[groupIdx].front();
+
+                    const size_t studyIdx = taskIdx * groupsCount + groupIdx;
+                    cvJobs[studyIdx] = std::make_unique<TCrossValidationJobs>(injuredPools[taskIdx], runIterators, learnOptions, methodGroups[groupIdx]);
+                    TCrossValidationJobs* studyJobs = cvJobs[studyIdx].get();
+
+                    TLearnJobTimes* times = &learnJobTimes[studyIdx];
+                    times->CPUTimes.resize(studyJobs->LearnJobsCount());
+                    times->Starts.resize(studyJobs->LearnJobsCount());
+                    times->Finishes.resize(studyJobs->LearnJobsCount());
+
+                    for (size_t learnJobIdx = 0; learnJobIdx < studyJobs->LearnJobsCount(); ++learnJobIdx) {
+                        workers.Add([&workers, &researchTimer, &learned, studyJobs, times, learnJobIdx]() {
+                            times->Starts[learnJobIdx] = researchTimer.GetSecondsPassed();
+                            TThreadCPUTimer cpuTimer;
+                            if (!learned || !studyJobs->Learn(learnJobIdx)) {
+                                learned = false;
+                                return;
+                            }
+                            times->CPUTimes[learnJobIdx] = cpuTimer.GetSecondsPassed();
+                            times->Finishes[learnJobIdx] = researchTimer.GetSecondsPassed();
+
+                            const std::pair<size_t, size_t> evaluationJobs = studyJobs->LearnedEvaluationJobs(learnJobIdx);
+                            for (size_t evaluationJobIdx = evaluationJobs.first; evaluationJobIdx < evaluationJobs.second; ++evaluationJobIdx) {
+                                workers.Add([studyJobs, evaluationJobIdx]() {
+                                    studyJobs->Evaluate(evaluationJobIdx);
+                                });
+                            }
+                        });
+                    }
+                }
+            });
         }
-        std::cerr << std::endl;
+        workers.Wait();
+        stealsCount = workers.GetStealsCount();
+    }
+    if (!learned) {
+        return 1;
     }
+    const double researchTime = researchTimer.GetSecondsPassed();
 
-    std::cerr << "full learning time:" << std::endl;
-    for (size_t methodIdx = 0; methodIdx < learningModes.size(); ++methodIdx) {
+    const auto printRow = [](const std::string& name, const std::string& values) {
         std::stringstream ss;
         ss << "   ";
-        ss << learningModes[methodIdx];
+        ss << name;
         while (ss.str().size() < 50) {
             ss << " ";
         }
-        ss.precision(5);
+        std::cerr << ss.str() << values << std::endl;
+    };
+
+    std::vector<double> fullLearnTime(groupsCount);
+    std::vector<double> fullLearnWallTime(groupsCount);
+
+    for (size_t taskIdx = 0; taskIdx < tasksCount; ++taskIdx) {
+        std::cerr << "injure factor: " << injureFactorsAndOffsets[taskIdx].first << std::endl;
+        std::cerr << "injure offset: " << injureFactorsAndOffsets[taskIdx].second << std::endl;
+
+        for (size_t groupIdx = 0; groupIdx < groupsCount; ++groupIdx) {
+            const size_t studyIdx = taskIdx * groupsCount + groupIdx;
+            const TLearnJobTimes& times = learnJobTimes[studyIdx];
+
+            const double learningTime = std::accumulate(times.CPUTimes.begin(), times.CPUTimes.end(), 0.);
+            const double learningWallTime = times.Starts.empty() ? 0. : *std::max_element(times.Finishes.begin(), times.Finishes.end()) - *std::min_element(times.Starts.begin(), times.Starts.end());
+
+            std::stringstream timesSS;
+            timesSS.precision(5);
+            timesSS << "time: " << learningTime << "    "
+                    << "wall: " << learningWallTime;
+
+            const std::vector<std::string>& groupModes = methodGroups[groupIdx];
+            for (size_t modeIdx = 0; modeIdx < groupModes.size(); ++modeIdx) {
+                std::stringstream ss;
+                ss.precision(5);
+                ss << (groupModes.size() == 1 ? timesSS.str() + "    " : "") << "R^2: " << cvJobs[studyIdx]->MeanDeterminationCoefficient(modeIdx, "", false);
+                printRow(groupModes[modeIdx], ss.str());
+            }
+            if (groupModes.size() > 1) {
+                printRow("all methods fused", timesSS.str());
+            }
 
-        ss << fullLearnTime[methodIdx] << "s";
+            fullLearnTime[groupIdx] += learningTime;
+            fullLearnWallTime[groupIdx] += learningWallTime;
+        }
+        std::cerr << std::endl;
+    }
 
-        std::cerr << ss.str() << std::endl;
+    std::cerr << "full learning time:" << std::endl;
+    for (size_t groupIdx = 0; groupIdx < groupsCount; ++groupIdx) {
+        std::stringstream ss;
+        ss.precision(5);
+        ss << fullLearnTime[groupIdx] << "s, wall " << fullLearnWallTime[groupIdx] << "s";
+        printRow(methodGroups[groupIdx].size() == 1 ? methodGroups[groupIdx].front() : "all methods fused", ss.str());
     }
+    std::cerr << "research done in " << researchTime << "s on " << researchOptions.ThreadsCount << " threads, " << stealsCount << " jobs stolen" << std::endl;
 
     return 0;
 }
@@ -1,13 +1,28 @@
 #include "run_mode_tests.h"
 
+#include "../lib/binary_pool.h"
+#include "../lib/fixed_linear_regression.h"
+#include "../lib/fused_solver.h"
+#include "../lib/eigen_decomposition.h"
+#include "../lib/features_pipeline.h"
+#include "../lib/features_reader.h"
+#include "../lib/ldl_decomposition.h"
 #include "../lib/linear_regression.h"
 #include "../lib/simple_linear_regression.h"
 
 #include "../lib/metrics.h"
 #include "../lib/pool.h"
+#include "../lib/thread_pool.h"
+#include "../lib/vector_kernels.h"
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
 #include <map>
+#include <sstream>
 #include <unordered_set>
 
 namespace {
@@ -22,6 +37,8 @@ namespace {
         return {1., -2., 3., 0., 3., 1., 8., 0.1, -0.1, 0., -50.};
     }
 
+    constexpr size_t SampleFeaturesCount = 11;
+
     TPool MakeRandomPool() {
         std::mt19937 mersenne;
         std::normal_distribution<double> randGen;
@@ -67,6 +84,29 @@ namespace {
             ++errorsCount;
         }
 
+        // the transformed features live in the buffer of the iterator, the copies have to build their own views
+        const TPoolView injuredView = pool.InjuredView(2., 1.);
+        TPool::TSimpleIterator sourceIterator = injuredView.Iterator();
+        TPool::TCVIterator sourceCVIterator = injuredView.TestIterator(2);
+        sourceCVIterator.SetTestFold(0);
+        const double firstFeature = sourceIterator->Features[0];
+        const double firstCVFeature = sourceCVIterator->Features[0];
+
+        TPool::TSimpleIterator copyIterator(sourceIterator);
+        TPool::TCVIterator copyCVIterator(sourceCVIterator);
+        TPool::TSimpleIterator assignedIterator = injuredView.Iterator();
+        assignedIterator = sourceIterator;
+        ++sourceIterator;
+        ++sourceCVIterator;
+        if (sourceIterator->Features[0] == firstFeature || sourceCVIterator->Features[0] == firstCVFeature) {
+            std::cerr << "got iterators error: the moved iterators keep the features of the first instance" << std::endl;
+            ++errorsCount;
+        }
+        if (copyIterator->Features[0] != firstFeature || assignedIterator->Features[0] != firstFeature || copyCVIterator->Features[0] != firstCVFeature) {
+            std::cerr << "got iterators error: a copy of an iterator sees the features of the source" << std::endl;
+            ++errorsCount;
+        }
+
         std::cout << "iterator errors: " << errorsCount << std::endl;
         return errorsCount;
     }
@@ -89,11 +129,26 @@ namespace {
             std::unordered_set<size_t>& currentLearnIndexes = learnIndexes[fold];
             std::unordered_set<size_t>& currentTestIndexes = testIndexes[fold];
 
+            // the iterators keep the order of the pool
+            size_t lastLearnIdx = 0;
             for (; learnIterator.IsValid(); ++learnIterator) {
-                currentLearnIndexes.insert(learnIterator.GetInstanceIdx());
+                if (!currentLearnIndexes.empty() && learnIterator.GetInstanceIdx() <= lastLearnIdx) {
+                    std::cerr << "got iterators error: learn instance " << learnIterator.GetInstanceIdx() << " comes after " << lastLearnIdx << std::endl;
+                    ++errorsCount;
+                }
+                if (learnIterator.GetInstanceFoldNumbers()[learnIterator.GetInstanceIdx()] == fold) {
+                    std::cerr << "got iterators error: learn instance " << learnIterator.GetInstanceIdx() << " is in test fold " << fold << std::endl;
+                    ++errorsCount;
+                }
+                lastLearnIdx = learnIterator.GetInstanceIdx();
+                currentLearnIndexes.insert(lastLearnIdx);
             }
             for (; testIterator.IsValid(); ++testIterator) {
                 currentTestIndexes.insert(testIterator.GetInstanceIdx());
+                if (testIterator.GetFoldInstances(fold)[currentTestIndexes.size() - 1] != testIterator.GetInstanceIdx()) {
+                    std::cerr << "got iterators error: test instance " << testIterator.GetInstanceIdx() << " is out of the order of fold " << fold << std::endl;
+                    ++errorsCount;
+                }
                 if (currentLearnIndexes.find(testIterator.GetInstanceIdx()) != currentLearnIndexes.end()) {
                     std::cerr << "got iterators error: test instance " << testIterator.GetInstanceIdx() << " is in learn set" << std::endl;
                     ++errorsCount;
@@ -120,6 +175,66 @@ namespace {
             ++errorsCount;
         }
 
+        // the copies share the partition until one of them is reshuffled
+        TPool::TCVIterator learnIteratorCopy = learnIterator;
+        if (&learnIteratorCopy.GetInstanceFoldNumbers() != &learnIterator.GetInstanceFoldNumbers() ||
+            &learnIterator.TestSide().GetInstanceFoldNumbers() != &learnIterator.GetInstanceFoldNumbers())
+        {
+            std::cerr << "got iterators error: the copy of the iterator does not share the fold partition" << std::endl;
+            ++errorsCount;
+        }
+        const std::vector<size_t> instanceFoldNumbers = learnIterator.GetInstanceFoldNumbers();
+        learnIteratorCopy.ResetShuffle();
+        if (learnIterator.GetInstanceFoldNumbers() != instanceFoldNumbers) {
+            std::cerr << "got iterators error: reshuffling the copy of the iterator changed the original" << std::endl;
+            ++errorsCount;
+        }
+
+        // a seeded shuffle does not depend on the shuffles before it
+        TPool::TCVIterator seededIterator = pool.LearnIterator(foldsCount);
+        seededIterator.ResetShuffle(7);
+        learnIteratorCopy.ResetShuffle(7);
+        if (seededIterator.GetInstanceFoldNumbers() != learnIteratorCopy.GetInstanceFoldNumbers()) {
+            std::cerr << "got iterators error: the folds of the same seed differ" << std::endl;
+            ++errorsCount;
+        }
+
+        for (const size_t threadsCount : {1, 3, 16}) {
+            std::vector<size_t> jobRuns(100);
+            ParallelFor(jobRuns.size(), threadsCount, [&jobRuns](const size_t jobIdx) {
+                ++jobRuns[jobIdx];
+            });
+            if (std::count(jobRuns.begin(), jobRuns.end(), 1) != (long)jobRuns.size()) {
+                std::cerr << "got parallel for error: not every job is run once on " << threadsCount << " threads" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // the jobs adding jobs of their own, like the research tasks do
+        for (const size_t threadsCount : {1, 4}) {
+            std::vector<std::atomic<size_t>> jobRuns(10 * 11);
+            {
+                TWorkStealingPool workers(threadsCount);
+                for (size_t parentIdx = 0; parentIdx < 10; ++parentIdx) {
+                    workers.Add([&workers, &jobRuns, parentIdx]() {
+                        ++jobRuns[parentIdx * 11];
+                        for (size_t childIdx = 1; childIdx <= 10; ++childIdx) {
+                            workers.Add([&jobRuns, parentIdx, childIdx]() {
+                                ++jobRuns[parentIdx * 11 + childIdx];
+                            });
+                        }
+                    });
+                }
+                workers.Wait();
+            }
+            for (size_t jobIdx = 0; jobIdx < jobRuns.size(); ++jobIdx) {
+                if (jobRuns[jobIdx] != 1) {
+                    std::cerr << "got work-stealing pool error: job " << jobIdx << " is run " << jobRuns[jobIdx] << " times on " << threadsCount << " threads" << std::endl;
+                    ++errorsCount;
+                }
+            }
+        }
+
         std::cout << "cv iterator errors: " << errorsCount << std::endl;
 
         return errorsCount;
@@ -206,36 +321,1375 @@ namespace {
         return errorsCount;
     }
 
-    size_t DoTestLRModels(const TPool& pool) {
+    template <typename TSolver>
+    size_t CheckParallelModel(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        TPool::TSimpleIterator learnIterator = pool.Iterator();
+
+        double serialSSE = 1e25;
+        const TLinearModel serialModel = Solve<TSolver>(learnIterator, &serialSSE);
+
+        const std::vector<std::pair<size_t, size_t>> threadsAndBatchSizes = {{2, 0}, {3, 0}, {7, 0}, {1, 16}, {1, 100}, {3, 64}};
+
+        size_t errorsCount = 0;
+        for (const std::pair<size_t, size_t>& threadsAndBatchSize : threadsAndBatchSizes) {
+            const size_t threadsCount = threadsAndBatchSize.first;
+            const size_t batchSize = threadsAndBatchSize.second;
+
+            double parallelSSE = 1e25;
+            const TLinearModel parallelModel = ParallelSolve<TSolver>(learnIterator, threadsCount, batchSize, &parallelSSE);
+
+            bool modelsAreSimilar = DoublesAreQuiteSimilar(parallelModel.Intercept, serialModel.Intercept);
+            for (size_t fIdx = 0; fIdx < serialModel.Coefficients.size(); ++fIdx) {
+                modelsAreSimilar = modelsAreSimilar && DoublesAreQuiteSimilar(parallelModel.Coefficients[fIdx], serialModel.Coefficients[fIdx]);
+            }
+            if (!modelsAreSimilar) {
+                std::cerr << TSolver::Name() << " model on " << threadsCount << " threads with batch " << batchSize << " differs from the serial one" << std::endl;
+                ++errorsCount;
+            }
+            if (!DoublesAreQuiteSimilar(sqrt(parallelSSE / pool.size()), sqrt(serialSSE / pool.size()))) {
+                std::cerr << TSolver::Name() << " sse on " << threadsCount << " threads with batch " << batchSize << " differs from the serial one" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        ++testCounters[TSolver::Name()];
+
+        return errorsCount;
+    }
+
+    template <typename TSolver>
+    size_t CheckFoldModels(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        const size_t foldsCount = 5;
+        TPool::TCVIterator learnIterator = pool.LearnIterator(foldsCount);
+
+        size_t errorsCount = 0;
+        for (const size_t threadsCount : {1, 3}) {
+            const std::vector<TLinearModel> foldModels = SolveFolds<TSolver>(pool, learnIterator.GetInstanceFoldNumbers(), foldsCount, threadsCount);
+            for (size_t fold = 0; fold < foldsCount; ++fold) {
+                learnIterator.SetTestFold(fold);
+                const TLinearModel model = Solve<TSolver>(learnIterator);
+
+                bool modelsAreSimilar = DoublesAreQuiteSimilar(foldModels[fold].Intercept, model.Intercept);
+                for (size_t fIdx = 0; fIdx < model.Coefficients.size(); ++fIdx) {
+                    modelsAreSimilar = modelsAreSimilar && DoublesAreQuiteSimilar(foldModels[fold].Coefficients[fIdx], model.Coefficients[fIdx]);
+                }
+                if (!modelsAreSimilar) {
+                    std::cerr << TSolver::Name() << " model of fold #" << fold << " learned from fold statistics on " << threadsCount << " threads differs from the directly learned one" << std::endl;
+                    ++errorsCount;
+                }
+            }
+        }
+
+        ++testCounters[TSolver::Name()];
+
+        return errorsCount;
+    }
+
+    template <typename TSolver>
+    size_t CheckLeaveOneOut(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        const TRegressionMetricsCalculator rmc = LeaveOneOutMetrics<TSolver>(pool);
+
+        TRegressionMetricsCalculator referenceRMC;
+        TPool::TCVIterator learnIterator = pool.LearnIterator(pool.size());
+        TPool::TCVIterator testIterator = pool.TestIterator(pool.size());
+        for (size_t fold = 0; fold < pool.size(); ++fold) {
+            learnIterator.SetTestFold(fold);
+            testIterator.SetTestFold(fold);
+
+            const TLinearModel model = Solve<TSolver>(learnIterator);
+            referenceRMC.Add(model.Prediction(*testIterator), testIterator->Goal, testIterator->Weight);
+        }
+
+        size_t errorsCount = 0;
+        if (!DoublesAreQuiteSimilar(rmc.RMSE(), referenceRMC.RMSE())) {
+            std::cerr << TSolver::Name() << " closed-form LOO rmse " << rmc.RMSE() << " differs from the explicit one " << referenceRMC.RMSE() << std::endl;
+            ++errorsCount;
+        }
+
+        // a feature taking a value on a single instance fits it exactly, so its leverage is one
+        TPool indicatorPool;
+        for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+            TInstance instance = TInstance::FromView(pool[instanceIdx]);
+            instance.Features.push_back(instanceIdx ? 0. : 1.);
+            indicatorPool.push_back(instance);
+        }
+        size_t skippedCount = 0;
+        const TRegressionMetricsCalculator indicatorRMC = LeaveOneOutMetrics<TSolver>(indicatorPool, 1, 0, &skippedCount);
+        if (skippedCount != 1 || !std::isfinite(indicatorRMC.RMSE())) {
+            std::cerr << TSolver::Name() << " closed-form LOO skips " << skippedCount << " instances instead of the one of leverage 1, rmse " << indicatorRMC.RMSE() << std::endl;
+            ++errorsCount;
+        }
+
+        ++testCounters[TSolver::Name()];
+
+        return errorsCount;
+    }
+
+    size_t CheckIfModelsAreSimilar(const TLinearModel& present, const TLinearModel& target, const std::string& description) {
+        bool modelsAreSimilar = DoublesAreQuiteSimilar(present.Intercept, target.Intercept);
+        for (size_t fIdx = 0; fIdx < target.Coefficients.size(); ++fIdx) {
+            modelsAreSimilar = modelsAreSimilar && DoublesAreQuiteSimilar(present.Coefficients[fIdx], target.Coefficients[fIdx]);
+        }
+        if (!modelsAreSimilar) {
+            std::cerr << description << std::endl;
+        }
+        return modelsAreSimilar ? 0 : 1;
+    }
+
+    size_t CheckFusedSolver(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        size_t errorsCount = 0;
+
+        TFusedSolver emptySolver;
+        emptySolver.AddSolver<TFastBestSLRSolver>();
+        emptySolver.AddSolver<TFastLRSolver>();
+        emptySolver.AddSolver<TWelfordLRSolver>();
+
+        TFusedSolver fusedSolver = emptySolver;
+        TFusedSolver firstHalfSolver = emptySolver;
+        TFusedSolver secondHalfSolver = emptySolver;
+        TFastLRSolver firstHalfFastSolver;
+        for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+            const TInstanceView instance = pool[instanceIdx];
+            fusedSolver.Add(instance.Features, instance.Goal, instance.Weight);
+            if (instanceIdx < pool.size() / 2) {
+                firstHalfSolver.Add(instance.Features, instance.Goal, instance.Weight);
+                firstHalfFastSolver.Add(instance.Features, instance.Goal, instance.Weight);
+            } else {
+                secondHalfSolver.Add(instance.Features, instance.Goal, instance.Weight);
+            }
+        }
+
+        // the merge goes to a copy, leaving the solvers of the source one as they are
+        TFusedSolver mergedSolver = firstHalfSolver;
+        mergedSolver.Merge(secondHalfSolver);
+
+        const std::vector<TLinearModel> models = {
+            Solve<TFastBestSLRSolver>(pool.Iterator()),
+            Solve<TFastLRSolver>(pool.Iterator()),
+            Solve<TWelfordLRSolver>(pool.Iterator()),
+        };
+        const std::vector<TLinearModel> fusedModels = fusedSolver.Solve();
+        const std::vector<TLinearModel> mergedModels = mergedSolver.Solve();
+        for (size_t modelIdx = 0; modelIdx < models.size(); ++modelIdx) {
+            errorsCount += CheckIfModelsAreSimilar(fusedModels[modelIdx], models[modelIdx], "fused solver model #" + std::to_string(modelIdx) + " differs from the one learned alone");
+            errorsCount += CheckIfModelsAreSimilar(mergedModels[modelIdx], models[modelIdx], "merged fused solver model #" + std::to_string(modelIdx) + " differs from the one learned alone");
+        }
+        errorsCount += CheckIfModelsAreSimilar(firstHalfSolver.Solve()[1], firstHalfFastSolver.Solve(), "fused solver is changed by merging into its copy");
+
+        const size_t foldsCount = 5;
+        TPool::TCVIterator learnIterator = pool.LearnIterator(foldsCount);
+        for (const size_t threadsCount : {1, 3}) {
+            const std::vector<std::vector<TLinearModel>> fusedFoldModels = SolveFolds(pool, learnIterator.GetInstanceFoldNumbers(), foldsCount, threadsCount, emptySolver);
+            const std::vector<std::vector<TLinearModel>> foldModels = {
+                SolveFolds<TFastBestSLRSolver>(pool, learnIterator.GetInstanceFoldNumbers(), foldsCount, threadsCount),
+                SolveFolds<TFastLRSolver>(pool, learnIterator.GetInstanceFoldNumbers(), foldsCount, threadsCount),
+                SolveFolds<TWelfordLRSolver>(pool, learnIterator.GetInstanceFoldNumbers(), foldsCount, threadsCount),
+            };
+            for (size_t fold = 0; fold < foldsCount; ++fold) {
+                for (size_t modelIdx = 0; modelIdx < foldModels.size(); ++modelIdx) {
+                    errorsCount += CheckIfModelsAreSimilar(fusedFoldModels[fold][modelIdx], foldModels[modelIdx][fold], "fused solver model #" + std::to_string(modelIdx) + " of fold #" + std::to_string(fold) + " on " + std::to_string(threadsCount) + " threads differs from the one learned alone");
+                }
+            }
+        }
+
+        ++testCounters["fused solver"];
+
+        return errorsCount;
+    }
+
+    size_t CheckDriftingSolvers(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        size_t errorsCount = 0;
+
+        for (const double halfLife : {5., 50., 1e9}) {
+            TDecayedWelfordLRSolver decayedSolver(halfLife);
+            TWelfordLRSolver referenceSolver;
+            for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+                const TInstanceView instance = pool[instanceIdx];
+                decayedSolver.Add(instance.Features, instance.Goal, instance.Weight);
+                referenceSolver.Add(instance.Features, instance.Goal, instance.Weight * pow(0.5, (pool.size() - 1 - instanceIdx) / halfLife));
+            }
+
+            std::stringstream description;
+            description << TDecayedWelfordLRSolver::Name() << " model with half-life " << halfLife << " differs from the explicitly weighted one";
+            errorsCount += CheckIfModelsAreSimilar(decayedSolver.Solve(), referenceSolver.Solve(), description.str());
+        }
+        ++testCounters[TDecayedWelfordLRSolver::Name()];
+
+        for (const size_t windowSize : {size_t(50), size_t(300), pool.size() * 2}) {
+            TWindowWelfordLRSolver windowSolver(windowSize);
+            TWelfordLRSolver referenceSolver;
+            for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+                const TInstanceView instance = pool[instanceIdx];
+                windowSolver.Add(instance.Features, instance.Goal, instance.Weight);
+                if (instanceIdx + windowSize >= pool.size()) {
+                    referenceSolver.Add(instance.Features, instance.Goal, instance.Weight);
+                }
+            }
+
+            std::stringstream description;
+            description << TWindowWelfordLRSolver::Name() << " model with window " << windowSize << " differs from the one learned on the window";
+            errorsCount += CheckIfModelsAreSimilar(windowSolver.Solve(), referenceSolver.Solve(), description.str());
+        }
+        ++testCounters[TWindowWelfordLRSolver::Name()];
+
+        return errorsCount;
+    }
+
+    size_t CheckOnlineDowndate(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        TOnlineLRSolver onlineSolver;
+        TWelfordLRSolver referenceSolver;
+        for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+            const TInstanceView instance = pool[instanceIdx];
+            onlineSolver.Add(instance.Features, instance.Goal, instance.Weight);
+            if (instanceIdx % 3) {
+                referenceSolver.Add(instance.Features, instance.Goal, instance.Weight);
+            }
+        }
+        for (size_t instanceIdx = 0; instanceIdx < pool.size(); instanceIdx += 3) {
+            const TInstanceView instance = pool[instanceIdx];
+            onlineSolver.Add(instance.Features, instance.Goal, -instance.Weight);
+        }
+
+        const TLinearModel onlineModel = onlineSolver.Solve();
+        const TLinearModel referenceModel = referenceSolver.Solve();
+
+        size_t errorsCount = 0;
+
+        bool modelsAreSimilar = DoublesAreQuiteSimilar(onlineModel.Intercept, referenceModel.Intercept);
+        for (size_t fIdx = 0; fIdx < referenceModel.Coefficients.size(); ++fIdx) {
+            modelsAreSimilar = modelsAreSimilar && DoublesAreQuiteSimilar(onlineModel.Coefficients[fIdx], referenceModel.Coefficients[fIdx]);
+        }
+        if (!modelsAreSimilar) {
+            std::cerr << TOnlineLRSolver::Name() << " model after removing instances differs from the one learned without them" << std::endl;
+            ++errorsCount;
+        }
+
+        ++testCounters[TOnlineLRSolver::Name()];
+
+        return errorsCount;
+    }
+
+    template <typename TSolver>
+    size_t CheckSolution(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        TSolver solver;
+        for (const TInstanceView& instance : pool) {
+            solver.Add(instance.Features, instance.Goal, instance.Weight);
+        }
+
+        const TLRSolution solution = solver.Solution();
+        const TLinearModel model = solver.Solve();
+
+        size_t errorsCount = 0;
+
+        bool modelsAreSimilar = DoublesAreQuiteSimilar(solution.Model.Intercept, model.Intercept);
+        for (size_t fIdx = 0; fIdx < model.Coefficients.size(); ++fIdx) {
+            modelsAreSimilar = modelsAreSimilar && DoublesAreQuiteSimilar(solution.Model.Coefficients[fIdx], model.Coefficients[fIdx]);
+        }
+        if (!modelsAreSimilar) {
+            std::cerr << TSolver::Name() << " solution model differs from the solved one" << std::endl;
+            ++errorsCount;
+        }
+        if (!DoublesAreQuiteSimilar(sqrt(solution.SumSquaredErrors / pool.size()), sqrt(solver.SumSquaredErrors() / pool.size()))) {
+            std::cerr << TSolver::Name() << " solution sse differs from the computed one" << std::endl;
+            ++errorsCount;
+        }
+
+        // the inverse of the symmetric OLS matrix has to be symmetric as well
+        const size_t systemSize = solution.Decomposition.GetSize();
+        std::vector<std::vector<double>> inverseColumns;
+        for (size_t idx = 0; idx < systemSize; ++idx) {
+            std::vector<double> unitVector(systemSize);
+            unitVector[idx] = 1.;
+            inverseColumns.push_back(solution.Solve(unitVector));
+        }
+        for (size_t i = 0; i < systemSize; ++i) {
+            for (size_t j = i + 1; j < systemSize; ++j) {
+                if (!DoublesAreQuiteSimilar(inverseColumns[i][j], inverseColumns[j][i])) {
+                    std::cerr << TSolver::Name() << " solution gives asymmetric inverse at (" << i << ", " << j << ")" << std::endl;
+                    ++errorsCount;
+                }
+            }
+        }
+
+        ++testCounters[TSolver::Name()];
+
+        return errorsCount;
+    }
+
+    bool VectorsAreQuiteSimilar(const std::vector<double>& present, const std::vector<double>& target) {
+        for (size_t idx = 0; idx < target.size(); ++idx) {
+            if (!DoublesAreQuiteSimilar(present[idx], target[idx])) {
+                return false;
+            }
+        }
+        return present.size() == target.size();
+    }
+
+    size_t CheckVectorKernels(const NVectorKernels::TKernels& kernels) {
+        const NVectorKernels::TKernels& reference = NVectorKernels::GetKernels(NVectorKernels::IS_SCALAR);
+        const std::string name = NVectorKernels::ToString(kernels.InstructionSet);
+
         std::mt19937 mersenne;
         std::normal_distribution<double> randGen;
+        auto randomVector = [&](const size_t size) {
+            std::vector<double> result(size);
+            for (double& value : result) {
+                value = randGen(mersenne);
+            }
+            return result;
+        };
 
-        std::vector<TPool> researchPools;
-        researchPools.push_back(pool);
-        const size_t nonZeroMSEPoolsCount = 5;
-        for (size_t nonZeroPoolIdx = 0; nonZeroPoolIdx < nonZeroMSEPoolsCount; ++nonZeroPoolIdx) {
-            TPool nonZeroMSEPool(pool);
-            for (TInstance& instance : nonZeroMSEPool) {
-                instance.Goal += randGen(mersenne) / 10;
+        size_t errorsCount = 0;
+        for (size_t size = 0; size < 70; ++size) {
+            const std::vector<double> x = randomVector(size);
+            const std::vector<double> y = randomVector(size);
+            const std::vector<double> columns = randomVector(4 * size);
+
+            std::vector<double> presentY = y, targetY = y;
+            kernels.Axpy(size, 0.3, x.data(), presentY.data());
+            reference.Axpy(size, 0.3, x.data(), targetY.data());
+            if (!VectorsAreQuiteSimilar(presentY, targetY)) {
+                std::cerr << name << " axpy differs from the scalar one for size " << size << std::endl;
+                ++errorsCount;
             }
-            researchPools.push_back(nonZeroMSEPool);
+
+            presentY = targetY = y;
+            kernels.NormalizedAxpy(size, 1.7, 0.1, x.data(), presentY.data());
+            reference.NormalizedAxpy(size, 1.7, 0.1, x.data(), targetY.data());
+            if (!VectorsAreQuiteSimilar(presentY, targetY)) {
+                std::cerr << name << " normalized axpy differs from the scalar one for size " << size << std::endl;
+                ++errorsCount;
+            }
+
+            std::vector<double> presentMeans = y, targetMeans = y;
+            std::vector<double> presentLastDeviations(size), targetLastDeviations(size);
+            std::vector<double> presentNewDeviations(size), targetNewDeviations(size);
+            kernels.UpdateMeans(size, 2., 5., x.data(), presentMeans.data(), presentLastDeviations.data(), presentNewDeviations.data());
+            reference.UpdateMeans(size, 2., 5., x.data(), targetMeans.data(), targetLastDeviations.data(), targetNewDeviations.data());
+            if (!VectorsAreQuiteSimilar(presentMeans, targetMeans) ||
+                !VectorsAreQuiteSimilar(presentLastDeviations, targetLastDeviations) ||
+                !VectorsAreQuiteSimilar(presentNewDeviations, targetNewDeviations))
+            {
+                std::cerr << name << " means update differs from the scalar one for size " << size << std::endl;
+                ++errorsCount;
+            }
+
+            if (!DoublesAreQuiteSimilar(kernels.Dot(size, x.data(), y.data()), reference.Dot(size, x.data(), y.data()))) {
+                std::cerr << name << " dot product differs from the scalar one for size " << size << std::endl;
+                ++errorsCount;
+            }
+
+            std::vector<double> presentDots = {1., 2., 3., 4.}, targetDots = {1., 2., 3., 4.};
+            kernels.AddDots4(size, x.data(), columns.data(), presentDots.data());
+            reference.AddDots4(size, x.data(), columns.data(), targetDots.data());
+            if (!VectorsAreQuiteSimilar(presentDots, targetDots)) {
+                std::cerr << name << " dot products differ from the scalar ones for size " << size << std::endl;
+                ++errorsCount;
+            }
+
+            std::vector<double> presentMoments = columns, targetMoments = columns;
+            kernels.AddSLRMoments(size, 2., 0.7, x.data(), presentMoments.data());
+            reference.AddSLRMoments(size, 2., 0.7, x.data(), targetMoments.data());
+            if (!VectorsAreQuiteSimilar(presentMoments, targetMoments)) {
+                std::cerr << name << " simple regression moments differ from the scalar ones for size " << size << std::endl;
+                ++errorsCount;
+            }
+
+            presentMoments = targetMoments = columns;
+            std::vector<double> presentCompensations(3 * size, 1e-17), targetCompensations(3 * size, 1e-17);
+            kernels.AddKahanSLRMoments(size, 2., 0.7, x.data(), presentMoments.data(), presentCompensations.data());
+            reference.AddKahanSLRMoments(size, 2., 0.7, x.data(), targetMoments.data(), targetCompensations.data());
+            if (!VectorsAreQuiteSimilar(presentMoments, targetMoments) || !VectorsAreQuiteSimilar(presentCompensations, targetCompensations)) {
+                std::cerr << name << " compensated simple regression moments differ from the scalar ones for size " << size << std::endl;
+                ++errorsCount;
+            }
+
+            for (const bool normalized : {false, true}) {
+                const auto update = normalized ? &NVectorKernels::TKernels::UpdateNormalizedWelfordSLR : &NVectorKernels::TKernels::UpdateWelfordSLR;
+
+                std::vector<double> presentMeans = y, targetMeans = y;
+                std::vector<double> presentDeviations = x, targetDeviations = x;
+                std::vector<double> presentCovariations = y, targetCovariations = y;
+                (kernels.*update)(size, 2., 5., 0.3, x.data(), presentMeans.data(), presentDeviations.data(), presentCovariations.data());
+                (reference.*update)(size, 2., 5., 0.3, x.data(), targetMeans.data(), targetDeviations.data(), targetCovariations.data());
+                if (!VectorsAreQuiteSimilar(presentMeans, targetMeans) ||
+                    !VectorsAreQuiteSimilar(presentDeviations, targetDeviations) ||
+                    !VectorsAreQuiteSimilar(presentCovariations, targetCovariations))
+                {
+                    std::cerr << name << (normalized ? " normalized" : "") << " Welford simple regressions update differs from the scalar one for size " << size << std::endl;
+                    ++errorsCount;
+                }
+            }
+        }
+
+        return errorsCount;
+    }
+
+    template <typename TSolver>
+    size_t CheckVectorKernelsModel(const TPool& pool, const NVectorKernels::EInstructionSet instructionSet, std::map<std::string, size_t>& testCounters) {
+        TPool::TSimpleIterator learnIterator = pool.Iterator();
+
+        NVectorKernels::SetActive(NVectorKernels::IS_SCALAR);
+        const TLinearModel scalarModel = Solve<TSolver>(learnIterator);
+        const TLinearModel scalarBatchModel = ParallelSolve<TSolver>(learnIterator, 1, 64);
+        const double scalarRMSE = TRegressionMetricsCalculator::Build(learnIterator, scalarModel).RMSE();
+
+        NVectorKernels::SetActive(instructionSet);
+        const TLinearModel model = Solve<TSolver>(learnIterator);
+        const TLinearModel batchModel = ParallelSolve<TSolver>(learnIterator, 1, 64);
+        const double rmse = TRegressionMetricsCalculator::Build(learnIterator, model).RMSE();
+
+        NVectorKernels::SetActive(NVectorKernels::BestSupported());
+
+        size_t errorsCount = 0;
+        if (!VectorsAreQuiteSimilar(model.Coefficients, scalarModel.Coefficients) ||
+            !VectorsAreQuiteSimilar(batchModel.Coefficients, scalarBatchModel.Coefficients) ||
+            !DoublesAreQuiteSimilar(model.Intercept, scalarModel.Intercept) ||
+            !DoublesAreQuiteSimilar(rmse, scalarRMSE))
+        {
+            std::cerr << TSolver::Name() << " model with " << NVectorKernels::ToString(instructionSet) << " kernels differs from the scalar one" << std::endl;
+            ++errorsCount;
         }
 
+        ++testCounters[TSolver::Name()];
+
+        return errorsCount;
+    }
+
+    size_t DoTestVectorKernels(const TPool& pool) {
         size_t errorsCount = 0;
 
         std::map<std::string, size_t> testCounters;
+        for (const NVectorKernels::EInstructionSet instructionSet : {NVectorKernels::IS_AVX2, NVectorKernels::IS_AVX512}) {
+            if (!NVectorKernels::IsSupported(instructionSet)) {
+                std::cout << NVectorKernels::ToString(instructionSet) << " kernels are not supported on this host" << std::endl;
+                continue;
+            }
 
-        errorsCount += CheckModelPrecision<TFastLRSolver>(pool, testCounters);
-        errorsCount += CheckModelPrecision<TWelfordLRSolver>(pool, testCounters);
-        errorsCount += CheckModelPrecision<TNormalizedWelfordLRSolver>(pool, testCounters);
+            errorsCount += CheckVectorKernels(NVectorKernels::GetKernels(instructionSet));
 
-        for (const TPool& researchPool : researchPools) {
-            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TKahanBestSLRSolver>(researchPool, testCounters);
-            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TWelfordBestSLRSolver>(researchPool, testCounters);
-            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TNormalizedWelfordBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckVectorKernelsModel<TFastLRSolver>(pool, instructionSet, testCounters);
+            errorsCount += CheckVectorKernelsModel<TWelfordLRSolver>(pool, instructionSet, testCounters);
+            errorsCount += CheckVectorKernelsModel<TNormalizedWelfordLRSolver>(pool, instructionSet, testCounters);
+            errorsCount += CheckVectorKernelsModel<TFastBestSLRSolver>(pool, instructionSet, testCounters);
+            errorsCount += CheckVectorKernelsModel<TKahanBestSLRSolver>(pool, instructionSet, testCounters);
+            errorsCount += CheckVectorKernelsModel<TWelfordBestSLRSolver>(pool, instructionSet, testCounters);
+            errorsCount += CheckVectorKernelsModel<TNormalizedWelfordBestSLRSolver>(pool, instructionSet, testCounters);
+        }
 
-            errorsCount += CheckIfModelsAreEqual<TFastLRSolver, TWelfordLRSolver>(researchPool, testCounters);
-            errorsCount += CheckIfModelsAreEqual<TFastLRSolver, TNormalizedWelfordLRSolver>(researchPool, testCounters);
+        std::cout << "vector kernels errors: " << errorsCount << std::endl;
+
+        for (auto&& nameWithCount : testCounters) {
+            std::cout << "\t" << "test runs for " << nameWithCount.first << ": " << nameWithCount.second << std::endl;
+        }
+
+        return errorsCount;
+    }
+
+    TPool ReadFromFeaturesWithStreams(const std::string& featuresPath) {
+        std::ifstream featuresIn(featuresPath);
+
+        TPool pool;
+        std::string featuresString;
+        while (getline(featuresIn, featuresString)) {
+            if (!featuresString.empty()) {
+                pool.push_back(TInstance::FromFeaturesString(featuresString));
+            }
+        }
+        return pool;
+    }
+
+    bool PoolsAreEqual(const TPool& present, const TPool& target) {
+        if (present.size() != target.size()) {
+            return false;
+        }
+        for (size_t instanceIdx = 0; instanceIdx < target.size(); ++instanceIdx) {
+            const TInstanceView presentInstance = present[instanceIdx];
+            const TInstanceView targetInstance = target[instanceIdx];
+            if (presentInstance.QueryId != targetInstance.QueryId ||
+                presentInstance.Url != targetInstance.Url ||
+                presentInstance.Goal != targetInstance.Goal ||
+                presentInstance.Weight != targetInstance.Weight ||
+                !std::equal(presentInstance.Features.begin(), presentInstance.Features.end(), targetInstance.Features.begin(), targetInstance.Features.end()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the pipeline keeps neither the QueryId nor the Url
+    bool FeaturesAreEqual(const TPool& present, const TPool& target) {
+        if (present.size() != target.size()) {
+            return false;
+        }
+        for (size_t instanceIdx = 0; instanceIdx < target.size(); ++instanceIdx) {
+            const TInstanceView presentInstance = present[instanceIdx];
+            const TInstanceView targetInstance = target[instanceIdx];
+            if (presentInstance.Goal != targetInstance.Goal ||
+                presentInstance.Weight != targetInstance.Weight ||
+                !std::equal(presentInstance.Features.begin(), presentInstance.Features.end(), targetInstance.Features.begin(), targetInstance.Features.end()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t CheckFeaturesReader(const std::string& featuresPath) {
+        size_t errorsCount = 0;
+
+        const TPool referencePool = ReadFromFeaturesWithStreams(featuresPath);
+
+        TPool pool;
+        pool.ReadFromFeatures(featuresPath);
+        if (!PoolsAreEqual(pool, referencePool)) {
+            std::cerr << "features reader gives another pool for " << featuresPath << std::endl;
+            ++errorsCount;
+        }
+
+        for (const size_t threadsCount : {2, 3, 7, 100}) {
+            TPool parallelPool;
+            parallelPool.ReadFromFeatures(featuresPath, threadsCount);
+            if (!PoolsAreEqual(parallelPool, referencePool)) {
+                std::cerr << "features reader on " << threadsCount << " threads gives another pool for " << featuresPath << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // a tiny buffer makes every line cross its end
+        TFeaturesReader featuresReader(featuresPath, 7);
+        TPool smallBufferPool;
+        TInstance instance;
+        while (featuresReader.Next(instance)) {
+            smallBufferPool.push_back(instance);
+        }
+        if (!PoolsAreEqual(smallBufferPool, referencePool)) {
+            std::cerr << "features reader with a small buffer gives another pool for " << featuresPath << std::endl;
+            ++errorsCount;
+        }
+
+        TPool streamedPool;
+        for (TFeaturesStreamIterator streamIterator(featuresPath); streamIterator.IsValid(); ++streamIterator) {
+            streamedPool.push_back(*streamIterator);
+        }
+        if (!PoolsAreEqual(streamedPool, referencePool)) {
+            std::cerr << "features stream gives another pool for " << featuresPath << std::endl;
+            ++errorsCount;
+        }
+
+        // tiny blocks and queues make the stages wait for each other
+        for (const size_t parsersCount : {1, 3}) {
+            for (const size_t blockSize : {7, 1 << 20}) {
+                TFeaturesPipeline pipeline(featuresPath, PF_FEATURES, parsersCount, 0, 2, blockSize);
+                TPool pipelinePool;
+                while (pipeline.Next()) {
+                    pipelinePool.push_back(pipeline.GetInstance());
+                }
+                if (!FeaturesAreEqual(pipelinePool, referencePool)) {
+                    std::cerr << "features pipeline of " << parsersCount << " parsers and " << blockSize << " bytes blocks gives another pool for " << featuresPath << std::endl;
+                    ++errorsCount;
+                }
+            }
+        }
+
+        // the stages stop when the consumer leaves early
+        {
+            TFeaturesPipelineIterator pipelineIterator(featuresPath, PF_AUTO, 2);
+            if (referencePool.size() && pipelineIterator->Goal != referencePool[0].Goal) {
+                std::cerr << "features pipeline iterator gives another first instance for " << featuresPath << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        return errorsCount;
+    }
+
+    size_t DoTestFeaturesReader(const TPool& pool) {
+        size_t errorsCount = 0;
+
+        const std::string featuresPath = (std::filesystem::temp_directory_path() / "linear_regression_features_reader_test.features").string();
+        {
+            std::ofstream featuresOut(featuresPath);
+            pool.PrintForFeatures(featuresOut);
+            featuresOut << "\n";
+            featuresOut << "q1\t+1.5\turl\t2\t-3e-2\t+4\t5.5abc\t6\n";
+            featuresOut << "q2\t7x\t1\t8\t9\n";
+            featuresOut << "q3\tnan\turl\t1\t2\n";
+            featuresOut << "q4\t1\turl\tbad\t2\n";
+            featuresOut << "q5 \t 1  url 1 .5 -.25 1E3\r\n";
+            featuresOut << "q6\t1\turl\t1\t2";
+        }
+        errorsCount += CheckFeaturesReader(featuresPath);
+        std::filesystem::remove(featuresPath);
+
+        if (TFeaturesStreamIterator(featuresPath).IsOpen()) {
+            std::cerr << "features stream of a missing file is open" << std::endl;
+            ++errorsCount;
+        }
+        if (TFeaturesPipelineIterator(featuresPath, PF_FEATURES, 2).IsOpen()) {
+            std::cerr << "features pipeline of a missing file is open" << std::endl;
+            ++errorsCount;
+        }
+
+        std::error_code errorCode;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("data/features", errorCode)) {
+            errorsCount += CheckFeaturesReader(entry.path().string());
+        }
+
+        std::cout << "features reader errors: " << errorsCount << std::endl;
+
+        return errorsCount;
+    }
+
+    // the SVMLight and Vowpal Wabbit writers keep neither the url nor the full goal precision
+    bool ConvertedPoolsAreEqual(const TPool& present, const TPool& target, const bool hasWeights) {
+        if (present.size() != target.size()) {
+            return false;
+        }
+        for (size_t instanceIdx = 0; instanceIdx < target.size(); ++instanceIdx) {
+            const TInstanceView presentInstance = present[instanceIdx];
+            const TInstanceView targetInstance = target[instanceIdx];
+            if (presentInstance.QueryId != targetInstance.QueryId ||
+                !DoublesAreQuiteSimilar(presentInstance.Goal, targetInstance.Goal, 1e-5) ||
+                presentInstance.Weight != (hasWeights ? targetInstance.Weight : 1.) ||
+                !std::equal(presentInstance.Features.begin(), presentInstance.Features.end(), targetInstance.Features.begin(), targetInstance.Features.end()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t CheckFormatReader(const std::string& path, const EPoolFormat format, const TPool& referencePool) {
+        size_t errorsCount = 0;
+
+        for (const EPoolFormat readFormat : {PF_AUTO, format}) {
+            for (const size_t threadsCount : {1, 3}) {
+                TPool pool;
+                pool.Read(path, threadsCount, readFormat);
+                if (!ConvertedPoolsAreEqual(pool, referencePool, format == PF_VOWPAL_WABBIT)) {
+                    std::cerr << "format reader on " << threadsCount << " threads gives another pool for " << path
+                              << (readFormat == PF_AUTO ? " with the detected format" : "") << std::endl;
+                    ++errorsCount;
+                }
+            }
+        }
+
+        return errorsCount;
+    }
+
+    bool InstanceIs(const TInstance& instance, const std::string& queryId, const double goal, const double weight, const std::vector<double>& features) {
+        return instance.QueryId == queryId && instance.Goal == goal && instance.Weight == weight && instance.Features == features;
+    }
+
+    size_t DoTestFormatReaders(const TPool& sourcePool) {
+        size_t errorsCount = 0;
+
+        TPool pool;
+        for (size_t instanceIdx = 0; instanceIdx < sourcePool.size(); ++instanceIdx) {
+            TInstance instance = TInstance::FromView(sourcePool[instanceIdx]);
+            instance.QueryId = "q" + std::to_string(instanceIdx);
+            instance.Url = "";
+            instance.Weight = 1. + instanceIdx % 3;
+            pool.push_back(instance);
+        }
+
+        const std::string formatPath = (std::filesystem::temp_directory_path() / "linear_regression_format_reader_test.txt").string();
+        for (const EPoolFormat format : {PF_SVM_LIGHT, PF_VOWPAL_WABBIT}) {
+            {
+                std::ofstream formatOut(formatPath);
+                if (format == PF_SVM_LIGHT) {
+                    pool.PrintForSVMLight(formatOut);
+                } else {
+                    pool.PrintForVowpalWabbit(formatOut);
+                }
+            }
+            errorsCount += CheckFormatReader(formatPath, format, pool);
+        }
+
+        // a sparse row wider than the first one stops the stream unless the features count covers it
+        {
+            std::ofstream formatOut(formatPath);
+            formatOut << "1 1:1 2:2\n2 1:1 5:3\n3 2:4\n";
+        }
+        for (const size_t featuresCount : {0, 5}) {
+            size_t instancesCount = 0;
+            TFeaturesStreamIterator streamIterator(formatPath, PF_SVM_LIGHT, featuresCount);
+            for (; streamIterator.IsValid(); ++streamIterator) {
+                ++instancesCount;
+            }
+            if (instancesCount != (featuresCount ? 3 : 1) || streamIterator.GetWideInstanceFeaturesCount() != (featuresCount ? 0 : 5)) {
+                std::cerr << "features stream with " << featuresCount << " features does not stop at the wide sparse row" << std::endl;
+                ++errorsCount;
+            }
+
+            instancesCount = 0;
+            TFeaturesPipelineIterator pipelineIterator(formatPath, PF_SVM_LIGHT, 2, featuresCount);
+            for (; pipelineIterator.IsValid(); ++pipelineIterator) {
+                ++instancesCount;
+            }
+            if (instancesCount != (featuresCount ? 3 : 1) || pipelineIterator.GetWideInstanceFeaturesCount() != (featuresCount ? 0 : 5)) {
+                std::cerr << "features pipeline with " << featuresCount << " features does not stop at the wide sparse row" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // the rows widening the pool past the batches of the sparse reader pad all the preceding ones
+        {
+            std::ofstream formatOut(formatPath);
+            for (size_t instanceIdx = 0; instanceIdx < 40000; ++instanceIdx) {
+                formatOut << instanceIdx << " 1:1";
+                if (instanceIdx == 20000 || instanceIdx == 39999) {
+                    formatOut << " " << (instanceIdx == 20000 ? 3 : 4) << ":2";
+                }
+                formatOut << "\n";
+            }
+        }
+        for (const size_t threadsCount : {1, 3}) {
+            TPool widenedPool;
+            widenedPool.Read(formatPath, threadsCount, PF_SVM_LIGHT);
+            if (widenedPool.size() != 40000 || widenedPool.FeaturesCount() != 4 ||
+                widenedPool[0].Features[3] != 0. || widenedPool[20000].Features[2] != 2. || widenedPool[39999].Features[3] != 2.)
+            {
+                std::cerr << "sparse pool on " << threadsCount << " threads is not widened to its widest row" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // only a '|' right after the label, the importance, the base and the tag makes a Vowpal Wabbit line
+        const std::pair<std::string, EPoolFormat> linesWithFormats[] = {
+            {"1 |a 1:2", PF_VOWPAL_WABBIT},
+            {"3 2 0.5 'tag|a 0:1", PF_VOWPAL_WABBIT},
+            {"-1|a 0:1", PF_VOWPAL_WABBIT},
+            {"q1\t1\thttp://a|b\t1\t2", PF_FEATURES},
+            {"q|1\t1\turl\t1\t2", PF_FEATURES},
+            {"1 1:2 # a|b", PF_SVM_LIGHT},
+        };
+        for (const auto& lineWithFormat : linesWithFormats) {
+            {
+                std::ofstream formatOut(formatPath);
+                formatOut << lineWithFormat.first << "\n";
+            }
+            if (TFeaturesReader::DetectFormat(formatPath) != lineWithFormat.second) {
+                std::cerr << "format of \"" << lineWithFormat.first << "\" is detected wrong" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // the parsers append the features to the ones of the instance, as TFeaturesReader::Next clears them
+        const auto parseSVMLight = [](const std::string& line, TInstance& instance) {
+            instance = TInstance();
+            return TFeaturesReader::ParseSVMLightLine(line.data(), line.data() + line.size(), instance);
+        };
+        const auto parseVowpalWabbit = [](const std::string& line, TInstance& instance) {
+            instance = TInstance();
+            TFeaturesReader::ParseVowpalWabbitLine(line.data(), line.data() + line.size(), instance);
+        };
+
+        TInstance instance;
+        if (!parseSVMLight("2.5 qid:7 3:1.5 1:-2 # query 1 \r", instance) || !InstanceIs(instance, "query 1", 2.5, 1., {-2., 0., 1.5})) {
+            std::cerr << "SVMLight line with a comment is parsed with errors" << std::endl;
+            ++errorsCount;
+        }
+        if (!parseSVMLight("-1 qid:7 2:3 0:5 x:1 4:bad", instance) || !InstanceIs(instance, "7", -1., 1., {0., 3.})) {
+            std::cerr << "SVMLight line with a qid is parsed with errors" << std::endl;
+            ++errorsCount;
+        }
+        if (parseSVMLight("  # just a comment", instance)) {
+            std::cerr << "SVMLight comment line is parsed as an instance" << std::endl;
+            ++errorsCount;
+        }
+
+        parseVowpalWabbit("3 2 'tag|a:2 0:1.5 2 name:4 |b 1:-1", instance);
+        if (!InstanceIs(instance, "tag", 3., 2., {3., -1., 2.})) {
+            std::cerr << "Vowpal Wabbit line with namespaces is parsed with errors" << std::endl;
+            ++errorsCount;
+        }
+        parseVowpalWabbit("1 |f 1:2 |\tq9\r", instance);
+        if (!InstanceIs(instance, "q9", 1., 1., {0., 2.})) {
+            std::cerr << "Vowpal Wabbit line with an appended QueryId is parsed with errors" << std::endl;
+            ++errorsCount;
+        }
+        parseVowpalWabbit("0.5 4 0.1 | 1", instance);
+        if (!InstanceIs(instance, "", 0.5, 4., {0., 1.})) {
+            std::cerr << "Vowpal Wabbit line with a base is parsed with errors" << std::endl;
+            ++errorsCount;
+        }
+
+        // sparse rows longer than the first one widen the pool with zeros
+        {
+            std::ofstream formatOut(formatPath);
+            formatOut << "# header\n";
+            formatOut << "1 2:1\n";
+            formatOut << "\n";
+            formatOut << "2 1:1 4:2 # q\n";
+            formatOut << "3\n";
+        }
+        TPool sparsePool;
+        sparsePool.Read(formatPath);
+        const std::vector<std::vector<double>> expectedFeatures = {{0., 1., 0., 0.}, {1., 0., 0., 2.}, {0., 0., 0., 0.}};
+        bool sparsePoolIsRead = sparsePool.size() == expectedFeatures.size() && sparsePool.FeaturesCount() == 4;
+        for (size_t instanceIdx = 0; sparsePoolIsRead && instanceIdx < sparsePool.size(); ++instanceIdx) {
+            const TInstanceView sparseInstance = sparsePool[instanceIdx];
+            sparsePoolIsRead = std::equal(sparseInstance.Features.begin(), sparseInstance.Features.end(), expectedFeatures[instanceIdx].begin(), expectedFeatures[instanceIdx].end()) &&
+                               sparseInstance.Goal == instanceIdx + 1.;
+        }
+        if (!sparsePoolIsRead) {
+            std::cerr << "sparse SVMLight pool is read with errors" << std::endl;
+            ++errorsCount;
+        }
+        std::filesystem::remove(formatPath);
+
+        // the converted sample pools
+        std::error_code errorCode;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("data/features", errorCode)) {
+            TPool featuresPool;
+            featuresPool.ReadFromFeatures(entry.path().string());
+
+            const std::string poolName = entry.path().stem().string();
+            const std::pair<std::string, EPoolFormat> convertedPaths[] = {
+                {"data/svmlight/" + poolName + ".svm", PF_SVM_LIGHT},
+                {"data/vw/" + poolName + ".vw", PF_VOWPAL_WABBIT},
+            };
+            for (const auto& pathAndFormat : convertedPaths) {
+                if (std::filesystem::file_size(pathAndFormat.first, errorCode) > 0 && !errorCode) {
+                    errorsCount += CheckFormatReader(pathAndFormat.first, pathAndFormat.second, featuresPool);
+                }
+            }
+        }
+
+        std::cout << "format readers errors: " << errorsCount << std::endl;
+
+        return errorsCount;
+    }
+
+    size_t DoTestPoolStorage(const TPool& pool) {
+        size_t errorsCount = 0;
+
+        // rows take the features count of the first one
+        TPool raggedPool;
+        for (const std::vector<double>& features : std::vector<std::vector<double>>{{1., 2., 3.}, {4.}, {5., 6., 7., 8.}}) {
+            TInstance instance;
+            instance.QueryId = "q" + std::to_string(features.size());
+            instance.Features = features;
+            instance.Goal = features.front();
+            instance.Weight = 1.;
+            raggedPool.push_back(instance);
+        }
+        const std::vector<std::vector<double>> expectedFeatures = {{1., 2., 3.}, {4., 0., 0.}, {5., 6., 7.}};
+        for (size_t instanceIdx = 0; instanceIdx < raggedPool.size(); ++instanceIdx) {
+            const TInstanceView instance = raggedPool[instanceIdx];
+            if (!std::equal(instance.Features.begin(), instance.Features.end(), expectedFeatures[instanceIdx].begin(), expectedFeatures[instanceIdx].end()) ||
+                instance.Goal != expectedFeatures[instanceIdx].front())
+            {
+                std::cerr << "pool instance " << instanceIdx << " is not padded or cut to the first instance's features count" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // pools with their own string tables are appended with the strings remapped
+        TPool appendedPool(raggedPool);
+        appendedPool.Append(raggedPool.InjuredPool(2., 1.));
+        appendedPool.Append(pool);
+        if (appendedPool.size() != 2 * raggedPool.size() + pool.size() || appendedPool[4].QueryId != "q1" || appendedPool[4].Features[0] != 9. ||
+            appendedPool[4].Goal != 9. || appendedPool[2 * raggedPool.size()].QueryId != pool[0].QueryId || appendedPool.FeaturesCount() != 3)
+        {
+            std::cerr << "appended pool differs from the source ones" << std::endl;
+            ++errorsCount;
+        }
+
+        // a copy shares the strings of its source until one of them gets a new string
+        TPool sharingPool(raggedPool);
+        TInstance newStringInstance;
+        newStringInstance.QueryId = "q5";
+        newStringInstance.Features = {1., 2., 3.};
+        sharingPool.push_back(newStringInstance);
+        raggedPool.push_back(newStringInstance);
+        if (sharingPool[3].QueryId != "q5" || raggedPool[3].QueryId != "q5" || sharingPool[0].QueryId != "q3" || raggedPool[1].QueryId != "q1") {
+            std::cerr << "pools sharing their strings differ after a new string" << std::endl;
+            ++errorsCount;
+        }
+
+        TPool copiedPool;
+        for (const TInstanceView& instance : pool) {
+            copiedPool.push_back(instance);
+        }
+        if (!PoolsAreEqual(copiedPool, pool) || copiedPool.AllocatedBytes() < pool.size() * (pool.FeaturesCount() + 2) * sizeof(double)) {
+            std::cerr << "copied pool differs from the source one" << std::endl;
+            ++errorsCount;
+        }
+
+        // the injured views give out the instances of the injured copies
+        const TPool injuredPool = pool.InjuredPool(1e-3, 1e3);
+        const TPoolView injuredView = pool.InjuredView(1e-3, 1e3);
+
+        TPool viewedPool;
+        for (TPool::TSimpleIterator iterator = injuredView.Iterator(); iterator.IsValid(); ++iterator) {
+            viewedPool.push_back(*iterator);
+        }
+        TPool viewedTestPool;
+        TPool::TCVIterator testIterator = injuredView.TestIterator(3);
+        TPool::TCVIterator copyTestIterator = injuredPool.TestIterator(3);
+        testIterator.SetTestFold(1);
+        copyTestIterator.SetTestFold(1);
+        for (; testIterator.IsValid() && copyTestIterator.IsValid(); ++testIterator, ++copyTestIterator) {
+            viewedTestPool.push_back(*testIterator);
+            viewedTestPool.push_back(*copyTestIterator);
+        }
+        bool testFoldsAreEqual = !testIterator.IsValid() && !copyTestIterator.IsValid();
+        for (size_t instanceIdx = 0; instanceIdx + 1 < viewedTestPool.size(); instanceIdx += 2) {
+            testFoldsAreEqual &= viewedTestPool[instanceIdx].Goal == viewedTestPool[instanceIdx + 1].Goal &&
+                                 std::equal(viewedTestPool[instanceIdx].Features.begin(), viewedTestPool[instanceIdx].Features.end(), viewedTestPool[instanceIdx + 1].Features.begin());
+        }
+        if (!PoolsAreEqual(viewedPool, injuredPool) || !testFoldsAreEqual) {
+            std::cerr << "injured view differs from the injured pool" << std::endl;
+            ++errorsCount;
+        }
+
+        // the transformed features are copied by the parallel accumulation, they are rebuilt on every step
+        const TLinearModel viewModel = ParallelAccumulate<TFastLRSolver>(injuredView.Iterator(), 3).Solve();
+        const TLinearModel copyModel = ParallelAccumulate<TFastLRSolver>(injuredPool.Iterator(), 3).Solve();
+        const std::vector<TLinearModel> viewFoldModels = SolveFolds<TFastLRSolver>(injuredView, testIterator.GetInstanceFoldNumbers(), 3, 2);
+        const std::vector<TLinearModel> copyFoldModels = SolveFolds<TFastLRSolver>(injuredPool, testIterator.GetInstanceFoldNumbers(), 3, 2);
+        if (viewModel.Coefficients != copyModel.Coefficients || viewFoldModels.back().Coefficients != copyFoldModels.back().Coefficients) {
+            std::cerr << "models learned on the injured view differ from the ones of the injured pool" << std::endl;
+            ++errorsCount;
+        }
+
+        std::stringstream viewOut;
+        std::stringstream copyOut;
+        injuredView.PrintForFeatures(viewOut);
+        injuredPool.PrintForFeatures(copyOut);
+        if (viewOut.str() != copyOut.str()) {
+            std::cerr << "injured view is printed unlike the injured pool" << std::endl;
+            ++errorsCount;
+        }
+
+        std::cout << "pool storage errors: " << errorsCount << std::endl;
+
+        return errorsCount;
+    }
+
+    size_t DoTestBinaryPool(const TPool& sourcePool) {
+        size_t errorsCount = 0;
+
+        TPool pool;
+        for (size_t instanceIdx = 0; instanceIdx < sourcePool.size(); ++instanceIdx) {
+            TInstance instance = TInstance::FromView(sourcePool[instanceIdx]);
+            instance.QueryId = "q" + std::to_string(instanceIdx % 7);
+            instance.Url = instanceIdx % 3 ? "url" + std::to_string(instanceIdx) : "";
+            instance.Weight = 1. + instanceIdx % 5;
+            pool.push_back(instance);
+        }
+
+        const std::string binaryPath = (std::filesystem::temp_directory_path() / "linear_regression_binary_pool_test.bin").string();
+        for (const TPool& testPool : {pool, TPool()}) {
+            const size_t fileSize = NBinaryPool::Write(testPool, binaryPath);
+
+            TMappedPool mappedPool;
+            if (!fileSize || !mappedPool.Open(binaryPath) || mappedPool.GetFileSize() != fileSize ||
+                mappedPool.InstancesCount() != testPool.size() || mappedPool.FeaturesCount() != testPool.FeaturesCount())
+            {
+                std::cerr << "binary pool of " << testPool.size() << " instances is not mapped" << std::endl;
+                ++errorsCount;
+                continue;
+            }
+
+            TPool readPool;
+            if (readPool.Read(binaryPath) != fileSize || !PoolsAreEqual(readPool, testPool) || readPool.AllocatedBytes()) {
+                std::cerr << "binary pool of " << testPool.size() << " instances is read with errors" << std::endl;
+                ++errorsCount;
+            }
+
+            // adding instances copies the mapped ones into the pool
+            TPool expectedPool(testPool);
+            expectedPool.Append(pool);
+            NBinaryPool::Write(pool, binaryPath);
+            readPool.ReadFromBinary(binaryPath);
+            if (!PoolsAreEqual(readPool, expectedPool)) {
+                std::cerr << "binary pool of " << pool.size() << " instances is appended with errors" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // a truncated file has to be rejected on opening rather than read past its end
+        const size_t fileSize = NBinaryPool::Write(pool, binaryPath);
+        std::filesystem::resize_file(binaryPath, fileSize - 1);
+        TMappedPool truncatedPool;
+        if (truncatedPool.Open(binaryPath)) {
+            std::cerr << "truncated binary pool is opened" << std::endl;
+            ++errorsCount;
+        }
+
+        // the header and the ids are written over with values pointing far beyond the file
+        const auto overwrite = [&binaryPath](const uint64_t offset, const void* data, const size_t size) {
+            std::fstream file(binaryPath, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(offset);
+            file.write((const char*)data, size);
+        };
+
+        NBinaryPool::Write(pool, binaryPath);
+        const uint64_t wrappingFeaturesCount = (uint64_t)1 << 61;
+        const uint64_t wrappingInstancesCount = 8;
+        overwrite(offsetof(NBinaryPool::THeader, InstancesCount), &wrappingInstancesCount, sizeof(uint64_t));
+        overwrite(offsetof(NBinaryPool::THeader, FeaturesCount), &wrappingFeaturesCount, sizeof(uint64_t));
+        TMappedPool overflowingPool;
+        if (overflowingPool.Open(binaryPath)) {
+            std::cerr << "binary pool with a features matrix size overflowing is opened" << std::endl;
+            ++errorsCount;
+        }
+
+        NBinaryPool::Write(pool, binaryPath);
+        TMappedPool stringsPool;
+        if (!stringsPool.Open(binaryPath)) {
+            std::cerr << "binary pool is not opened" << std::endl;
+            ++errorsCount;
+        } else {
+            NBinaryPool::THeader header;
+            std::ifstream(binaryPath, std::ios::binary).read((char*)&header, sizeof(header));
+            stringsPool.Close();
+
+            const uint32_t badStringId = (uint32_t)-1;
+            overwrite(header.QueryIds.IdsOffset, &badStringId, sizeof(uint32_t));
+            if (!stringsPool.Open(binaryPath) || !stringsPool.QueryId(0).empty() || stringsPool.QueryId(1) != pool[1].QueryId) {
+                std::cerr << "binary pool string id out of the table is not read as an empty string" << std::endl;
+                ++errorsCount;
+            }
+        }
+        std::filesystem::remove(binaryPath);
+
+        if (truncatedPool.Open(binaryPath)) {
+            std::cerr << "missing binary pool is opened" << std::endl;
+            ++errorsCount;
+        }
+
+        std::cout << "binary pool errors: " << errorsCount << std::endl;
+
+        return errorsCount;
+    }
+
+    size_t DoTestLDLDecomposition() {
+        std::mt19937 mersenne;
+        std::normal_distribution<double> randGen;
+
+        size_t errorsCount = 0;
+
+        TLDLDecomposition decomposition;
+        for (size_t size = 1; size < 100; size += (size < 40 ? 1 : 13)) {
+            // Gram matrix of random rows with a duplicated feature, so that the regularization is needed
+            std::vector<double> linearizedMatrix(size * (size + 1) / 2);
+            for (size_t rowIdx = 0; rowIdx < 2 * size; ++rowIdx) {
+                std::vector<double> row(size);
+                for (double& value : row) {
+                    value = randGen(mersenne);
+                }
+                row.back() = size > 1 ? row.front() : row.back();
+
+                size_t elementIdx = 0;
+                for (size_t i = 0; i < size; ++i) {
+                    for (size_t j = i; j < size; ++j, ++elementIdx) {
+                        linearizedMatrix[elementIdx] += row[i] * row[j];
+                    }
+                }
+            }
+
+            std::vector<double> rightHandSide(size);
+            for (double& value : rightHandSide) {
+                value = randGen(mersenne);
+            }
+            if (size > 1) {
+                rightHandSide.back() = rightHandSide.front();
+            }
+
+            decomposition.DecomposeRegularized(linearizedMatrix, size);
+            std::vector<double> solution;
+            decomposition.Solve(rightHandSide, solution);
+
+            std::vector<double> product(size);
+            const double regularizationParameter = decomposition.GetRegularizationParameter();
+            size_t elementIdx = 0;
+            for (size_t i = 0; i < size; ++i) {
+                product[i] += (linearizedMatrix[elementIdx] + regularizationParameter) * solution[i];
+                ++elementIdx;
+                for (size_t j = i + 1; j < size; ++j, ++elementIdx) {
+                    product[i] += linearizedMatrix[elementIdx] * solution[j];
+                    product[j] += linearizedMatrix[elementIdx] * solution[i];
+                }
+            }
+
+            if (!VectorsAreQuiteSimilar(product, rightHandSide)) {
+                std::cerr << "LDL decomposition of size " << size << " gives wrong solution" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        std::cout << "LDL decomposition errors: " << errorsCount << std::endl;
+
+        return errorsCount;
+    }
+
+    size_t DoTestEigenDecomposition() {
+        std::mt19937 mersenne;
+        std::normal_distribution<double> randGen;
+
+        size_t errorsCount = 0;
+
+        TSymmetricEigenDecomposition eigenDecomposition;
+        TLDLDecomposition ldlDecomposition;
+        for (size_t size = 1; size < 60; size += (size < 20 ? 1 : 9)) {
+            std::vector<double> linearizedMatrix;
+            for (size_t i = 0; i < size; ++i) {
+                for (size_t j = i; j < size; ++j) {
+                    linearizedMatrix.push_back(randGen(mersenne) + (i == j ? size : 0.));
+                }
+            }
+
+            std::vector<double> rightHandSide(size);
+            for (double& value : rightHandSide) {
+                value = randGen(mersenne);
+            }
+
+            eigenDecomposition.Decompose(linearizedMatrix, size);
+            std::vector<double> projections;
+            eigenDecomposition.Project(rightHandSide, projections);
+
+            for (const double regularizationParameter : {0., 0.1, 10.}) {
+                std::vector<double> eigenSolution, ldlSolution;
+                eigenDecomposition.SolveProjected(projections, regularizationParameter, eigenSolution);
+
+                ldlDecomposition.Decompose(linearizedMatrix, size, 0., regularizationParameter);
+                ldlDecomposition.Solve(rightHandSide, ldlSolution);
+
+                if (!VectorsAreQuiteSimilar(eigenSolution, ldlSolution)) {
+                    std::cerr << "eigendecomposition of size " << size << " with regularization " << regularizationParameter << " gives wrong solution" << std::endl;
+                    ++errorsCount;
+                }
+            }
+
+            std::vector<double> eigenvalues;
+            eigenDecomposition.Decompose(linearizedMatrix, size, false);
+            eigenvalues = eigenDecomposition.GetEigenvalues();
+            eigenDecomposition.Decompose(linearizedMatrix, size);
+
+            std::sort(eigenvalues.begin(), eigenvalues.end());
+            std::vector<double> referenceEigenvalues = eigenDecomposition.GetEigenvalues();
+            std::sort(referenceEigenvalues.begin(), referenceEigenvalues.end());
+            if (!VectorsAreQuiteSimilar(eigenvalues, referenceEigenvalues)) {
+                std::cerr << "eigenvalues of size " << size << " differ with and without eigenvectors" << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        std::cout << "eigendecomposition errors: " << errorsCount << std::endl;
+
+        return errorsCount;
+    }
+
+    template <typename TSolver>
+    size_t CheckRidgePath(const TPool& pool, std::map<std::string, size_t>& testCounters) {
+        TSolver solver;
+        for (const TInstanceView& instance : pool) {
+            solver.Add(instance.Features, instance.Goal, instance.Weight);
+        }
+
+        const TLinearModel model = solver.Solve();
+        const std::vector<TLinearModel> ridgeModels = solver.RidgePath({0., 1e10});
+
+        size_t errorsCount = 0;
+
+        bool modelsAreSimilar = DoublesAreQuiteSimilar(ridgeModels.front().Intercept, model.Intercept);
+        for (size_t fIdx = 0; fIdx < model.Coefficients.size(); ++fIdx) {
+            modelsAreSimilar = modelsAreSimilar && DoublesAreQuiteSimilar(ridgeModels.front().Coefficients[fIdx], model.Coefficients[fIdx]);
+        }
+        if (!modelsAreSimilar) {
+            std::cerr << TSolver::Name() << " unregularized ridge model differs from the solved one" << std::endl;
+            ++errorsCount;
+        }
+
+        for (size_t fIdx = 0; fIdx < model.Coefficients.size(); ++fIdx) {
+            if (fabs(ridgeModels.back().Coefficients[fIdx]) > 1e-3 * std::max(fabs(model.Coefficients[fIdx]), 1.)) {
+                std::cerr << TSolver::Name() << " heavily regularized ridge model keeps coefficient #" << fIdx << std::endl;
+                ++errorsCount;
+            }
+        }
+
+        // the same parameter regularizes every solver alike, leaving the intercept alone
+        TWelfordLRSolver welfordSolver;
+        for (const TInstanceView& instance : pool) {
+            welfordSolver.Add(instance.Features, instance.Goal, instance.Weight);
+        }
+        const double ridgeParameter = 1e4;
+        errorsCount += CheckIfModelsAreSimilar(solver.RidgePath({ridgeParameter}).front(),
+                                               welfordSolver.RidgePath({ridgeParameter}).front(),
+                                               TSolver::Name() + " ridge model differs from the Welford LR one");
+
+        // a duplicated feature makes the OLS matrix singular, and the unregularized path has to stay finite
+        TSolver degenerateSolver;
+        for (const TInstanceView& instance : pool) {
+            std::vector<double> features(instance.Features.begin(), instance.Features.end());
+            features.push_back(features.front());
+            degenerateSolver.Add(features, instance.Goal, instance.Weight);
+        }
+        TLinearModel degenerateModel = degenerateSolver.RidgePath({0.}).front();
+        bool degenerateModelIsFinite = std::isfinite(degenerateModel.Intercept);
+        for (const double coefficient : degenerateModel.Coefficients) {
+            degenerateModelIsFinite = degenerateModelIsFinite && std::isfinite(coefficient) && fabs(coefficient) < 1e6;
+        }
+        degenerateModel.Coefficients.front() += degenerateModel.Coefficients.back();
+        degenerateModel.Coefficients.pop_back();
+
+        TPool::TSimpleIterator iterator(pool);
+        if (!degenerateModelIsFinite) {
+            std::cerr << TSolver::Name() << " unregularized ridge model explodes on a singular OLS matrix" << std::endl;
+            ++errorsCount;
+        } else if (!DoublesAreQuiteSimilar(TRegressionMetricsCalculator::Build(iterator, degenerateModel).DeterminationCoefficient(),
+                                           TRegressionMetricsCalculator::Build(iterator, model).DeterminationCoefficient()))
+        {
+            std::cerr << TSolver::Name() << " unregularized ridge model on a singular OLS matrix is worse than the solved one" << std::endl;
+            ++errorsCount;
+        }
+
+        ++testCounters[TSolver::Name()];
+
+        return errorsCount;
+    }
+
+    size_t CheckSparseLRSolver(std::map<std::string, size_t>& testCounters) {
+        std::mt19937 mersenne;
+        std::normal_distribution<double> randGen;
+        std::uniform_int_distribution<size_t> featureGen(0, 59);
+
+        // a few non-zero features out of many, the last ones never taking a value
+        const size_t featuresCount = 64;
+        TPool pool;
+        std::vector<std::vector<TSparseFeature>> sparseRows;
+        for (size_t instanceIdx = 0; instanceIdx < 2000; ++instanceIdx) {
+            TInstance instance;
+            instance.Features.resize(featuresCount);
+            for (size_t nonZeroIdx = 0; nonZeroIdx < 5; ++nonZeroIdx) {
+                instance.Features[featureGen(mersenne)] = randGen(mersenne);
+            }
+            instance.Goal = 0.;
+            for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+                instance.Goal += (featureNumber % 7) * instance.Features[featureNumber];
+            }
+            instance.Goal += 3. + randGen(mersenne) / 10;
+            instance.Weight = 1. + instanceIdx % 3;
+            pool.push_back(instance);
+
+            sparseRows.emplace_back();
+            for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+                if (instance.Features[featureNumber]) {
+                    sparseRows.back().push_back({featureNumber, instance.Features[featureNumber]});
+                }
+            }
+        }
+
+        size_t errorsCount = CheckIfModelsAreEqual<TFastLRSolver, TSparseLRSolver>(pool, testCounters);
+
+        // sparse rows only know the features up to their last non-zero one, the merge widens the narrower solver
+        TFastLRSolver fastSolver;
+        TSparseLRSolver firstHalfSolver;
+        TSparseLRSolver secondHalfSolver;
+        for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+            const TInstanceView instance = pool[instanceIdx];
+            fastSolver.Add(TFeaturesView(instance.Features.data(), 60), instance.Goal, instance.Weight);
+            (instanceIdx < pool.size() / 2 ? firstHalfSolver : secondHalfSolver).Add(sparseRows[instanceIdx], instance.Goal, instance.Weight);
+        }
+        firstHalfSolver.Merge(secondHalfSolver);
+
+        const TLinearModel sparseModel = firstHalfSolver.Solve();
+        errorsCount += CheckIfModelsAreSimilar(sparseModel, fastSolver.Solve(), "sparse LR model on sparse rows differs from the fast LR one");
+        if (sparseModel.Coefficients.size() != 60 || !DoublesAreQuiteSimilar(firstHalfSolver.SumSquaredErrors(), fastSolver.SumSquaredErrors())) {
+            std::cerr << "sparse LR solution on sparse rows differs from the fast LR one" << std::endl;
+            ++errorsCount;
+        }
+
+        // rows out of order, some with a value split between two entries of the same index, are taken as the sorted ones
+        TSparseLRSolver shuffledRowsSolver;
+        for (size_t instanceIdx = 0; instanceIdx < pool.size(); ++instanceIdx) {
+            std::vector<TSparseFeature> shuffledRow = sparseRows[instanceIdx];
+            if (!shuffledRow.empty() && instanceIdx % 2) {
+                shuffledRow.front().Value /= 2;
+                shuffledRow.push_back(shuffledRow.front());
+            }
+            std::shuffle(shuffledRow.begin(), shuffledRow.end(), mersenne);
+            shuffledRowsSolver.Add(shuffledRow, pool[instanceIdx].Goal, pool[instanceIdx].Weight);
+        }
+        errorsCount += CheckIfModelsAreSimilar(shuffledRowsSolver.Solve(), sparseModel, "sparse LR model on shuffled sparse rows differs from the one on sorted rows");
+
+        ++testCounters[TSparseLRSolver::Name()];
+
+        return errorsCount;
+    }
+
+    size_t DoTestLRModels(const TPool& pool) {
+        std::mt19937 mersenne;
+        std::normal_distribution<double> randGen;
+
+        std::vector<TPool> researchPools;
+        researchPools.push_back(pool);
+        const size_t nonZeroMSEPoolsCount = 5;
+        for (size_t nonZeroPoolIdx = 0; nonZeroPoolIdx < nonZeroMSEPoolsCount; ++nonZeroPoolIdx) {
+            TPool nonZeroMSEPool;
+            for (const TInstanceView& instanceView : pool) {
+                TInstance instance = TInstance::FromView(instanceView);
+                instance.Goal += randGen(mersenne) / 10;
+                nonZeroMSEPool.push_back(instance);
+            }
+            researchPools.push_back(nonZeroMSEPool);
+        }
+
+        size_t errorsCount = 0;
+
+        std::map<std::string, size_t> testCounters;
+
+        errorsCount += CheckModelPrecision<TFastLRSolver>(pool, testCounters);
+        errorsCount += CheckModelPrecision<TSparseLRSolver>(pool, testCounters);
+        errorsCount += CheckSparseLRSolver(testCounters);
+        errorsCount += CheckModelPrecision<TWelfordLRSolver>(pool, testCounters);
+        errorsCount += CheckModelPrecision<TNormalizedWelfordLRSolver>(pool, testCounters);
+        errorsCount += CheckModelPrecision<TOnlineLRSolver>(pool, testCounters);
+
+        {
+            TPool leaveOneOutPool;
+            for (size_t instanceIdx = 0; instanceIdx < std::min<size_t>(100, pool.size()); ++instanceIdx) {
+                leaveOneOutPool.push_back(researchPools.back()[instanceIdx]);
+            }
+
+            errorsCount += CheckLeaveOneOut<TFastLRSolver>(leaveOneOutPool, testCounters);
+            errorsCount += CheckLeaveOneOut<TWelfordLRSolver>(leaveOneOutPool, testCounters);
+            errorsCount += CheckLeaveOneOut<TNormalizedWelfordLRSolver>(leaveOneOutPool, testCounters);
+        }
+
+        constexpr size_t featuresCount = SampleFeaturesCount;
+        if (SampleLinearCoefficients().size() != featuresCount) {
+            std::cerr << "sample features count differs from the sample coefficients count" << std::endl;
+            ++errorsCount;
+        }
+
+        errorsCount += CheckModelPrecision<TFixedFastLRSolver<featuresCount>>(pool, testCounters);
+        errorsCount += CheckModelPrecision<TFixedWelfordLRSolver<featuresCount>>(pool, testCounters);
+        errorsCount += CheckModelPrecision<TFixedNormalizedWelfordLRSolver<featuresCount>>(pool, testCounters);
+
+        for (const TPool& researchPool : researchPools) {
+            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TKahanBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TWelfordBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TNormalizedWelfordBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TFastBestSLRSolver, TTypedBestSLRSolver<TFastSLRSolver>>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TKahanBestSLRSolver, TTypedBestSLRSolver<TKahanSLRSolver>>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TWelfordBestSLRSolver, TTypedBestSLRSolver<TWelfordSLRSolver>>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TNormalizedWelfordBestSLRSolver, TTypedBestSLRSolver<TNormalizedWelfordSLRSolver>>(researchPool, testCounters);
+
+            errorsCount += CheckIfModelsAreEqual<TFastLRSolver, TWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TFastLRSolver, TNormalizedWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TFastLRSolver, TSparseLRSolver>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TWelfordLRSolver, TOnlineLRSolver>(researchPool, testCounters);
+
+            errorsCount += CheckIfModelsAreEqual<TFastLRSolver, TFixedFastLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TWelfordLRSolver, TFixedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckIfModelsAreEqual<TNormalizedWelfordLRSolver, TFixedNormalizedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
 
             errorsCount += CheckModelCoefficients<TFastLRSolver>(researchPool, SampleLinearCoefficients(), testCounters);
             errorsCount += CheckModelCoefficients<TWelfordLRSolver>(researchPool, SampleLinearCoefficients(), testCounters);
@@ -248,6 +1702,44 @@ namespace {
             errorsCount += CheckModelSSEPrediction<TFastLRSolver>(researchPool, testCounters);
             errorsCount += CheckModelSSEPrediction<TWelfordLRSolver>(researchPool, testCounters);
             errorsCount += CheckModelSSEPrediction<TNormalizedWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckModelSSEPrediction<TOnlineLRSolver>(researchPool, testCounters);
+
+            errorsCount += CheckFoldModels<TFastBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckFoldModels<TWelfordBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckFoldModels<TFastLRSolver>(researchPool, testCounters);
+            errorsCount += CheckFoldModels<TSparseLRSolver>(researchPool, testCounters);
+            errorsCount += CheckFoldModels<TWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckFoldModels<TNormalizedWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckFoldModels<TFixedNormalizedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckFusedSolver(researchPool, testCounters);
+
+            errorsCount += CheckRidgePath<TFastLRSolver>(researchPool, testCounters);
+            errorsCount += CheckRidgePath<TWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckRidgePath<TNormalizedWelfordLRSolver>(researchPool, testCounters);
+
+            errorsCount += CheckSolution<TFastLRSolver>(researchPool, testCounters);
+            errorsCount += CheckSolution<TSparseLRSolver>(researchPool, testCounters);
+            errorsCount += CheckSolution<TWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckSolution<TNormalizedWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckSolution<TFixedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
+
+            errorsCount += CheckParallelModel<TFastBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TKahanBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TWelfordBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TNormalizedWelfordBestSLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TFastLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TSparseLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TNormalizedWelfordLRSolver>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TOnlineLRSolver>(researchPool, testCounters);
+            errorsCount += CheckOnlineDowndate(researchPool, testCounters);
+            errorsCount += CheckDriftingSolvers(researchPool, testCounters);
+
+            errorsCount += CheckModelSSEPrediction<TFixedFastLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckModelSSEPrediction<TFixedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckModelSSEPrediction<TFixedNormalizedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TFixedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
+            errorsCount += CheckParallelModel<TFixedNormalizedWelfordLRSolver<featuresCount>>(researchPool, testCounters);
         }
 
         std::cout << "linear regression errors: " << errorsCount << std::endl;
@@ -268,7 +1760,14 @@ int DoTest(int argc, const char** argv) {
     size_t errorsCount = 0;
     errorsCount += DoTestIterators(pool);
     errorsCount += DoTestCrossValidationIterators(pool);
+    errorsCount += DoTestFeaturesReader(pool);
+    errorsCount += DoTestFormatReaders(pool);
+    errorsCount += DoTestPoolStorage(pool);
+    errorsCount += DoTestBinaryPool(pool);
+    errorsCount += DoTestLDLDecomposition();
+    errorsCount += DoTestEigenDecomposition();
     errorsCount += DoTestLRModels(pool);
+    errorsCount += DoTestVectorKernels(pool);
 
     std::cerr << std::endl;
     std::cerr << "total errors count: " << errorsCount << std::endl;
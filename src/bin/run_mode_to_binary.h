@@ -0,0 +1,41 @@
+#pragma once
+
+#include "args.h"
+#include "timer.h"
+
+#include "../lib/binary_pool.h"
+#include "../lib/pool.h"
+
+int ToBinary(int argc, const char** argv) {
+    std::string featuresPath;
+    std::string binaryPath;
+    size_t threadsCount = 1;
+    std::string formatName = "auto";
+    {
+        TArgsParser argsParser;
+        argsParser.AddHandler("features", &featuresPath, "features file path").Required();
+        argsParser.AddHandler("binary", &binaryPath, "resulting binary pool path").Required();
+        argsParser.AddHandler("threads", &threadsCount, "features loading threads count").Optional();
+        argsParser.AddHandler("format", &formatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
+        argsParser.DoParse(argc, argv);
+    }
+
+    EPoolFormat format;
+    if (!ParsePoolFormat(formatName, format)) {
+        std::cerr << "unknown pool format: " << formatName << std::endl;
+        return 1;
+    }
+
+    TPool pool;
+    if (!pool.Read(featuresPath, threadsCount, format)) {
+        std::cerr << "could not read pool from " << featuresPath << std::endl;
+        return 1;
+    }
+
+    TTimer timer("binary pool written in");
+    if (!NBinaryPool::Write(pool, binaryPath)) {
+        std::cerr << "could not write binary pool to " << binaryPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -6,14 +6,27 @@
 
 int ToSVMLight(int argc, const char** argv) {
     std::string featuresPath;
+    size_t threadsCount = 1;
+    std::string formatName = "auto";
     {
         TArgsParser argsParser;
-        argsParser.AddHandler("features", &featuresPath, "features file path").Required();
+        argsParser.AddHandler("features", &featuresPath, "features or binary pool file path").Required();
+        argsParser.AddHandler("threads", &threadsCount, "features loading threads count").Optional();
+        argsParser.AddHandler("format", &formatName, "features file format: auto, features, svm-light, vowpal-wabbit or binary").Optional();
         argsParser.DoParse(argc, argv);
     }
 
+    EPoolFormat format;
+    if (!ParsePoolFormat(formatName, format)) {
+        std::cerr << "unknown pool format: " << formatName << std::endl;
+        return 1;
+    }
+
     TPool pool;
-    pool.ReadFromFeatures(featuresPath);
+    if (!pool.Read(featuresPath, threadsCount, format)) {
+        std::cerr << "could not read pool from " << featuresPath << std::endl;
+        return 1;
+    }
     pool.PrintForSVMLight(std::cout);
     return 0;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <chrono>
+#include <ctime>
 #include <iostream>
 #include <string>
 
+#include <time.h>
+
 class TTimer {
 private:
     using TClockType = std::chrono::high_resolution_clock;
@@ -31,3 +34,42 @@ public:
         return (double)diff.count() / 1000000;
     }
 };
+
+// CPU time of the process, summed over all its threads
+class TCPUTimer {
+private:
+    std::clock_t Start;
+
+public:
+    TCPUTimer()
+        : Start(std::clock())
+    {
+    }
+
+    double GetSecondsPassed() const {
+        return (double)(std::clock() - Start) / CLOCKS_PER_SEC;
+    }
+};
+
+// CPU time of the calling thread
+class TThreadCPUTimer {
+private:
+    double Start;
+
+public:
+    TThreadCPUTimer()
+        : Start(Now())
+    {
+    }
+
+    double GetSecondsPassed() const {
+        return Now() - Start;
+    }
+
+private:
+    static double Now() {
+        timespec time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return time.tv_sec + time.tv_nsec / 1e9;
+    }
+};
@@ -0,0 +1,238 @@
+#include "binary_pool.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char BinaryPoolMagic[8] = {'L', 'R', 'P', 'O', 'O', 'L', '\0', '\0'};
+    const uint64_t BinaryPoolVersion = 1;
+
+    uint64_t AlignedOffset(const uint64_t offset) {
+        return (offset + 7) / 8 * 8;
+    }
+
+    class TStringTableBuilder {
+    private:
+        std::unordered_map<std::string, uint32_t> StringIds;
+        std::vector<uint64_t> StringOffsets = {0};
+        std::string Chars;
+
+    public:
+        std::vector<uint32_t> Ids;
+
+        void Add(const std::string_view value) {
+            const auto inserted = StringIds.emplace(std::string(value), (uint32_t)StringIds.size());
+            if (inserted.second) {
+                Chars += value;
+                StringOffsets.push_back(Chars.size());
+            }
+            Ids.push_back(inserted.first->second);
+        }
+
+        // lays the table out starting from the offset, returns the offset right after it
+        uint64_t Place(const uint64_t offset, NBinaryPool::TStringTableHeader& table) const {
+            table.StringsCount = StringIds.size();
+            table.IdsOffset = offset;
+            table.StringOffsetsOffset = AlignedOffset(table.IdsOffset + Ids.size() * sizeof(uint32_t));
+            table.CharsOffset = table.StringOffsetsOffset + StringOffsets.size() * sizeof(uint64_t);
+            table.CharsSize = Chars.size();
+            return AlignedOffset(table.CharsOffset + table.CharsSize);
+        }
+
+        void Write(std::ostream& out, const NBinaryPool::TStringTableHeader& table) const {
+            WriteAt(out, table.IdsOffset, Ids.data(), Ids.size() * sizeof(uint32_t));
+            WriteAt(out, table.StringOffsetsOffset, StringOffsets.data(), StringOffsets.size() * sizeof(uint64_t));
+            WriteAt(out, table.CharsOffset, Chars.data(), Chars.size());
+        }
+
+        // pads the stream with zeros up to the offset and writes the data there
+        static void WriteAt(std::ostream& out, const uint64_t offset, const void* data, const size_t size) {
+            while ((uint64_t)out.tellp() < offset) {
+                out.put('\0');
+            }
+            out.write((const char*)data, size);
+        }
+    };
+}
+
+bool NBinaryPool::IsBinaryPool(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+
+    char magic[sizeof(BinaryPoolMagic)];
+    return in.read(magic, sizeof(magic)) && !memcmp(magic, BinaryPoolMagic, sizeof(magic));
+}
+
+size_t NBinaryPool::Write(const TPool& pool, const std::string& path) {
+    const size_t featuresCount = pool.FeaturesCount();
+
+    TStringTableBuilder queryIds;
+    TStringTableBuilder urls;
+    for (const TInstanceView& instance : pool) {
+        queryIds.Add(instance.QueryId);
+        urls.Add(instance.Url);
+    }
+
+    THeader header;
+    memcpy(header.Magic, BinaryPoolMagic, sizeof(BinaryPoolMagic));
+    header.Version = BinaryPoolVersion;
+    header.InstancesCount = pool.size();
+    header.FeaturesCount = featuresCount;
+    header.FeaturesOffset = AlignedOffset(sizeof(THeader));
+    header.GoalsOffset = header.FeaturesOffset + pool.size() * featuresCount * sizeof(double);
+    header.WeightsOffset = header.GoalsOffset + pool.size() * sizeof(double);
+    const uint64_t urlsOffset = queryIds.Place(header.WeightsOffset + pool.size() * sizeof(double), header.QueryIds);
+    urls.Place(urlsOffset, header.Urls);
+    const uint64_t fileSize = header.Urls.CharsOffset + header.Urls.CharsSize;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*)&header, sizeof(header));
+
+    TStringTableBuilder::WriteAt(out, header.FeaturesOffset, nullptr, 0);
+    for (const TInstanceView& instance : pool) {
+        out.write((const char*)instance.Features.data(), featuresCount * sizeof(double));
+    }
+    for (const TInstanceView& instance : pool) {
+        out.write((const char*)&instance.Goal, sizeof(double));
+    }
+    for (const TInstanceView& instance : pool) {
+        out.write((const char*)&instance.Weight, sizeof(double));
+    }
+
+    queryIds.Write(out, header.QueryIds);
+    urls.Write(out, header.Urls);
+
+    return out ? fileSize : 0;
+}
+
+TMappedPool::~TMappedPool() {
+    Close();
+}
+
+bool TMappedPool::Open(const std::string& path) {
+    Close();
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) || (size_t)fileStat.st_size < sizeof(NBinaryPool::THeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    Data = (const char*)data;
+    Size = fileStat.st_size;
+    Header = (const NBinaryPool::THeader*)Data;
+
+    // the ids are not checked against the string counts not to read the whole file on opening, String checks them instead
+    const bool featuresCountFits = !Header->FeaturesCount || Header->InstancesCount <= std::numeric_limits<uint64_t>::max() / Header->FeaturesCount;
+    const bool isValid = !memcmp(Header->Magic, BinaryPoolMagic, sizeof(BinaryPoolMagic)) &&
+                         Header->Version == BinaryPoolVersion &&
+                         featuresCountFits &&
+                         SectionFits(Header->FeaturesOffset, Header->InstancesCount * Header->FeaturesCount, sizeof(double)) &&
+                         SectionFits(Header->GoalsOffset, Header->InstancesCount, sizeof(double)) &&
+                         SectionFits(Header->WeightsOffset, Header->InstancesCount, sizeof(double)) &&
+                         StringTableFits(Header->QueryIds) &&
+                         StringTableFits(Header->Urls);
+    if (!isValid) {
+        Close();
+        return false;
+    }
+
+    Features = (const double*)(Data + Header->FeaturesOffset);
+    Goals = (const double*)(Data + Header->GoalsOffset);
+    Weights = (const double*)(Data + Header->WeightsOffset);
+
+    return true;
+}
+
+void TMappedPool::Close() {
+    if (Data) {
+        munmap((void*)Data, Size);
+    }
+
+    Data = nullptr;
+    Size = 0;
+    Header = nullptr;
+    Features = Goals = Weights = nullptr;
+}
+
+size_t TMappedPool::GetFileSize() const {
+    return Size;
+}
+
+size_t TMappedPool::InstancesCount() const {
+    return Header ? Header->InstancesCount : 0;
+}
+
+size_t TMappedPool::FeaturesCount() const {
+    return Header ? Header->FeaturesCount : 0;
+}
+
+const double* TMappedPool::InstanceFeatures(const size_t instanceIdx) const {
+    return Features + instanceIdx * Header->FeaturesCount;
+}
+
+double TMappedPool::Goal(const size_t instanceIdx) const {
+    return Goals[instanceIdx];
+}
+
+double TMappedPool::Weight(const size_t instanceIdx) const {
+    return Weights[instanceIdx];
+}
+
+std::string_view TMappedPool::QueryId(const size_t instanceIdx) const {
+    return String(Header->QueryIds, instanceIdx);
+}
+
+std::string_view TMappedPool::Url(const size_t instanceIdx) const {
+    return String(Header->Urls, instanceIdx);
+}
+
+// the strings with an id or offsets out of the table are read as empty ones
+std::string_view TMappedPool::String(const NBinaryPool::TStringTableHeader& table, const size_t instanceIdx) const {
+    const uint32_t stringId = ((const uint32_t*)(Data + table.IdsOffset))[instanceIdx];
+    if (stringId >= table.StringsCount) {
+        return std::string_view();
+    }
+
+    const uint64_t* stringOffsets = (const uint64_t*)(Data + table.StringOffsetsOffset);
+    const uint64_t stringBegin = stringOffsets[stringId];
+    const uint64_t stringEnd = stringOffsets[stringId + 1];
+    if (stringBegin > stringEnd || stringEnd > table.CharsSize) {
+        return std::string_view();
+    }
+    return std::string_view(Data + table.CharsOffset + stringBegin, stringEnd - stringBegin);
+}
+
+bool TMappedPool::SectionFits(const uint64_t offset, const uint64_t count, const uint64_t elementSize) const {
+    return offset % 8 == 0 && offset <= Size && (!elementSize || count <= (Size - offset) / elementSize);
+}
+
+bool TMappedPool::StringTableFits(const NBinaryPool::TStringTableHeader& table) const {
+    if (table.StringsCount == std::numeric_limits<uint64_t>::max() ||
+        !SectionFits(table.IdsOffset, Header->InstancesCount, sizeof(uint32_t)) ||
+        !SectionFits(table.StringOffsetsOffset, table.StringsCount + 1, sizeof(uint64_t)) ||
+        table.CharsOffset > Size || table.CharsSize > Size - table.CharsOffset)
+    {
+        return false;
+    }
+
+    const uint64_t* stringOffsets = (const uint64_t*)(Data + table.StringOffsetsOffset);
+    return stringOffsets[table.StringsCount] <= table.CharsSize;
+}
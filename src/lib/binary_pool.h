@@ -0,0 +1,83 @@
+#pragma once
+
+#include "pool.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Binary pool files are a header followed by 8-byte aligned sections: the row-major features matrix,
+// the goals and weights columns and a string table for each of QueryId and Url, which stores every
+// distinct value once along with a per-instance id. Numbers are kept in the native byte order,
+// so the files are meant to be read on the machine type they were written on.
+namespace NBinaryPool {
+    struct TStringTableHeader {
+        uint64_t StringsCount;
+        uint64_t IdsOffset;
+        uint64_t StringOffsetsOffset;
+        uint64_t CharsOffset;
+        uint64_t CharsSize;
+    };
+
+    struct THeader {
+        char Magic[8];
+        uint64_t Version;
+
+        uint64_t InstancesCount;
+        uint64_t FeaturesCount;
+
+        uint64_t FeaturesOffset;
+        uint64_t GoalsOffset;
+        uint64_t WeightsOffset;
+
+        TStringTableHeader QueryIds;
+        TStringTableHeader Urls;
+    };
+
+    bool IsBinaryPool(const std::string& path);
+
+    // returns the size of the file written
+    size_t Write(const TPool& pool, const std::string& path);
+}
+
+// Read-only mapping of a binary pool file: opening it costs a few system calls whatever the pool size,
+// and the pages are read on the first access.
+class TMappedPool {
+private:
+    const char* Data = nullptr;
+    size_t Size = 0;
+
+    const NBinaryPool::THeader* Header = nullptr;
+
+    const double* Features = nullptr;
+    const double* Goals = nullptr;
+    const double* Weights = nullptr;
+
+public:
+    TMappedPool() = default;
+    ~TMappedPool();
+
+    TMappedPool(const TMappedPool&) = delete;
+    TMappedPool& operator=(const TMappedPool&) = delete;
+
+    // returns false if the file is missing or is not a well-formed binary pool
+    bool Open(const std::string& path);
+    void Close();
+
+    size_t GetFileSize() const;
+
+    size_t InstancesCount() const;
+    size_t FeaturesCount() const;
+
+    const double* InstanceFeatures(const size_t instanceIdx) const;
+    double Goal(const size_t instanceIdx) const;
+    double Weight(const size_t instanceIdx) const;
+
+    std::string_view QueryId(const size_t instanceIdx) const;
+    std::string_view Url(const size_t instanceIdx) const;
+
+private:
+    std::string_view String(const NBinaryPool::TStringTableHeader& table, const size_t instanceIdx) const;
+    bool SectionFits(const uint64_t offset, const uint64_t count, const uint64_t elementSize) const;
+    bool StringTableFits(const NBinaryPool::TStringTableHeader& table) const;
+};
@@ -0,0 +1,254 @@
+#include "eigen_decomposition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void TSymmetricEigenDecomposition::Decompose(const std::vector<double>& linearizedMatrix, const size_t size, const bool computeEigenvectors) {
+    Size = size;
+    Eigenvalues.assign(size, 0.);
+    OffDiagonal.assign(size, 0.);
+    Eigenvectors.resize(size * size);
+
+    size_t matrixElementIdx = 0;
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = row; column < size; ++column) {
+            Eigenvector(row, column) = Eigenvector(column, row) = linearizedMatrix[matrixElementIdx];
+            ++matrixElementIdx;
+        }
+    }
+
+    if (!size) {
+        return;
+    }
+
+    Tridiagonalize(computeEigenvectors);
+    DiagonalizeTridiagonal(computeEigenvectors);
+}
+
+void TSymmetricEigenDecomposition::Project(const std::vector<double>& vector, std::vector<double>& projections) const {
+    projections.assign(Size, 0.);
+    for (size_t row = 0; row < Size; ++row) {
+        const double* eigenvectorsRow = &Eigenvectors[row * Size];
+        for (size_t column = 0; column < Size; ++column) {
+            projections[column] += eigenvectorsRow[column] * vector[row];
+        }
+    }
+}
+
+void TSymmetricEigenDecomposition::SolveProjected(const std::vector<double>& projections, const double regularizationParameter, std::vector<double>& solution) const {
+    std::vector<double> scaledProjections(Size);
+    for (size_t idx = 0; idx < Size; ++idx) {
+        const double eigenvalue = Eigenvalues[idx] + regularizationParameter;
+        scaledProjections[idx] = eigenvalue ? projections[idx] / eigenvalue : 0.;
+    }
+
+    solution.assign(Size, 0.);
+    for (size_t row = 0; row < Size; ++row) {
+        const double* eigenvectorsRow = &Eigenvectors[row * Size];
+        for (size_t column = 0; column < Size; ++column) {
+            solution[row] += eigenvectorsRow[column] * scaledProjections[column];
+        }
+    }
+}
+
+size_t TSymmetricEigenDecomposition::GetSize() const {
+    return Size;
+}
+
+const std::vector<double>& TSymmetricEigenDecomposition::GetEigenvalues() const {
+    return Eigenvalues;
+}
+
+double TSymmetricEigenDecomposition::GetMinEigenvalue() const {
+    return Eigenvalues.empty() ? 0. : *std::min_element(Eigenvalues.begin(), Eigenvalues.end());
+}
+
+// Householder reduction; the diagonal of the tridiagonal matrix goes to Eigenvalues, the subdiagonal to OffDiagonal
+void TSymmetricEigenDecomposition::Tridiagonalize(const bool computeEigenvectors) {
+    const size_t size = Size;
+    std::vector<double>& d = Eigenvalues;
+    std::vector<double>& e = OffDiagonal;
+
+    for (size_t column = 0; column < size; ++column) {
+        d[column] = Eigenvector(size - 1, column);
+    }
+
+    for (size_t i = size - 1; i > 0; --i) {
+        double scale = 0.;
+        double h = 0.;
+        for (size_t k = 0; k < i; ++k) {
+            scale += fabs(d[k]);
+        }
+
+        if (!scale) {
+            e[i] = d[i - 1];
+            for (size_t j = 0; j < i; ++j) {
+                d[j] = Eigenvector(i - 1, j);
+                Eigenvector(i, j) = 0.;
+                Eigenvector(j, i) = 0.;
+            }
+        } else {
+            for (size_t k = 0; k < i; ++k) {
+                d[k] /= scale;
+                h += d[k] * d[k];
+            }
+
+            double f = d[i - 1];
+            double g = f > 0 ? -sqrt(h) : sqrt(h);
+            e[i] = scale * g;
+            h -= f * g;
+            d[i - 1] = f - g;
+            for (size_t j = 0; j < i; ++j) {
+                e[j] = 0.;
+            }
+
+            for (size_t j = 0; j < i; ++j) {
+                f = d[j];
+                Eigenvector(j, i) = f;
+                g = e[j] + Eigenvector(j, j) * f;
+                for (size_t k = j + 1; k < i; ++k) {
+                    g += Eigenvector(k, j) * d[k];
+                    e[k] += Eigenvector(k, j) * f;
+                }
+                e[j] = g;
+            }
+
+            f = 0.;
+            for (size_t j = 0; j < i; ++j) {
+                e[j] /= h;
+                f += e[j] * d[j];
+            }
+            const double hh = f / (h + h);
+            for (size_t j = 0; j < i; ++j) {
+                e[j] -= hh * d[j];
+            }
+
+            for (size_t j = 0; j < i; ++j) {
+                f = d[j];
+                g = e[j];
+                for (size_t k = j; k < i; ++k) {
+                    Eigenvector(k, j) -= f * e[k] + g * d[k];
+                }
+                d[j] = Eigenvector(i - 1, j);
+                Eigenvector(i, j) = 0.;
+            }
+        }
+        d[i] = h;
+    }
+
+    if (!computeEigenvectors) {
+        for (size_t j = 0; j < size; ++j) {
+            d[j] = Eigenvector(j, j);
+        }
+        e[0] = 0.;
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < size; ++i) {
+        Eigenvector(size - 1, i) = Eigenvector(i, i);
+        Eigenvector(i, i) = 1.;
+        const double h = d[i + 1];
+        if (h) {
+            for (size_t k = 0; k <= i; ++k) {
+                d[k] = Eigenvector(k, i + 1) / h;
+            }
+            for (size_t j = 0; j <= i; ++j) {
+                double g = 0.;
+                for (size_t k = 0; k <= i; ++k) {
+                    g += Eigenvector(k, i + 1) * Eigenvector(k, j);
+                }
+                for (size_t k = 0; k <= i; ++k) {
+                    Eigenvector(k, j) -= g * d[k];
+                }
+            }
+        }
+        for (size_t k = 0; k <= i; ++k) {
+            Eigenvector(k, i + 1) = 0.;
+        }
+    }
+    for (size_t j = 0; j < size; ++j) {
+        d[j] = Eigenvector(size - 1, j);
+        Eigenvector(size - 1, j) = 0.;
+    }
+    Eigenvector(size - 1, size - 1) = 1.;
+    e[0] = 0.;
+}
+
+// implicit QL iterations with Wilkinson shifts over the tridiagonal matrix
+void TSymmetricEigenDecomposition::DiagonalizeTridiagonal(const bool computeEigenvectors) {
+    const size_t size = Size;
+    std::vector<double>& d = Eigenvalues;
+    std::vector<double>& e = OffDiagonal;
+
+    for (size_t i = 1; i < size; ++i) {
+        e[i - 1] = e[i];
+    }
+    e[size - 1] = 0.;
+
+    const double epsilon = std::numeric_limits<double>::epsilon();
+
+    double f = 0.;
+    double maxNorm = 0.;
+    for (size_t l = 0; l < size; ++l) {
+        maxNorm = std::max(maxNorm, fabs(d[l]) + fabs(e[l]));
+        size_t m = l;
+        while (m + 1 < size && fabs(e[m]) > epsilon * maxNorm) {
+            ++m;
+        }
+
+        if (m > l) {
+            do {
+                double g = d[l];
+                double p = (d[l + 1] - g) / (2. * e[l]);
+                double r = std::hypot(p, 1.);
+                if (p < 0) {
+                    r = -r;
+                }
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                const double dl1 = d[l + 1];
+                double h = g - d[l];
+                for (size_t i = l + 2; i < size; ++i) {
+                    d[i] -= h;
+                }
+                f += h;
+
+                p = d[m];
+                double c = 1.;
+                double c2 = c;
+                double c3 = c;
+                const double el1 = e[l + 1];
+                double s = 0.;
+                double s2 = 0.;
+                for (size_t i = m; i-- > l;) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = std::hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+
+                    if (computeEigenvectors) {
+                        for (size_t k = 0; k < size; ++k) {
+                            double* eigenvectorsRow = &Eigenvectors[k * size];
+                            h = eigenvectorsRow[i + 1];
+                            eigenvectorsRow[i + 1] = s * eigenvectorsRow[i] + c * h;
+                            eigenvectorsRow[i] = c * eigenvectorsRow[i] - s * h;
+                        }
+                    }
+                }
+                p = -s * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+            } while (fabs(e[l]) > epsilon * maxNorm);
+        }
+        d[l] += f;
+        e[l] = 0.;
+    }
+}
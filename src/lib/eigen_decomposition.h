@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Eigendecomposition of a symmetric matrix given as a packed upper triangle: Householder reduction to
+// a tridiagonal form followed by the implicit QL iterations, as in the tred2 and tql2 routines of EISPACK.
+//
+// Once decomposed, the matrix regularized with any parameter is solved in O(size^2), which makes whole
+// ridge paths as cheap as a single factorization.
+class TSymmetricEigenDecomposition {
+private:
+    size_t Size = 0;
+
+    std::vector<double> Eigenvalues;
+    // row-major size x size matrix, the columns are the eigenvectors
+    std::vector<double> Eigenvectors;
+
+    std::vector<double> OffDiagonal;
+
+public:
+    void Decompose(const std::vector<double>& linearizedMatrix, const size_t size, const bool computeEigenvectors = true);
+
+    // projections of the vector onto the eigenvectors, to be shared by the solutions with different regularizations
+    void Project(const std::vector<double>& vector, std::vector<double>& projections) const;
+
+    // solves (matrix + regularizationParameter * I) * solution = rightHandSide given the projections of the right-hand side
+    void SolveProjected(const std::vector<double>& projections, const double regularizationParameter, std::vector<double>& solution) const;
+
+    size_t GetSize() const;
+    const std::vector<double>& GetEigenvalues() const;
+    double GetMinEigenvalue() const;
+
+private:
+    void Tridiagonalize(const bool computeEigenvectors);
+    void DiagonalizeTridiagonal(const bool computeEigenvectors);
+
+    double& Eigenvector(const size_t row, const size_t column) {
+        return Eigenvectors[row * Size + column];
+    }
+};
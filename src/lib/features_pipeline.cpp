@@ -0,0 +1,257 @@
+#include "features_pipeline.h"
+#include "features_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+TFeaturesPipeline::TFeaturesPipeline(const std::string& featuresPath,
+                                     const EPoolFormat format,
+                                     const size_t parsersCount,
+                                     const size_t featuresCount,
+                                     const size_t queueCapacity,
+                                     const size_t blockSize)
+    : FeaturesPath(featuresPath)
+    , Format(format)
+    , BlockSize(std::max<size_t>(blockSize, 1))
+    , FeaturesCount(featuresCount)
+{
+    for (size_t parserIdx = 0; parserIdx < std::max<size_t>(parsersCount, 1); ++parserIdx) {
+        BlockQueues.emplace_back(new TSPSCQueue<std::vector<char>>(queueCapacity));
+        ParsedQueues.emplace_back(new TSPSCQueue<TParsedBlock>(queueCapacity));
+    }
+
+    Threads.emplace_back([this]() {
+        ReadBlocks();
+    });
+    for (size_t parserIdx = 0; parserIdx < ParsedQueues.size(); ++parserIdx) {
+        Threads.emplace_back([this, parserIdx]() {
+            ParseBlocks(parserIdx);
+        });
+    }
+}
+
+TFeaturesPipeline::~TFeaturesPipeline() {
+    Stop = true;
+    JoinThreads();
+}
+
+bool TFeaturesPipeline::Next() {
+    if (WideInstanceFeaturesCount) {
+        return false;
+    }
+
+    while (RowIdx == Block.Goals.size()) {
+        if (!ParsedQueues[BlocksCount % ParsedQueues.size()]->Pop(Block)) {
+            // every stage is done once the queue of the next block is closed and drained
+            JoinThreads();
+            IsInstanceValid = false;
+            return false;
+        }
+        ++BlocksCount;
+        RowIdx = 0;
+    }
+
+    const size_t rowBegin = RowIdx ? Block.RowEnds[RowIdx - 1] : 0;
+    const size_t rowSize = Block.RowEnds[RowIdx] - rowBegin;
+    if (!FeaturesCount) {
+        FeaturesCount = rowSize;
+    }
+
+    if (rowSize > FeaturesCount) {
+        WideInstanceFeaturesCount = rowSize;
+        Stop = true;
+        JoinThreads();
+        IsInstanceValid = false;
+        return false;
+    }
+
+    const double* row = Block.Features.data() + rowBegin;
+    if (rowSize < FeaturesCount) {
+        PaddedRow.assign(row, row + rowSize);
+        PaddedRow.resize(FeaturesCount, 0.);
+        row = PaddedRow.data();
+    }
+
+    Instance.Features = TFeaturesView(row, FeaturesCount);
+    Instance.Goal = Block.Goals[RowIdx];
+    Instance.Weight = Block.Weights[RowIdx];
+
+    ++RowIdx;
+    ++InstanceIdx;
+    IsInstanceValid = true;
+
+    return true;
+}
+
+size_t TFeaturesPipeline::GetBytesRead() const {
+    return BytesRead;
+}
+
+std::vector<TPipelineStageStats> TFeaturesPipeline::GetStats() const {
+    TPipelineStageStats readerStats;
+    TPipelineStageStats parsersStats;
+    TPipelineStageStats solverStats;
+    readerStats.Name = "reader";
+    parsersStats.Name = "parsers";
+    solverStats.Name = "solver";
+
+    const auto addStalls = [](TQueueStalls& stalls, const TQueueStalls& queueStalls) {
+        stalls.Count += queueStalls.Count;
+        stalls.Seconds += queueStalls.Seconds;
+    };
+    const auto addOutput = [&addStalls](TPipelineStageStats& stats, const auto& queue) {
+        stats.ItemsCount += queue.GetPushesCount();
+        stats.MeanOutputOccupancy += queue.GetMeanOccupancy() * queue.GetPushesCount();
+        stats.OutputCapacity += queue.Capacity();
+        addStalls(stats.OutputStalls, queue.GetFullStalls());
+    };
+
+    for (size_t parserIdx = 0; parserIdx < ParsedQueues.size(); ++parserIdx) {
+        addOutput(readerStats, *BlockQueues[parserIdx]);
+        addOutput(parsersStats, *ParsedQueues[parserIdx]);
+
+        addStalls(parsersStats.InputStalls, BlockQueues[parserIdx]->GetEmptyStalls());
+        addStalls(solverStats.InputStalls, ParsedQueues[parserIdx]->GetEmptyStalls());
+    }
+    for (TPipelineStageStats* stats : {&readerStats, &parsersStats}) {
+        stats->MeanOutputOccupancy = stats->ItemsCount ? stats->MeanOutputOccupancy / stats->ItemsCount : 0.;
+    }
+    solverStats.ItemsCount = InstanceIdx + 1;
+
+    return {readerStats, parsersStats, solverStats};
+}
+
+void TFeaturesPipeline::JoinThreads() {
+    for (std::thread& thread : Threads) {
+        thread.join();
+    }
+    Threads.clear();
+}
+
+void TFeaturesPipeline::ReadBlocks() {
+    std::ifstream featuresIn(FeaturesPath == "-" ? "/dev/stdin" : FeaturesPath, std::ios::binary);
+    OpenFailed = !featuresIn.is_open();
+
+    std::vector<char> tail;
+    for (size_t blockIdx = 0; featuresIn && !Stop;) {
+        std::vector<char> block;
+        block.swap(tail);
+
+        const size_t tailSize = block.size();
+        block.resize(tailSize + BlockSize);
+        featuresIn.read(block.data() + tailSize, BlockSize);
+        BytesRead += featuresIn.gcount();
+        block.resize(tailSize + featuresIn.gcount());
+
+        // the last line of the block goes to the next one unless the file is over
+        if (featuresIn) {
+            size_t blockEnd = block.size();
+            while (blockEnd && block[blockEnd - 1] != '\n') {
+                --blockEnd;
+            }
+            tail.assign(block.begin() + blockEnd, block.end());
+            block.resize(blockEnd);
+        }
+
+        if (!block.empty()) {
+            if (!BlockQueues[blockIdx % BlockQueues.size()]->Push(block, Stop)) {
+                break;
+            }
+            ++blockIdx;
+        }
+    }
+
+    for (auto& blockQueue : BlockQueues) {
+        blockQueue->Close();
+    }
+}
+
+void TFeaturesPipeline::ParseBlocks(const size_t parserIdx) {
+    TSPSCQueue<std::vector<char>>& blockQueue = *BlockQueues[parserIdx];
+    TSPSCQueue<TParsedBlock>& parsedQueue = *ParsedQueues[parserIdx];
+
+    std::vector<char> block;
+    while (blockQueue.Pop(block)) {
+        // even the blocks without instances are passed on, keeping the round-robin order of the consumer
+        TParsedBlock parsedBlock;
+        ParseBlock(block, Format, parsedBlock);
+        if (!parsedQueue.Push(parsedBlock, Stop)) {
+            break;
+        }
+    }
+
+    parsedQueue.Close();
+}
+
+// the same lines are taken as by TFeaturesReader::Next
+void TFeaturesPipeline::ParseBlock(const std::vector<char>& block, const EPoolFormat format, TParsedBlock& parsedBlock) {
+    TInstance instance;
+
+    const char* begin = block.data();
+    const char* blockEnd = block.data() + block.size();
+    while (begin != blockEnd) {
+        const char* end = static_cast<const char*>(memchr(begin, '\n', blockEnd - begin));
+        end = end ? end : blockEnd;
+
+        if (begin != end) {
+            instance.Features.clear();
+            bool isInstance = true;
+            if (format == PF_SVM_LIGHT) {
+                isInstance = TFeaturesReader::ParseSVMLightLine(begin, end, instance);
+            } else if (format == PF_VOWPAL_WABBIT) {
+                TFeaturesReader::ParseVowpalWabbitLine(begin, end, instance);
+            } else {
+                TFeaturesReader::ParseLine(begin, end, instance);
+            }
+
+            if (isInstance) {
+                parsedBlock.Features.insert(parsedBlock.Features.end(), instance.Features.begin(), instance.Features.end());
+                parsedBlock.RowEnds.push_back(parsedBlock.Features.size());
+                parsedBlock.Goals.push_back(instance.Goal);
+                parsedBlock.Weights.push_back(instance.Weight);
+            }
+        }
+
+        begin = end == blockEnd ? end : end + 1;
+    }
+}
+
+TFeaturesPipelineIterator::TFeaturesPipelineIterator(const std::string& featuresPath, const EPoolFormat format, const size_t parsersCount, const size_t featuresCount)
+    : Pipeline(std::make_shared<TFeaturesPipeline>(featuresPath, format == PF_AUTO ? TFeaturesReader::DetectFormat(featuresPath) : format, parsersCount, featuresCount))
+{
+    Pipeline->Next();
+}
+
+bool TFeaturesPipelineIterator::IsValid() const {
+    return Pipeline->IsValid();
+}
+
+const TInstanceView& TFeaturesPipelineIterator::operator*() const {
+    return Pipeline->GetInstance();
+}
+
+const TInstanceView* TFeaturesPipelineIterator::operator->() const {
+    return &Pipeline->GetInstance();
+}
+
+TFeaturesPipelineIterator& TFeaturesPipelineIterator::operator++() {
+    Pipeline->Next();
+    return *this;
+}
+
+size_t TFeaturesPipelineIterator::GetInstanceIdx() const {
+    return Pipeline->GetInstanceIdx();
+}
+
+size_t TFeaturesPipelineIterator::GetBytesRead() const {
+    return Pipeline->GetBytesRead();
+}
+
+size_t TFeaturesPipelineIterator::GetWideInstanceFeaturesCount() const {
+    return Pipeline->GetWideInstanceFeaturesCount();
+}
+
+bool TFeaturesPipelineIterator::IsOpen() const {
+    return Pipeline->IsOpen();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "pool.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Queue counters of a pipeline stage: the values it got and the waits for its input and its output.
+struct TPipelineStageStats {
+    std::string Name;
+    size_t ItemsCount = 0;
+
+    TQueueStalls InputStalls;
+    TQueueStalls OutputStalls;
+
+    // mean number of values waiting in the output queues on a push and their total capacity
+    double MeanOutputOccupancy = 0.;
+    size_t OutputCapacity = 0;
+};
+
+// Reads a text pool in three overlapping stages: a reader thread cuts the file into blocks of whole lines,
+// parser threads turn the blocks into rows of numbers and the consumer, the thread using the iterator,
+// feeds them to a solver. Block i goes to parser i % ParsersCount through a bounded lock-free queue
+// of its own, and the consumer takes the parsed blocks from the parsers' queues in the same round-robin
+// order, so the instances come in the order of the file whatever the timing of the parsers.
+// Like TFeaturesStreamIterator, the rows get the features count given or the one of the first instance,
+// the pipeline stops at a wider row, and the strings are not kept.
+class TFeaturesPipeline {
+private:
+    struct TParsedBlock {
+        std::vector<double> Features;
+        std::vector<size_t> RowEnds;
+        std::vector<double> Goals;
+        std::vector<double> Weights;
+    };
+
+    std::string FeaturesPath;
+    EPoolFormat Format;
+    size_t BlockSize;
+
+    std::vector<std::unique_ptr<TSPSCQueue<std::vector<char>>>> BlockQueues;
+    std::vector<std::unique_ptr<TSPSCQueue<TParsedBlock>>> ParsedQueues;
+
+    std::atomic<bool> Stop{false};
+    std::atomic<bool> OpenFailed{false};
+    std::vector<std::thread> Threads;
+    size_t BytesRead = 0;
+
+    // consumer state
+    TParsedBlock Block;
+    size_t BlocksCount = 0;
+    size_t RowIdx = 0;
+    size_t FeaturesCount;
+    std::vector<double> PaddedRow;
+    TInstanceView Instance;
+    size_t InstanceIdx = (size_t)-1;
+    bool IsInstanceValid = false;
+    size_t WideInstanceFeaturesCount = 0;
+
+public:
+    TFeaturesPipeline(const std::string& featuresPath,
+                      const EPoolFormat format,
+                      const size_t parsersCount,
+                      const size_t featuresCount = 0,
+                      const size_t queueCapacity = 8,
+                      const size_t blockSize = 1 << 20);
+    ~TFeaturesPipeline();
+
+    TFeaturesPipeline(const TFeaturesPipeline&) = delete;
+    TFeaturesPipeline& operator=(const TFeaturesPipeline&) = delete;
+
+    // moves to the next instance, returns false at the end of the file
+    bool Next();
+
+    bool IsValid() const {
+        return IsInstanceValid;
+    }
+
+    const TInstanceView& GetInstance() const {
+        return Instance;
+    }
+
+    size_t GetInstanceIdx() const {
+        return InstanceIdx;
+    }
+
+    // features count of the instance the pipeline stopped at for being wider than the rows, 0 if it did not stop so
+    size_t GetWideInstanceFeaturesCount() const {
+        return WideInstanceFeaturesCount;
+    }
+
+    // false if the reader could not open the file; the pipeline is empty then, so it is known once Next returns
+    bool IsOpen() const {
+        return !OpenFailed;
+    }
+
+    // the counters are complete once the iteration is over
+    size_t GetBytesRead() const;
+    std::vector<TPipelineStageStats> GetStats() const;
+
+private:
+    void JoinThreads();
+    void ReadBlocks();
+    void ParseBlocks(const size_t parserIdx);
+    static void ParseBlock(const std::vector<char>& block, const EPoolFormat format, TParsedBlock& parsedBlock);
+};
+
+// The pipeline behind the interface of the pool iterators; copies share the reading position.
+class TFeaturesPipelineIterator {
+private:
+    std::shared_ptr<TFeaturesPipeline> Pipeline;
+
+public:
+    // the format of a file is detected if it is PF_AUTO, the standard input ("-") is read as a features file then
+    TFeaturesPipelineIterator(const std::string& featuresPath, const EPoolFormat format, const size_t parsersCount, const size_t featuresCount = 0);
+
+    bool IsValid() const;
+    const TInstanceView& operator*() const;
+    const TInstanceView* operator->() const;
+    TFeaturesPipelineIterator& operator++();
+    size_t GetInstanceIdx() const;
+    size_t GetBytesRead() const;
+    size_t GetWideInstanceFeaturesCount() const;
+    // known on construction, which reads the first instance
+    bool IsOpen() const;
+
+    const TFeaturesPipeline& GetPipeline() const {
+        return *Pipeline;
+    }
+};
@@ -0,0 +1,448 @@
+#include "features_reader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace {
+    inline bool IsSpace(const char symbol) {
+        return symbol == ' ' || symbol == '\t' || symbol == '\n' || symbol == '\r' || symbol == '\v' || symbol == '\f';
+    }
+
+    // moves begin to the start of the next whitespace-separated token and returns its end
+    inline const char* NextToken(const char*& begin, const char* end) {
+        while (begin != end && IsSpace(*begin)) {
+            ++begin;
+        }
+        const char* tokenEnd = begin;
+        while (tokenEnd != end && !IsSpace(*tokenEnd)) {
+            ++tokenEnd;
+        }
+        return tokenEnd;
+    }
+
+    // parses the number at the start of the next token like operator>> does, leaving begin right after it;
+    // unlike operator>>, std::from_chars takes neither the leading plus nor inf and nan, so they are handled here
+    inline bool ParseDouble(const char*& begin, const char* end, double& value) {
+        while (begin != end && IsSpace(*begin)) {
+            ++begin;
+        }
+        const char* numberBegin = begin != end && *begin == '+' ? begin + 1 : begin;
+        if (numberBegin == end || isalpha(static_cast<unsigned char>(*numberBegin))) {
+            return false;
+        }
+
+        const std::from_chars_result result = std::from_chars(numberBegin, end, value);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        begin = result.ptr;
+        return true;
+    }
+
+    inline const char* TrimmedEnd(const char* begin, const char* end) {
+        while (end != begin && IsSpace(end[-1])) {
+            --end;
+        }
+        return end;
+    }
+
+    // the whole of [begin, end) has to be a non-negative integer
+    inline bool ParseIndex(const char* begin, const char* end, size_t& index) {
+        const std::from_chars_result result = std::from_chars(begin, end, index);
+        return begin != end && result.ec == std::errc() && result.ptr == end;
+    }
+
+    // the whole of [begin, end) has to be a number
+    inline bool ParseValue(const char* begin, const char* end, double& value) {
+        const char* numberBegin = begin;
+        return ParseDouble(numberBegin, end, value) && numberBegin == end;
+    }
+
+    // the '|' opening the first namespace of a Vowpal Wabbit line follows the label, the importance, the base and the 'tag,
+    // all of them optional; a '|' anywhere else, in an url of a features line say, tells nothing
+    bool HasVowpalWabbitHeader(const char* begin, const char* end) {
+        for (size_t tokenIdx = 0; tokenIdx < 4; ++tokenIdx) {
+            const char* tokenEnd = NextToken(begin, end);
+            if (begin == tokenEnd) {
+                return false;
+            }
+
+            const char* bar = static_cast<const char*>(memchr(begin, '|', tokenEnd - begin));
+            const char* headerEnd = bar ? bar : tokenEnd;
+            double value;
+            if (begin != headerEnd && *begin != '\'' && !ParseValue(begin, headerEnd, value)) {
+                return false;
+            }
+            if (bar) {
+                return true;
+            }
+            begin = tokenEnd;
+        }
+        return false;
+    }
+
+    inline void SetFeature(TInstance& instance, const size_t index, const double value) {
+        if (index >= instance.Features.size()) {
+            instance.Features.resize(index + 1, 0.);
+        }
+        instance.Features[index] = value;
+    }
+}
+
+TFeaturesReader::TFeaturesReader(const std::string& featuresPath, const size_t bufferSize)
+    : TFeaturesReader(featuresPath, PF_FEATURES, 0, std::numeric_limits<size_t>::max(), bufferSize)
+{
+}
+
+TFeaturesReader::TFeaturesReader(const std::string& featuresPath, const EPoolFormat format, const size_t rangeBegin, const size_t rangeEnd, const size_t bufferSize)
+    : FeaturesIn(featuresPath, std::ios::binary)
+    , Format(format)
+    , Buffer(std::max<size_t>(bufferSize, 1))
+    , RangeEnd(rangeEnd)
+{
+    if (!rangeBegin) {
+        return;
+    }
+
+    // the line running through rangeBegin - 1 belongs to the previous range
+    BufferOffset = rangeBegin - 1;
+    FeaturesIn.seekg(BufferOffset);
+
+    const char* begin;
+    const char* end;
+    size_t lineOffset;
+    FindLine(begin, end, lineOffset);
+}
+
+bool TFeaturesReader::Next(TInstance& instance) {
+    const char* begin;
+    const char* end;
+    size_t lineOffset;
+    while (true) {
+        if (!FindLine(begin, end, lineOffset) || lineOffset >= RangeEnd) {
+            return false;
+        }
+        if (begin == end) {
+            continue;
+        }
+
+        instance.Features.clear();
+        instance.Features.reserve(FeaturesCount);
+        if (Format == PF_SVM_LIGHT) {
+            if (ParseSVMLightLine(begin, end, instance)) {
+                break;
+            }
+        } else if (Format == PF_VOWPAL_WABBIT) {
+            ParseVowpalWabbitLine(begin, end, instance);
+            break;
+        } else {
+            ParseLine(begin, end, instance);
+            break;
+        }
+    }
+    if (!FeaturesCount) {
+        FeaturesCount = instance.Features.size();
+    }
+
+    return true;
+}
+
+size_t TFeaturesReader::GetBytesRead() const {
+    return BytesRead;
+}
+
+bool TFeaturesReader::IsOpen() const {
+    return FeaturesIn.is_open();
+}
+
+// a failed extraction stops the string stream, so does a failed field here
+void TFeaturesReader::ParseLine(const char* begin, const char* end, TInstance& instance) {
+    instance.Url.clear();
+    instance.Weight = 1.;
+
+    const char* tokenEnd = NextToken(begin, end);
+    instance.QueryId.assign(begin, tokenEnd);
+    begin = tokenEnd;
+
+    if (instance.QueryId.empty() || !ParseDouble(begin, end, instance.Goal)) {
+        instance.Goal = 0.;
+        return;
+    }
+
+    tokenEnd = NextToken(begin, end);
+    if (begin == tokenEnd) {
+        return;
+    }
+    instance.Url.assign(begin, tokenEnd);
+    begin = tokenEnd;
+
+    double weight;
+    if (!ParseDouble(begin, end, weight)) {
+        return;
+    }
+
+    double feature;
+    while (ParseDouble(begin, end, feature)) {
+        instance.Features.push_back(feature);
+    }
+}
+
+bool TFeaturesReader::ParseSVMLightLine(const char* begin, const char* end, TInstance& instance) {
+    instance.QueryId.clear();
+    instance.Url.clear();
+    instance.Goal = 0.;
+    instance.Weight = 1.;
+
+    const char* commentBegin = static_cast<const char*>(memchr(begin, '#', end - begin));
+    if (commentBegin) {
+        const char* queryIdBegin = commentBegin + 1;
+        while (queryIdBegin != end && IsSpace(*queryIdBegin)) {
+            ++queryIdBegin;
+        }
+        instance.QueryId.assign(queryIdBegin, TrimmedEnd(queryIdBegin, end));
+        end = commentBegin;
+    }
+
+    const char* tokenEnd = NextToken(begin, end);
+    if (begin == tokenEnd) {
+        return false;
+    }
+    ParseDouble(begin, tokenEnd, instance.Goal);
+    begin = tokenEnd;
+
+    for (tokenEnd = NextToken(begin, end); begin != tokenEnd; begin = tokenEnd, tokenEnd = NextToken(begin, end)) {
+        const char* colon = static_cast<const char*>(memchr(begin, ':', tokenEnd - begin));
+        if (!colon) {
+            continue;
+        }
+        if (colon - begin == 3 && !memcmp(begin, "qid", 3)) {
+            if (!commentBegin) {
+                instance.QueryId.assign(colon + 1, tokenEnd);
+            }
+            continue;
+        }
+
+        size_t index;
+        double value;
+        if (ParseIndex(begin, colon, index) && index && ParseValue(colon + 1, tokenEnd, value)) {
+            SetFeature(instance, index - 1, value);
+        }
+    }
+
+    return true;
+}
+
+void TFeaturesReader::ParseVowpalWabbitLine(const char* begin, const char* end, TInstance& instance) {
+    instance.QueryId.clear();
+    instance.Url.clear();
+    instance.Goal = 0.;
+    instance.Weight = 1.;
+
+    const char* featuresBegin = static_cast<const char*>(memchr(begin, '|', end - begin));
+    const char* headerEnd = featuresBegin ? featuresBegin : end;
+
+    // the field PrintForVowpalWabbit appends after the features
+    const char* tab = nullptr;
+    for (const char* symbol = end; featuresBegin && symbol != featuresBegin; --symbol) {
+        if (symbol[-1] == '\t') {
+            tab = symbol - 1;
+            break;
+        }
+    }
+    if (tab) {
+        instance.QueryId.assign(tab + 1, TrimmedEnd(tab + 1, end));
+        end = tab;
+    }
+
+    const char* tokenEnd = NextToken(begin, headerEnd);
+    ParseDouble(begin, tokenEnd, instance.Goal);
+    begin = tokenEnd;
+
+    bool hasWeight = false;
+    bool hasBase = false;
+    for (tokenEnd = NextToken(begin, headerEnd); begin != tokenEnd; begin = tokenEnd, tokenEnd = NextToken(begin, headerEnd)) {
+        double value;
+        if (*begin != '\'' && !hasBase && ParseValue(begin, tokenEnd, value)) {
+            hasBase = hasWeight;
+            if (!hasWeight) {
+                instance.Weight = value;
+                hasWeight = true;
+            }
+        } else if (!tab) {
+            instance.QueryId.assign(begin + (*begin == '\''), tokenEnd);
+        }
+    }
+
+    double namespaceScale = 1.;
+    for (begin = featuresBegin ? featuresBegin : end; begin != end;) {
+        if (*begin == '|') {
+            ++begin;
+            namespaceScale = 1.;
+            if (begin != end && !IsSpace(*begin)) {
+                tokenEnd = NextToken(begin, end);
+                const char* colon = static_cast<const char*>(memchr(begin, ':', tokenEnd - begin));
+                if (colon && !ParseValue(colon + 1, tokenEnd, namespaceScale)) {
+                    namespaceScale = 1.;
+                }
+                begin = tokenEnd;
+            }
+            continue;
+        }
+        if (IsSpace(*begin)) {
+            ++begin;
+            continue;
+        }
+
+        tokenEnd = begin;
+        while (tokenEnd != end && !IsSpace(*tokenEnd) && *tokenEnd != '|') {
+            ++tokenEnd;
+        }
+
+        const char* colon = static_cast<const char*>(memchr(begin, ':', tokenEnd - begin));
+        const char* nameEnd = colon ? colon : tokenEnd;
+
+        size_t index;
+        double value = 1.;
+        if (ParseIndex(begin, nameEnd, index) && (!colon || ParseValue(colon + 1, tokenEnd, value))) {
+            SetFeature(instance, index, value * namespaceScale);
+        }
+        begin = tokenEnd;
+    }
+}
+
+EPoolFormat TFeaturesReader::DetectFormat(const std::string& featuresPath) {
+    // the standard input cannot be read twice
+    if (featuresPath == "-") {
+        return PF_FEATURES;
+    }
+
+    TFeaturesReader featuresReader(featuresPath, 1 << 16);
+
+    const char* begin;
+    const char* end;
+    size_t lineOffset;
+    // SVMLight comment lines say nothing about the format
+    do {
+        if (!featuresReader.FindLine(begin, end, lineOffset)) {
+            return PF_FEATURES;
+        }
+        NextToken(begin, end);
+    } while (begin == end || *begin == '#');
+
+    if (HasVowpalWabbitHeader(begin, end)) {
+        return PF_VOWPAL_WABBIT;
+    }
+
+    // the second field of a features line is the goal, while SVMLight has an index:value pair there
+    NextToken(begin, end);
+    begin = NextToken(begin, end);
+    const char* tokenEnd = NextToken(begin, end);
+    if (begin != tokenEnd && (*begin == '#' || memchr(begin, ':', tokenEnd - begin))) {
+        return PF_SVM_LIGHT;
+    }
+    return PF_FEATURES;
+}
+
+// finds the next line in the buffer, refilling it from the file when the line crosses its end
+bool TFeaturesReader::FindLine(const char*& begin, const char*& end, size_t& lineOffset) {
+    while (true) {
+        const char* dataBegin = Buffer.data() + LineBegin;
+        const char* dataEnd = Buffer.data() + DataEnd;
+        const char* lineEnd = static_cast<const char*>(memchr(dataBegin, '\n', dataEnd - dataBegin));
+
+        const bool isLastLine = !lineEnd && (!FeaturesIn || FeaturesIn.eof());
+        if (lineEnd || (isLastLine && dataBegin != dataEnd)) {
+            lineEnd = lineEnd ? lineEnd : dataEnd;
+
+            begin = dataBegin;
+            end = lineEnd;
+            lineOffset = BufferOffset + LineBegin;
+
+            LineBegin = lineEnd - Buffer.data() + (lineEnd != dataEnd);
+            return true;
+        }
+        if (isLastLine) {
+            return false;
+        }
+
+        const size_t tailSize = DataEnd - LineBegin;
+        std::memmove(Buffer.data(), dataBegin, tailSize);
+        BufferOffset += LineBegin;
+        LineBegin = 0;
+        DataEnd = tailSize;
+        if (DataEnd == Buffer.size()) {
+            Buffer.resize(2 * Buffer.size());
+        }
+
+        FeaturesIn.read(Buffer.data() + DataEnd, Buffer.size() - DataEnd);
+        DataEnd += FeaturesIn.gcount();
+        BytesRead += FeaturesIn.gcount();
+    }
+}
+
+TFeaturesStreamIterator::TState::TState(const std::string& featuresPath, const EPoolFormat format, const size_t featuresCount)
+    : FeaturesReader(featuresPath == "-" ? "/dev/stdin" : featuresPath, format == PF_AUTO ? TFeaturesReader::DetectFormat(featuresPath) : format)
+    , FeaturesCount(featuresCount)
+{
+}
+
+TFeaturesStreamIterator::TFeaturesStreamIterator(const std::string& featuresPath, const EPoolFormat format, const size_t featuresCount)
+    : State(std::make_shared<TState>(featuresPath, format, featuresCount))
+{
+    ++*this;
+}
+
+bool TFeaturesStreamIterator::IsValid() const {
+    return State->IsValid;
+}
+
+const TInstanceView& TFeaturesStreamIterator::operator*() const {
+    return State->InstanceView;
+}
+
+const TInstanceView* TFeaturesStreamIterator::operator->() const {
+    return &State->InstanceView;
+}
+
+TFeaturesStreamIterator& TFeaturesStreamIterator::operator++() {
+    TState& state = *State;
+
+    state.IsValid = !state.WideInstanceFeaturesCount && state.FeaturesReader.Next(state.Instance);
+    if (!state.IsValid) {
+        return *this;
+    }
+
+    if (!state.FeaturesCount) {
+        state.FeaturesCount = state.Instance.Features.size();
+    }
+    if (state.Instance.Features.size() > state.FeaturesCount) {
+        state.WideInstanceFeaturesCount = state.Instance.Features.size();
+        state.IsValid = false;
+        return *this;
+    }
+    state.Instance.Features.resize(state.FeaturesCount, 0.);
+
+    state.InstanceView = TInstanceView(state.Instance);
+    ++state.InstanceIdx;
+
+    return *this;
+}
+
+size_t TFeaturesStreamIterator::GetInstanceIdx() const {
+    return State->InstanceIdx;
+}
+
+size_t TFeaturesStreamIterator::GetBytesRead() const {
+    return State->FeaturesReader.GetBytesRead();
+}
+
+bool TFeaturesStreamIterator::IsOpen() const {
+    return State->FeaturesReader.IsOpen();
+}
+
+size_t TFeaturesStreamIterator::GetWideInstanceFeaturesCount() const {
+    return State->WideInstanceFeaturesCount;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "pool.h"
+
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reads text pools through a large buffer: the lines are tokenized in place and the numbers are parsed
+// with std::from_chars, so nothing is allocated per line besides the instance's own storage.
+// Besides features files, it reads the SVMLight and Vowpal Wabbit lines the way PrintForSVMLight
+// and PrintForVowpalWabbit write them; the features missing from such a line are zeros.
+class TFeaturesReader {
+private:
+    std::ifstream FeaturesIn;
+    EPoolFormat Format;
+
+    std::vector<char> Buffer;
+    size_t LineBegin = 0;
+    size_t DataEnd = 0;
+
+    // file offset of the first byte of the buffer and the offset the lines to read have to start before
+    size_t BufferOffset = 0;
+    size_t RangeEnd;
+
+    size_t BytesRead = 0;
+    size_t FeaturesCount = 0;
+
+public:
+    explicit TFeaturesReader(const std::string& featuresPath, const size_t bufferSize = 1 << 24);
+
+    // reads only the lines starting within [rangeBegin, rangeEnd) of the file
+    TFeaturesReader(const std::string& featuresPath,
+                    const EPoolFormat format,
+                    const size_t rangeBegin = 0,
+                    const size_t rangeEnd = std::numeric_limits<size_t>::max(),
+                    const size_t bufferSize = 1 << 24);
+
+    // parses the next line holding an instance, returns false at the end of the file
+    bool Next(TInstance& instance);
+
+    size_t GetBytesRead() const;
+
+    // false if the file could not be opened
+    bool IsOpen() const;
+
+    // the same parsing as TInstance::FromFeaturesString without the string stream
+    static void ParseLine(const char* begin, const char* end, TInstance& instance);
+
+    // "goal index:value ... # QueryId" with the indices starting from one; a qid:value pair gives the QueryId
+    // unless there is a comment; returns false for comment lines
+    static bool ParseSVMLightLine(const char* begin, const char* end, TInstance& instance);
+
+    // "goal [weight [base]] ['tag]|namespace[:scale] index[:value] ...|...\tQueryId", the features taken
+    // by their numeric names in every namespace and the others skipped; the QueryId is either the tag
+    // or the tab-separated field PrintForVowpalWabbit appends
+    static void ParseVowpalWabbitLine(const char* begin, const char* end, TInstance& instance);
+
+    // the format of a text pool by its first line holding an instance, features for the standard input ("-")
+    static EPoolFormat DetectFormat(const std::string& featuresPath);
+
+private:
+    // finds the next line, empty ones included
+    bool FindLine(const char*& begin, const char*& end, size_t& lineOffset);
+};
+
+// Input iterator over the instances of a text pool read straight from the file, "-" standing for the standard
+// input: only the current instance is kept in memory, so a single pass learns on pools larger than the RAM.
+// Every row gets the features count given or, if it is zero, the one of the first instance. A pool in memory
+// widens to the widest row instead, so the stream stops at a row wider than that rather than cutting it off.
+// Copies share the reading position.
+class TFeaturesStreamIterator {
+private:
+    struct TState {
+        TFeaturesReader FeaturesReader;
+        size_t FeaturesCount;
+
+        TInstance Instance;
+        TInstanceView InstanceView;
+        bool IsValid = false;
+        size_t InstanceIdx = (size_t)-1;
+        size_t WideInstanceFeaturesCount = 0;
+
+        TState(const std::string& featuresPath, const EPoolFormat format, const size_t featuresCount);
+    };
+
+    std::shared_ptr<TState> State;
+
+public:
+    // the format of a file is detected if it is PF_AUTO, the standard input is read as a features file then
+    TFeaturesStreamIterator(const std::string& featuresPath, const EPoolFormat format = PF_AUTO, const size_t featuresCount = 0);
+
+    bool IsValid() const;
+    const TInstanceView& operator*() const;
+    const TInstanceView* operator->() const;
+    TFeaturesStreamIterator& operator++();
+    size_t GetInstanceIdx() const;
+
+    size_t GetBytesRead() const;
+
+    // false if the file could not be opened, the stream being empty then
+    bool IsOpen() const;
+
+    // features count of the instance the stream stopped at for being wider than the rows, 0 if it did not stop so
+    size_t GetWideInstanceFeaturesCount() const;
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "kahan.h"
+#include "linear_model.h"
+#include "linear_regression.h"
+
+#include <array>
+#include <utility>
+
+// Linear regression solvers for a features count known at compile time: the state lives in std::array's
+// and the loops over the packed OLS triangle are fully unrolled, which pays off on narrow pools
+// where the per-instance overhead of the dynamic solvers dominates.
+namespace NFixedLinearRegressionInner {
+    template <size_t Begin, typename TFunc, size_t... Indices>
+    inline void StaticFor(TFunc&& func, std::index_sequence<Indices...>) {
+        (func(std::integral_constant<size_t, Begin + Indices>()), ...);
+    }
+
+    // calls func(std::integral_constant<size_t, idx>()) for every idx from [Begin, End)
+    template <size_t Begin, size_t End, typename TFunc>
+    inline void StaticFor(TFunc&& func) {
+        StaticFor<Begin>(func, std::make_index_sequence<End - Begin>());
+    }
+
+    // position of the (row, row) element in the packed upper triangle of a size x size matrix
+    constexpr size_t DiagonalOffset(const size_t row, const size_t size) {
+        return row * size - row * (row - 1) / 2;
+    }
+
+    template <size_t Size>
+    std::vector<double> ToVector(const std::array<double, Size>& values) {
+        return std::vector<double>(values.begin(), values.end());
+    }
+}
+
+template <size_t FeaturesCount>
+class TFixedFastLRSolver {
+private:
+    static constexpr size_t SystemSize = FeaturesCount + 1;
+
+    TKahanAccumulator SumSquaredGoals;
+
+    std::array<double, SystemSize * (SystemSize + 1) / 2> LinearizedOLSMatrix = {};
+    std::array<double, SystemSize> OLSVector = {};
+
+public:
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.) {
+        using namespace NFixedLinearRegressionInner;
+
+        StaticFor<0, FeaturesCount>([&](auto rowIndex) {
+            constexpr size_t row = decltype(rowIndex)::value;
+            constexpr size_t rowBegin = DiagonalOffset(row, SystemSize) - row;
+
+            const double weightedFeature = weight * features[row];
+            StaticFor<row, FeaturesCount>([&](auto columnIndex) {
+                constexpr size_t column = decltype(columnIndex)::value;
+                LinearizedOLSMatrix[rowBegin + column] += weightedFeature * features[column];
+            });
+            LinearizedOLSMatrix[rowBegin + FeaturesCount] += weightedFeature;
+        });
+        LinearizedOLSMatrix.back() += weight;
+
+        const double weightedGoal = goal * weight;
+        StaticFor<0, FeaturesCount>([&](auto index) {
+            constexpr size_t featureNumber = decltype(index)::value;
+            OLSVector[featureNumber] += features[featureNumber] * weightedGoal;
+        });
+        OLSVector.back() += weightedGoal;
+
+        SumSquaredGoals += goal * goal * weight;
+    }
+
+    void Merge(const TFixedFastLRSolver& other) {
+        for (size_t elementIdx = 0; elementIdx < LinearizedOLSMatrix.size(); ++elementIdx) {
+            LinearizedOLSMatrix[elementIdx] += other.LinearizedOLSMatrix[elementIdx];
+        }
+        for (size_t elementIdx = 0; elementIdx < OLSVector.size(); ++elementIdx) {
+            OLSVector[elementIdx] += other.OLSVector[elementIdx];
+        }
+
+        SumSquaredGoals += other.SumSquaredGoals;
+    }
+
+    TLRSolution Solution() const {
+        TLRSolution solution;
+        Solution(solution);
+        return solution;
+    }
+
+    void Solution(TLRSolution& solution) const {
+        using namespace NFixedLinearRegressionInner;
+
+        NLinearRegressionInner::Solve(ToVector(LinearizedOLSMatrix), ToVector(OLSVector), SumSquaredGoals, solution);
+
+        TLinearModel& linearModel = solution.Model;
+        linearModel.Intercept = linearModel.Coefficients.back();
+        linearModel.Coefficients.pop_back();
+    }
+
+    TLinearModel Solve() const {
+        TLRSolution& solution = TLRSolution::ThreadWorkspace();
+        Solution(solution);
+        return solution.Model;
+    }
+
+    double SumSquaredErrors() const {
+        TLRSolution& solution = TLRSolution::ThreadWorkspace();
+        Solution(solution);
+        return solution.SumSquaredErrors;
+    }
+
+    static const std::string Name() {
+        return "fixed fast LR";
+    }
+};
+
+template <size_t FeaturesCount, bool Normalized>
+class TTypedFixedWelfordLRSolver {
+private:
+    double GoalsMean = 0.;
+    double GoalsDeviation = 0.;
+
+    std::array<double, FeaturesCount> FeatureMeans = {};
+    std::array<double, FeaturesCount * (FeaturesCount + 1) / 2> LinearizedOLSMatrix = {};
+
+    std::array<double, FeaturesCount> OLSVector = {};
+
+    TKahanAccumulator SumWeights;
+
+public:
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.) {
+        using namespace NFixedLinearRegressionInner;
+
+        SumWeights += weight;
+        if (!SumWeights) {
+            return;
+        }
+
+        const double sumWeights = SumWeights;
+        const double updateFactor = weight / sumWeights;
+
+        std::array<double, FeaturesCount> featureWeightedDeviationFromLastMean;
+        std::array<double, FeaturesCount> featureDeviationFromNewMean;
+        StaticFor<0, FeaturesCount>([&](auto index) {
+            constexpr size_t featureNumber = decltype(index)::value;
+            const double feature = features[featureNumber];
+            double& featureMean = FeatureMeans[featureNumber];
+
+            featureWeightedDeviationFromLastMean[featureNumber] = weight * (feature - featureMean);
+            featureMean += featureWeightedDeviationFromLastMean[featureNumber] / sumWeights;
+            featureDeviationFromNewMean[featureNumber] = feature - featureMean;
+        });
+
+        StaticFor<0, FeaturesCount>([&](auto rowIndex) {
+            constexpr size_t row = decltype(rowIndex)::value;
+            constexpr size_t rowBegin = DiagonalOffset(row, FeaturesCount) - row;
+
+            const double lastMeanDeviation = featureWeightedDeviationFromLastMean[row];
+            StaticFor<row, FeaturesCount>([&](auto columnIndex) {
+                constexpr size_t column = decltype(columnIndex)::value;
+                double& olsMatrixElement = LinearizedOLSMatrix[rowBegin + column];
+                if constexpr (Normalized) {
+                    olsMatrixElement += updateFactor * (lastMeanDeviation * featureDeviationFromNewMean[column] - olsMatrixElement);
+                } else {
+                    olsMatrixElement += lastMeanDeviation * featureDeviationFromNewMean[column];
+                }
+            });
+        });
+
+        const double goalDeviation = goal - GoalsMean;
+        StaticFor<0, FeaturesCount>([&](auto index) {
+            constexpr size_t featureNumber = decltype(index)::value;
+            double& olsVectorElement = OLSVector[featureNumber];
+            if constexpr (Normalized) {
+                olsVectorElement += updateFactor * (goalDeviation * featureDeviationFromNewMean[featureNumber] - olsVectorElement);
+            } else {
+                olsVectorElement += weight * goalDeviation * featureDeviationFromNewMean[featureNumber];
+            }
+        });
+
+        const double oldGoalsMean = GoalsMean;
+        GoalsMean += weight * (goal - GoalsMean) / sumWeights;
+        if constexpr (Normalized) {
+            GoalsDeviation += updateFactor * ((goal - oldGoalsMean) * (goal - GoalsMean) - GoalsDeviation);
+        } else {
+            GoalsDeviation += weight * (goal - oldGoalsMean) * (goal - GoalsMean);
+        }
+    }
+
+    // the same pairwise update as in TWelfordLRSolver::Merge
+    void Merge(const TTypedFixedWelfordLRSolver& other) {
+        if (!other.SumWeights) {
+            return;
+        }
+        if (!SumWeights) {
+            *this = other;
+            return;
+        }
+
+        const double leftWeight = SumWeights;
+        const double rightWeight = other.SumWeights;
+
+        SumWeights += other.SumWeights;
+        if (!SumWeights) {
+            return;
+        }
+
+        const double sumWeights = SumWeights;
+        const double mergeFactor = leftWeight * rightWeight / sumWeights;
+
+        std::array<double, FeaturesCount> meansDiffs;
+        for (size_t featureNumber = 0; featureNumber < FeaturesCount; ++featureNumber) {
+            meansDiffs[featureNumber] = other.FeatureMeans[featureNumber] - FeatureMeans[featureNumber];
+            FeatureMeans[featureNumber] += rightWeight * meansDiffs[featureNumber] / sumWeights;
+        }
+
+        size_t olsMatrixElementIdx = 0;
+        for (size_t row = 0; row < FeaturesCount; ++row) {
+            for (size_t column = row; column < FeaturesCount; ++column, ++olsMatrixElementIdx) {
+                MergeElement(LinearizedOLSMatrix[olsMatrixElementIdx], other.LinearizedOLSMatrix[olsMatrixElementIdx], mergeFactor * meansDiffs[row] * meansDiffs[column], rightWeight, sumWeights);
+            }
+        }
+
+        const double goalsMeanDiff = other.GoalsMean - GoalsMean;
+        for (size_t featureNumber = 0; featureNumber < FeaturesCount; ++featureNumber) {
+            MergeElement(OLSVector[featureNumber], other.OLSVector[featureNumber], mergeFactor * meansDiffs[featureNumber] * goalsMeanDiff, rightWeight, sumWeights);
+        }
+
+        GoalsMean += rightWeight * goalsMeanDiff / sumWeights;
+        MergeElement(GoalsDeviation, other.GoalsDeviation, mergeFactor * goalsMeanDiff * goalsMeanDiff, rightWeight, sumWeights);
+    }
+
+    TLRSolution Solution() const {
+        TLRSolution solution;
+        Solution(solution);
+        return solution;
+    }
+
+    void Solution(TLRSolution& solution) const {
+        using namespace NFixedLinearRegressionInner;
+
+        NLinearRegressionInner::Solve(ToVector(LinearizedOLSMatrix), ToVector(OLSVector), GoalsDeviation, solution);
+
+        TLinearModel& model = solution.Model;
+        model.Intercept = GoalsMean;
+        for (size_t featureNumber = 0; featureNumber < FeaturesCount; ++featureNumber) {
+            model.Intercept -= FeatureMeans[featureNumber] * model.Coefficients[featureNumber];
+        }
+
+        if (Normalized) {
+            solution.SumSquaredErrors *= SumWeights;
+        }
+    }
+
+    TLinearModel Solve() const {
+        TLRSolution& solution = TLRSolution::ThreadWorkspace();
+        Solution(solution);
+        return solution.Model;
+    }
+
+    double SumSquaredErrors() const {
+        TLRSolution& solution = TLRSolution::ThreadWorkspace();
+        Solution(solution);
+        return solution.SumSquaredErrors;
+    }
+
+    static const std::string Name() {
+        return Normalized ? "fixed normalized Welford LR" : "fixed Welford LR";
+    }
+
+private:
+    static void MergeElement(double& element, const double otherElement, const double meansCorrection, const double rightWeight, const double sumWeights) {
+        if (Normalized) {
+            element += (rightWeight * (otherElement - element) + meansCorrection) / sumWeights;
+        } else {
+            element += otherElement + meansCorrection;
+        }
+    }
+};
+
+template <size_t FeaturesCount>
+using TFixedWelfordLRSolver = TTypedFixedWelfordLRSolver<FeaturesCount, false>;
+
+template <size_t FeaturesCount>
+using TFixedNormalizedWelfordLRSolver = TTypedFixedWelfordLRSolver<FeaturesCount, true>;
+
+// features counts having their own fixed-size solvers; on wider pools the vectorized dynamic solvers are as fast
+using TFixedFeaturesCounts = std::index_sequence<1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 20, 21, 24>;
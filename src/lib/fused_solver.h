@@ -0,0 +1,104 @@
+#pragma once
+
+#include "linear_model.h"
+
+#include <memory>
+#include <vector>
+
+class TAnySolver {
+public:
+    virtual ~TAnySolver() {}
+
+    virtual void Add(const TFeaturesView& features, const double goal, const double weight) = 0;
+    // the other solver has to be of the same type
+    virtual void Merge(const TAnySolver& other) = 0;
+    virtual TLinearModel Solve() const = 0;
+
+    virtual std::unique_ptr<TAnySolver> Clone() const = 0;
+};
+
+template <typename TSolver>
+class TSomeSolver: public TAnySolver {
+private:
+    TSolver Solver;
+
+public:
+    explicit TSomeSolver(const TSolver& solver)
+        : Solver(solver)
+    {
+    }
+
+    void Add(const TFeaturesView& features, const double goal, const double weight) override {
+        Solver.Add(features, goal, weight);
+    }
+
+    void Merge(const TAnySolver& other) override {
+        Solver.Merge(static_cast<const TSomeSolver&>(other).Solver);
+    }
+
+    TLinearModel Solve() const override {
+        return Solver.Solve();
+    }
+
+    std::unique_ptr<TAnySolver> Clone() const override {
+        return std::make_unique<TSomeSolver>(*this);
+    }
+};
+
+// Feeds every instance to a set of solvers of different types, so that a single pass over the pool learns
+// the models of all of them while each row is still in the cache. The solvers are merged pairwise, so the sets
+// merged have to be built alike; a copy of the set copies the solvers. Solve gives the models in the order
+// the solvers were added in.
+class TFusedSolver {
+private:
+    std::vector<std::unique_ptr<TAnySolver>> Solvers;
+
+public:
+    TFusedSolver() = default;
+
+    TFusedSolver(const TFusedSolver& other) {
+        *this = other;
+    }
+
+    TFusedSolver& operator=(const TFusedSolver& other) {
+        if (this != &other) {
+            Solvers.clear();
+            for (const std::unique_ptr<TAnySolver>& solver : other.Solvers) {
+                Solvers.push_back(solver->Clone());
+            }
+        }
+        return *this;
+    }
+
+    TFusedSolver(TFusedSolver&&) = default;
+    TFusedSolver& operator=(TFusedSolver&&) = default;
+
+    template <typename TSolver>
+    void AddSolver(const TSolver& solver = TSolver()) {
+        Solvers.push_back(std::make_unique<TSomeSolver<TSolver>>(solver));
+    }
+
+    size_t size() const {
+        return Solvers.size();
+    }
+
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.) {
+        for (const std::unique_ptr<TAnySolver>& solver : Solvers) {
+            solver->Add(features, goal, weight);
+        }
+    }
+
+    void Merge(const TFusedSolver& other) {
+        for (size_t solverIdx = 0; solverIdx < Solvers.size(); ++solverIdx) {
+            Solvers[solverIdx]->Merge(*other.Solvers[solverIdx]);
+        }
+    }
+
+    std::vector<TLinearModel> Solve() const {
+        std::vector<TLinearModel> models;
+        for (const std::unique_ptr<TAnySolver>& solver : Solvers) {
+            models.push_back(solver->Solve());
+        }
+        return models;
+    }
+};
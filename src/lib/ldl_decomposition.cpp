@@ -0,0 +1,163 @@
+#include "eigen_decomposition.h"
+#include "ldl_decomposition.h"
+#include "vector_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // short row prefixes are cheaper to sum inline than through the dispatched kernel
+    inline double RowsDot(const size_t size, const double* left, const double* right) {
+        if (size < 16) {
+            double sum = 0.;
+            for (size_t idx = 0; idx < size; ++idx) {
+                sum += left[idx] * right[idx];
+            }
+            return sum;
+        }
+        return NVectorKernels::Dot(size, left, right);
+    }
+}
+
+// Row-oriented (Crout) decomposition: while row i is being built it holds L[i][k] * D[k], so every element
+// is a dot product of two contiguous row prefixes. Rows are processed in blocks, and every finished row
+// of the previous blocks is loaded once for the whole block instead of once per row.
+bool TLDLDecomposition::Decompose(const std::vector<double>& linearizedMatrix,
+                                  const size_t size,
+                                  const double regularizationThreshold,
+                                  const double regularizationParameter)
+{
+    Size = size;
+    RegularizationParameter = regularizationParameter;
+    Factors.resize(size * (size + 1) / 2);
+
+    size_t matrixElementIdx = 0;
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = row; column < size; ++column) {
+            Factors[RowBegin(column) + row] = linearizedMatrix[matrixElementIdx];
+            ++matrixElementIdx;
+        }
+        Factors[RowBegin(row) + row] += regularizationParameter;
+    }
+
+    const size_t blockSize = 32;
+    for (size_t blockBegin = 0; blockBegin < size; blockBegin += blockSize) {
+        const size_t blockEnd = std::min(blockBegin + blockSize, size);
+
+        for (size_t column = 0; column < blockBegin; ++column) {
+            const double* columnFactors = &Factors[RowBegin(column)];
+            for (size_t row = blockBegin; row < blockEnd; ++row) {
+                double* rowFactors = &Factors[RowBegin(row)];
+                rowFactors[column] -= RowsDot(column, rowFactors, columnFactors);
+            }
+        }
+
+        for (size_t row = blockBegin; row < blockEnd; ++row) {
+            double* rowFactors = &Factors[RowBegin(row)];
+            for (size_t column = blockBegin; column < row; ++column) {
+                rowFactors[column] -= RowsDot(column, rowFactors, &Factors[RowBegin(column)]);
+            }
+
+            double& pivot = rowFactors[row];
+            for (size_t column = 0; column < row; ++column) {
+                const double scaledFactor = rowFactors[column];
+                rowFactors[column] = scaledFactor / Diagonal(column);
+                pivot -= scaledFactor * rowFactors[column];
+            }
+
+            if (fabs(pivot) < regularizationThreshold) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void TLDLDecomposition::DecomposeRegularized(const std::vector<double>& linearizedMatrix, const size_t size) {
+    double regularizationParameter = 0.;
+
+    // after a few failures the parameter jumps straight to the smallest grid value making every eigenvalue pass the
+    // threshold, which bounds the pivots from below, instead of doubling through dozens of full decompositions
+    const size_t attemptsBeforeSpectralEstimate = 4;
+
+    for (size_t attempt = 1; !Decompose(linearizedMatrix, size, RegularizationThreshold, regularizationParameter); ++attempt) {
+        regularizationParameter = regularizationParameter ? 2 * regularizationParameter : 1e-5;
+
+        if (attempt == attemptsBeforeSpectralEstimate) {
+            TSymmetricEigenDecomposition eigenDecomposition;
+            eigenDecomposition.Decompose(linearizedMatrix, size, false);
+
+            const double sufficientParameter = RegularizationThreshold - eigenDecomposition.GetMinEigenvalue();
+            while (regularizationParameter < sufficientParameter) {
+                regularizationParameter *= 2;
+            }
+        }
+    }
+}
+
+void TLDLDecomposition::ResetToDiagonal(const size_t size, const double diagonal) {
+    Size = size;
+    RegularizationParameter = diagonal;
+    Factors.assign(size * (size + 1) / 2, 0.);
+
+    for (size_t row = 0; row < size; ++row) {
+        Factors[RowBegin(row) + row] = diagonal;
+    }
+}
+
+// method C1 from Gill, Golub, Murray, Saunders, "Methods for modifying matrix factorizations", 1974
+void TLDLDecomposition::RankOneUpdate(double alpha, std::vector<double> vector) {
+    for (size_t column = 0; column < Size && alpha; ++column) {
+        const double projection = vector[column];
+        double& diagonal = Factors[RowBegin(column) + column];
+
+        const double updatedDiagonal = diagonal + alpha * projection * projection;
+        const double factor = alpha * projection / updatedDiagonal;
+        alpha *= diagonal / updatedDiagonal;
+        diagonal = updatedDiagonal;
+
+        for (size_t row = column + 1; row < Size; ++row) {
+            double& lowerFactor = Factors[RowBegin(row) + column];
+            vector[row] -= projection * lowerFactor;
+            lowerFactor += factor * vector[row];
+        }
+    }
+}
+
+void TLDLDecomposition::Solve(const std::vector<double>& rightHandSide, std::vector<double>& solution) const {
+    solution.assign(rightHandSide.begin(), rightHandSide.begin() + Size);
+
+    for (size_t row = 0; row < Size; ++row) {
+        solution[row] -= RowsDot(row, &Factors[RowBegin(row)], solution.data());
+    }
+
+    for (size_t row = 0; row < Size; ++row) {
+        solution[row] /= Diagonal(row);
+    }
+
+    for (size_t row = Size; row > 0; --row) {
+        NVectorKernels::Axpy(row - 1, -solution[row - 1], &Factors[RowBegin(row - 1)], solution.data());
+    }
+}
+
+double TLDLDecomposition::InverseQuadraticForm(const std::vector<double>& vector) const {
+    thread_local std::vector<double> forwardSolution;
+    forwardSolution.assign(vector.begin(), vector.begin() + Size);
+
+    double quadraticForm = 0.;
+    for (size_t row = 0; row < Size; ++row) {
+        forwardSolution[row] -= RowsDot(row, &Factors[RowBegin(row)], forwardSolution.data());
+        quadraticForm += forwardSolution[row] * forwardSolution[row] / Diagonal(row);
+    }
+
+    return quadraticForm;
+}
+
+size_t TLDLDecomposition::GetSize() const {
+    return Size;
+}
+
+double TLDLDecomposition::GetRegularizationParameter() const {
+    return RegularizationParameter;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// LDL decomposition of a symmetric matrix given as a packed upper triangle, see
+// http://en.wikipedia.org/wiki/Cholesky_decomposition#LDL_decomposition_2
+//
+// The factors live in a single contiguous buffer holding the packed lower triangle row by row, with D on
+// the diagonal in place of the unit diagonal of L. The buffer is reused by subsequent decompositions.
+class TLDLDecomposition {
+private:
+    size_t Size = 0;
+    double RegularizationParameter = 0.;
+
+    std::vector<double> Factors;
+
+public:
+    // the smallest pivot DecomposeRegularized accepts
+    static constexpr double RegularizationThreshold = 1e-5;
+
+    // decomposes matrix + regularizationParameter * I; returns false if some pivot is below the threshold
+    bool Decompose(const std::vector<double>& linearizedMatrix,
+                   const size_t size,
+                   const double regularizationThreshold,
+                   const double regularizationParameter);
+
+    // decomposes with a regularization parameter from 0, 1e-5, 2e-5, 4e-5, ... for which every pivot passes the threshold;
+    // on ill-conditioned matrices the parameter is chosen from the smallest eigenvalue
+    void DecomposeRegularized(const std::vector<double>& linearizedMatrix, const size_t size);
+
+    // starts from the factors of diagonal * I
+    void ResetToDiagonal(const size_t size, const double diagonal);
+
+    // turns the factors of matrix into the ones of matrix + alpha * vector * vector^T in O(size^2);
+    // a negative alpha downdates, the result has to stay positive definite
+    void RankOneUpdate(const double alpha, std::vector<double> vector);
+
+    void Solve(const std::vector<double>& rightHandSide, std::vector<double>& solution) const;
+
+    // vector^T * matrix^-1 * vector, which takes only the forward pass
+    double InverseQuadraticForm(const std::vector<double>& vector) const;
+
+    size_t GetSize() const;
+    double GetRegularizationParameter() const;
+
+private:
+    size_t RowBegin(const size_t row) const {
+        return row * (row + 1) / 2;
+    }
+
+    double Diagonal(const size_t row) const {
+        return Factors[RowBegin(row) + row];
+    }
+};
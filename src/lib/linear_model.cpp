@@ -1,4 +1,5 @@
 #include "linear_model.h"
+#include "vector_kernels.h"
 
 TLinearModel::TLinearModel(size_t featuresCount /*= 0*/)
     : Coefficients(featuresCount)
@@ -6,6 +7,10 @@ TLinearModel::TLinearModel(size_t featuresCount /*= 0*/)
 {
 }
 
+double TLinearModel::Prediction(const TFeaturesView& features) const {
+    return Intercept + NVectorKernels::Dot(Coefficients.size(), Coefficients.data(), features.data());
+}
+
 void TLinearModel::SaveToFile(const std::string& modelPath) const {
     std::ofstream modelOut(modelPath);
     modelOut.precision(20);
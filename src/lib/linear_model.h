@@ -2,11 +2,15 @@
 
 #include "pool.h"
 
+#include <algorithm>
 #include <vector>
 #include <numeric>
 #include <string>
 
 #include <fstream>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 struct TLinearModel {
     std::vector<double> Coefficients;
@@ -22,19 +26,210 @@ struct TLinearModel {
         return std::inner_product(Coefficients.begin(), Coefficients.end(), features.begin(), Intercept);
     }
 
-    double Prediction(const TInstance& instance) const {
+    double Prediction(const std::vector<double>& features) const {
+        return Prediction(TFeaturesView(features));
+    }
+
+    double Prediction(const TFeaturesView& features) const;
+
+    double Prediction(const TInstanceView& instance) const {
         return Prediction(instance.Features);
     }
 };
 
+template <typename TSolver, typename = void>
+struct THasSolution: std::false_type {
+};
+
+template <typename TSolver>
+struct THasSolution<TSolver, std::void_t<decltype(std::declval<const TSolver&>().Solution())>>: std::true_type {
+};
+
+// Builds the model and, if requested, its sum of squared errors; solvers providing a solution object
+// get both from a single factorization.
+template <typename TSolver>
+TLinearModel SolveAccumulated(const TSolver& solver, double* sumSquaredErrors) {
+    if constexpr (THasSolution<TSolver>::value) {
+        if (sumSquaredErrors) {
+            const auto solution = solver.Solution();
+            *sumSquaredErrors = solution.SumSquaredErrors;
+            return solution.Model;
+        }
+    } else if (sumSquaredErrors) {
+        *sumSquaredErrors = solver.SumSquaredErrors();
+    }
+    return solver.Solve();
+}
+
 template <typename TSolver, typename TIterator>
 TLinearModel Solve(TIterator iterator, double* sumSquaredErrors = nullptr) {
     TSolver solver;
     for (; iterator.IsValid(); ++iterator) {
         solver.Add(iterator->Features, iterator->Goal, iterator->Weight);
     }
-    if (sumSquaredErrors) {
-        *sumSquaredErrors = solver.SumSquaredErrors();
+    return SolveAccumulated(solver, sumSquaredErrors);
+}
+
+template <typename TSolver, typename = void>
+struct THasAddBatch: std::false_type {
+};
+
+template <typename TSolver>
+struct THasAddBatch<TSolver, std::void_t<decltype(&TSolver::AddBatch)>>: std::true_type {
+};
+
+// Feeds the instances to the solver in blocks of batchSize rows if the solver supports batches,
+// and one by one otherwise.
+template <typename TSolver>
+void AddInstances(TSolver& solver, const TInstanceView* begin, const TInstanceView* end, const size_t batchSize) {
+    if constexpr (THasAddBatch<TSolver>::value) {
+        if (batchSize > 1) {
+            std::vector<double> rows, goals, weights;
+            for (; begin != end; ++begin) {
+                const TInstanceView& instance = *begin;
+                rows.insert(rows.end(), instance.Features.begin(), instance.Features.end());
+                goals.push_back(instance.Goal);
+                weights.push_back(instance.Weight);
+
+                if (goals.size() == batchSize || begin + 1 == end) {
+                    solver.AddBatch(rows, goals, weights);
+                    rows.clear();
+                    goals.clear();
+                    weights.clear();
+                }
+            }
+            return;
+        }
     }
-    return solver.Solve();
+
+    for (; begin != end; ++begin) {
+        solver.Add(begin->Features, begin->Goal, begin->Weight);
+    }
+}
+
+template <typename TIterator, typename = void>
+struct THasTransientInstances: std::false_type {
+};
+
+template <typename TIterator>
+struct THasTransientInstances<TIterator, std::void_t<decltype(&TIterator::HasTransientInstances)>>: std::true_type {
+};
+
+// Splits the instances into threadsCount contiguous shards, accumulates a separate solver
+// over each shard and combines the partial states with pairwise merges.
+template <typename TSolver, typename TIterator>
+TSolver ParallelAccumulate(TIterator iterator, size_t threadsCount, const size_t batchSize = 0) {
+    std::vector<TInstanceView> instances;
+    // the features the iterator rebuilds on every step are copied, the views of them are gone once it moves
+    std::vector<double> copiedFeatures;
+    bool copyFeatures = false;
+    if constexpr (THasTransientInstances<TIterator>::value) {
+        copyFeatures = iterator.HasTransientInstances();
+    }
+    for (; iterator.IsValid(); ++iterator) {
+        instances.push_back(*iterator);
+        if (copyFeatures) {
+            copiedFeatures.insert(copiedFeatures.end(), iterator->Features.begin(), iterator->Features.end());
+        }
+    }
+    if (copyFeatures) {
+        const double* features = copiedFeatures.data();
+        for (TInstanceView& instance : instances) {
+            instance.Features = TFeaturesView(features, instance.Features.size());
+            features += instance.Features.size();
+        }
+    }
+
+    threadsCount = std::max<size_t>(1, std::min(threadsCount, instances.size()));
+
+    std::vector<TSolver> solvers(threadsCount);
+    const auto accumulateShard = [&instances, &solvers, threadsCount, batchSize](const size_t threadIdx) {
+        const TInstanceView* begin = instances.data() + instances.size() * threadIdx / threadsCount;
+        const TInstanceView* end = instances.data() + instances.size() * (threadIdx + 1) / threadsCount;
+        AddInstances(solvers[threadIdx], begin, end, batchSize);
+    };
+
+    // the calling thread takes the first shard, so that a single shard costs no thread and its CPU time stays with the caller
+    std::vector<std::thread> workers;
+    for (size_t threadIdx = 1; threadIdx < threadsCount; ++threadIdx) {
+        workers.emplace_back(accumulateShard, threadIdx);
+    }
+    accumulateShard(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (size_t step = 1; step < threadsCount; step *= 2) {
+        for (size_t solverIdx = 0; solverIdx + step < threadsCount; solverIdx += 2 * step) {
+            solvers[solverIdx].Merge(solvers[solverIdx + step]);
+        }
+    }
+
+    return solvers.front();
+}
+
+template <typename TSolver, typename TIterator>
+TLinearModel ParallelSolve(TIterator iterator, const size_t threadsCount, const size_t batchSize = 0, double* sumSquaredErrors = nullptr) {
+    if (threadsCount <= 1 && (batchSize <= 1 || !THasAddBatch<TSolver>::value)) {
+        return Solve<TSolver>(iterator, sumSquaredErrors);
+    }
+
+    const TSolver solver = ParallelAccumulate<TSolver>(iterator, threadsCount, batchSize);
+    return SolveAccumulated(solver, sumSquaredErrors);
+}
+
+// Learns the models of all the cross-validation folds from a single pass over the pool: a solver is accumulated
+// for every fold, and the learn part of each fold is merged from the folds preceding and following it.
+// The fold solvers are copies of the empty solver given, and the models are whatever its Solve gives.
+template <typename TSolver>
+auto SolveFolds(const TPoolView& pool, const std::vector<size_t>& instanceFoldNumbers, const size_t foldsCount, size_t threadsCount, const TSolver& emptySolver = TSolver())
+    -> std::vector<decltype(emptySolver.Solve())>
+{
+    threadsCount = std::max<size_t>(1, std::min(threadsCount, pool.size()));
+
+    std::vector<std::vector<TSolver>> foldSolvers(threadsCount, std::vector<TSolver>(foldsCount, emptySolver));
+    const auto accumulateShard = [&pool, &instanceFoldNumbers, &foldSolvers, threadsCount](const size_t threadIdx) {
+        std::vector<TSolver>& threadFoldSolvers = foldSolvers[threadIdx];
+        std::vector<double> featuresBuffer;
+        const size_t end = pool.size() * (threadIdx + 1) / threadsCount;
+        for (size_t instanceIdx = pool.size() * threadIdx / threadsCount; instanceIdx < end; ++instanceIdx) {
+            const TInstanceView instance = pool.Get(instanceIdx, featuresBuffer);
+            threadFoldSolvers[instanceFoldNumbers[instanceIdx]].Add(instance.Features, instance.Goal, instance.Weight);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t threadIdx = 1; threadIdx < threadsCount; ++threadIdx) {
+        workers.emplace_back(accumulateShard, threadIdx);
+    }
+    accumulateShard(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<TSolver>& folds = foldSolvers.front();
+    for (size_t threadIdx = 1; threadIdx < threadsCount; ++threadIdx) {
+        for (size_t fold = 0; fold < foldsCount; ++fold) {
+            folds[fold].Merge(foldSolvers[threadIdx][fold]);
+        }
+    }
+
+    // suffixes[fold] holds the folds from fold to the last one
+    std::vector<TSolver> suffixes(foldsCount + 1, emptySolver);
+    for (size_t fold = foldsCount; fold > 0; --fold) {
+        suffixes[fold - 1] = suffixes[fold];
+        suffixes[fold - 1].Merge(folds[fold - 1]);
+    }
+
+    std::vector<decltype(emptySolver.Solve())> models;
+    TSolver prefix = emptySolver;
+    for (size_t fold = 0; fold < foldsCount; ++fold) {
+        TSolver learnSolver = prefix;
+        learnSolver.Merge(suffixes[fold + 1]);
+        models.push_back(learnSolver.Solve());
+
+        prefix.Merge(folds[fold]);
+    }
+
+    return models;
 }
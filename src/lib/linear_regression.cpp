@@ -1,20 +1,27 @@
+#include "eigen_decomposition.h"
+#include "ldl_decomposition.h"
 #include "linear_regression.h"
+#include "vector_kernels.h"
 
 #include <algorithm>
 #include <cmath>
 
 namespace NLinearRegressionInner {
-    inline void AddFeaturesProduct(const double weight, const std::vector<double>& features, std::vector<double>& linearizedOLSTriangleMatrix);
-
-    std::vector<double> Solve(const std::vector<double>& olsMatrix, const std::vector<double>& olsVector);
-
-    double SumSquaredErrors(const std::vector<double>& olsMatrix,
-                            const std::vector<double>& olsVector,
-                            const std::vector<double>& solution,
-                            const double goalsDeviation);
+    inline void AddFeaturesProduct(const double weight, const TFeaturesView& features, std::vector<double>& linearizedOLSTriangleMatrix);
+
+    void TransposeBatch(const std::vector<double>& rows,
+                        const std::vector<double>& weights,
+                        const std::vector<double>& means,
+                        std::vector<double>& columns,
+                        std::vector<double>& weightedColumns);
+
+    void AddBatchProduct(const std::vector<double>& weightedColumns,
+                         const std::vector<double>& columns,
+                         const size_t batchSize,
+                         std::vector<double>& linearizedTriangleMatrix);
 }
 
-void TFastLRSolver::Add(const std::vector<double>& features, const double goal, const double weight) {
+void TFastLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
     const size_t featuresCount = features.size();
 
     if (LinearizedOLSMatrix.empty()) {
@@ -25,34 +32,288 @@ void TFastLRSolver::Add(const std::vector<double>& features, const double goal,
     NLinearRegressionInner::AddFeaturesProduct(weight, features, LinearizedOLSMatrix);
 
     const double weightedGoal = goal * weight;
-    std::vector<double>::iterator olsVectorElement = OLSVector.begin();
-    for (const double feature : features) {
-        *olsVectorElement += feature * weightedGoal;
-        ++olsVectorElement;
-    }
-    *olsVectorElement += weightedGoal;
+    NVectorKernels::Axpy(featuresCount, weightedGoal, features.data(), OLSVector.data());
+    OLSVector.back() += weightedGoal;
 
     SumSquaredGoals += goal * goal * weight;
 }
 
-TLinearModel TFastLRSolver::Solve() const {
-    TLinearModel linearModel;
-    linearModel.Coefficients = NLinearRegressionInner::Solve(LinearizedOLSMatrix, OLSVector);
+void TFastLRSolver::AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) {
+    const size_t batchSize = goals.size();
+    if (!batchSize) {
+        return;
+    }
+
+    const size_t featuresCount = rows.size() / batchSize;
+
+    if (LinearizedOLSMatrix.empty()) {
+        LinearizedOLSMatrix.resize((featuresCount + 1) * (featuresCount + 2) / 2);
+        OLSVector.resize(featuresCount + 1);
+    }
+
+    // the last column of ones stands for the intercept
+    std::vector<double> columns, weightedColumns;
+    NLinearRegressionInner::TransposeBatch(rows, weights, std::vector<double>(featuresCount), columns, weightedColumns);
+    columns.resize(columns.size() + batchSize, 1.);
+    weightedColumns.insert(weightedColumns.end(), weights.begin(), weights.end());
+
+    NLinearRegressionInner::AddBatchProduct(weightedColumns, columns, batchSize, LinearizedOLSMatrix);
+
+    for (size_t featureNumber = 0; featureNumber <= featuresCount; ++featureNumber) {
+        OLSVector[featureNumber] += NVectorKernels::Dot(batchSize, &weightedColumns[featureNumber * batchSize], goals.data());
+    }
+
+    for (size_t instanceIdx = 0; instanceIdx < batchSize; ++instanceIdx) {
+        SumSquaredGoals += goals[instanceIdx] * goals[instanceIdx] * weights[instanceIdx];
+    }
+}
+
+void TFastLRSolver::Merge(const TFastLRSolver& other) {
+    if (other.LinearizedOLSMatrix.empty()) {
+        return;
+    }
+    if (LinearizedOLSMatrix.empty()) {
+        *this = other;
+        return;
+    }
+
+    for (size_t elementIdx = 0; elementIdx < LinearizedOLSMatrix.size(); ++elementIdx) {
+        LinearizedOLSMatrix[elementIdx] += other.LinearizedOLSMatrix[elementIdx];
+    }
+    for (size_t elementIdx = 0; elementIdx < OLSVector.size(); ++elementIdx) {
+        OLSVector[elementIdx] += other.OLSVector[elementIdx];
+    }
+
+    SumSquaredGoals += other.SumSquaredGoals;
+}
+
+TLRSolution TFastLRSolver::Solution() const {
+    TLRSolution solution;
+    Solution(solution);
+    return solution;
+}
+
+void TFastLRSolver::Solution(TLRSolution& solution) const {
+    NLinearRegressionInner::Solve(LinearizedOLSMatrix, OLSVector, SumSquaredGoals, solution);
+    FinishModel(solution.Model);
+}
+
+// the intercept is left unregularized: the path is solved for the system centered with the sums of the last row,
+// and every intercept is recovered from the means afterwards
+std::vector<TLinearModel> TFastLRSolver::RidgePath(const std::vector<double>& regularizationParameters) const {
+    std::vector<TLinearModel> models(regularizationParameters.size());
+
+    const size_t featuresCount = OLSVector.empty() ? 0 : OLSVector.size() - 1;
+    const double sumWeights = LinearizedOLSMatrix.empty() ? 0. : LinearizedOLSMatrix.back();
+    if (!sumWeights) {
+        for (TLinearModel& model : models) {
+            model.Coefficients.assign(featuresCount, 0.);
+        }
+        return models;
+    }
 
+    // the last element of every row of the OLS matrix is the weighted sum of the feature
+    std::vector<double> featureSums(featuresCount);
+    {
+        size_t olsMatrixElementIdx = 0;
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            olsMatrixElementIdx += featuresCount - featureNumber;
+            featureSums[featureNumber] = LinearizedOLSMatrix[olsMatrixElementIdx++];
+        }
+    }
+    const double goalsMean = OLSVector.back() / sumWeights;
+
+    std::vector<double> centeredOLSMatrix;
+    centeredOLSMatrix.reserve(featuresCount * (featuresCount + 1) / 2);
+    std::vector<double> centeredOLSVector(featuresCount);
+    {
+        size_t olsMatrixElementIdx = 0;
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            for (size_t secondFeatureNumber = featureNumber; secondFeatureNumber < featuresCount; ++secondFeatureNumber) {
+                centeredOLSMatrix.push_back(LinearizedOLSMatrix[olsMatrixElementIdx++] - featureSums[featureNumber] * featureSums[secondFeatureNumber] / sumWeights);
+            }
+            ++olsMatrixElementIdx;
+            centeredOLSVector[featureNumber] = OLSVector[featureNumber] - featureSums[featureNumber] * goalsMean;
+        }
+    }
+
+    std::vector<std::vector<double>> solutions = NLinearRegressionInner::RidgePath(centeredOLSMatrix, centeredOLSVector, regularizationParameters);
+    for (size_t modelIdx = 0; modelIdx < models.size(); ++modelIdx) {
+        TLinearModel& model = models[modelIdx];
+        model.Coefficients.swap(solutions[modelIdx]);
+
+        model.Intercept = goalsMean;
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            model.Intercept -= model.Coefficients[featureNumber] * featureSums[featureNumber] / sumWeights;
+        }
+    }
+
+    return models;
+}
+
+double TFastLRSolver::Leverage(const TLRSolution& solution, const TFeaturesView& features, const double weight) const {
+    thread_local std::vector<double> extendedFeatures;
+    extendedFeatures.assign(features.begin(), features.end());
+    extendedFeatures.push_back(1.);
+
+    return weight * solution.InverseQuadraticForm(extendedFeatures);
+}
+
+void TFastLRSolver::FinishModel(TLinearModel& linearModel) const {
     if (!linearModel.Coefficients.empty()) {
         linearModel.Intercept = linearModel.Coefficients.back();
         linearModel.Coefficients.pop_back();
     }
+}
 
-    return linearModel;
+TLinearModel TFastLRSolver::Solve() const {
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.Model;
 }
 
 double TFastLRSolver::SumSquaredErrors() const {
-    const std::vector<double> coefficients = NLinearRegressionInner::Solve(LinearizedOLSMatrix, OLSVector);
-    return NLinearRegressionInner::SumSquaredErrors(LinearizedOLSMatrix, OLSVector, coefficients, SumSquaredGoals);
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.SumSquaredErrors;
+}
+
+void TSparseLRSolver::Add(const std::vector<TSparseFeature>& features, const double goal, const double weight) {
+    const auto isNotAscending = [](const TSparseFeature& left, const TSparseFeature& right) {
+        return left.Index >= right.Index;
+    };
+    if (std::adjacent_find(features.begin(), features.end(), isNotAscending) != features.end()) {
+        thread_local std::vector<TSparseFeature> sortedFeatures;
+        sortedFeatures = features;
+        std::sort(sortedFeatures.begin(), sortedFeatures.end(), [](const TSparseFeature& left, const TSparseFeature& right) {
+            return left.Index < right.Index;
+        });
+
+        size_t uniqueFeaturesCount = 0;
+        for (const TSparseFeature& feature : sortedFeatures) {
+            if (uniqueFeaturesCount && sortedFeatures[uniqueFeaturesCount - 1].Index == feature.Index) {
+                sortedFeatures[uniqueFeaturesCount - 1].Value += feature.Value;
+            } else {
+                sortedFeatures[uniqueFeaturesCount++] = feature;
+            }
+        }
+        sortedFeatures.resize(uniqueFeaturesCount);
+
+        Add(sortedFeatures, goal, weight);
+        return;
+    }
+
+    if (!features.empty() && features.back().Index >= FeaturesCount) {
+        Resize(features.back().Index + 1);
+    }
+
+    const double weightedGoal = goal * weight;
+    for (size_t featureIdx = 0; featureIdx < features.size(); ++featureIdx) {
+        const TSparseFeature& feature = features[featureIdx];
+        const double weightedFeature = weight * feature.Value;
+
+        double* matrixRow = &LinearizedOLSMatrix[feature.Index * (feature.Index + 1) / 2];
+        for (size_t columnIdx = 0; columnIdx <= featureIdx; ++columnIdx) {
+            matrixRow[features[columnIdx].Index] += weightedFeature * features[columnIdx].Value;
+        }
+
+        FeatureSums[feature.Index] += weightedFeature;
+        OLSVector[feature.Index] += feature.Value * weightedGoal;
+    }
+
+    SumGoals += weightedGoal;
+    SumWeights += weight;
+    SumSquaredGoals += goal * goal * weight;
+}
+
+void TSparseLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
+    if (features.size() > FeaturesCount) {
+        Resize(features.size());
+    }
+
+    thread_local std::vector<TSparseFeature> sparseFeatures;
+    sparseFeatures.clear();
+    for (size_t featureNumber = 0; featureNumber < features.size(); ++featureNumber) {
+        if (features[featureNumber]) {
+            sparseFeatures.push_back({featureNumber, features[featureNumber]});
+        }
+    }
+
+    Add(sparseFeatures, goal, weight);
 }
 
-bool TWelfordLRSolver::PrepareMeans(const std::vector<double>& features, const double weight) {
+void TSparseLRSolver::Merge(const TSparseLRSolver& other) {
+    if (other.FeaturesCount > FeaturesCount) {
+        Resize(other.FeaturesCount);
+    }
+
+    // the lower triangle of the narrower solver is a prefix of the wider one
+    for (size_t elementIdx = 0; elementIdx < other.LinearizedOLSMatrix.size(); ++elementIdx) {
+        LinearizedOLSMatrix[elementIdx] += other.LinearizedOLSMatrix[elementIdx];
+    }
+    for (size_t featureNumber = 0; featureNumber < other.FeaturesCount; ++featureNumber) {
+        FeatureSums[featureNumber] += other.FeatureSums[featureNumber];
+        OLSVector[featureNumber] += other.OLSVector[featureNumber];
+    }
+
+    SumGoals += other.SumGoals;
+    SumWeights += other.SumWeights;
+    SumSquaredGoals += other.SumSquaredGoals;
+}
+
+TLRSolution TSparseLRSolver::Solution() const {
+    TLRSolution solution;
+    Solution(solution);
+    return solution;
+}
+
+void TSparseLRSolver::Solution(TLRSolution& solution) const {
+    if (!SumWeights) {
+        solution = TLRSolution();
+        return;
+    }
+
+    // the packed upper triangle of TFastLRSolver, the intercept being the last feature
+    std::vector<double> olsMatrix;
+    olsMatrix.reserve((FeaturesCount + 1) * (FeaturesCount + 2) / 2);
+    for (size_t row = 0; row < FeaturesCount; ++row) {
+        for (size_t column = row; column < FeaturesCount; ++column) {
+            olsMatrix.push_back(LinearizedOLSMatrix[column * (column + 1) / 2 + row]);
+        }
+        olsMatrix.push_back(FeatureSums[row]);
+    }
+    olsMatrix.push_back(SumWeights);
+
+    std::vector<double> olsVector(OLSVector);
+    olsVector.push_back(SumGoals);
+
+    NLinearRegressionInner::Solve(olsMatrix, olsVector, SumSquaredGoals, solution);
+
+    TLinearModel& linearModel = solution.Model;
+    linearModel.Intercept = linearModel.Coefficients.back();
+    linearModel.Coefficients.pop_back();
+}
+
+TLinearModel TSparseLRSolver::Solve() const {
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.Model;
+}
+
+double TSparseLRSolver::SumSquaredErrors() const {
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.SumSquaredErrors;
+}
+
+void TSparseLRSolver::Resize(const size_t featuresCount) {
+    FeaturesCount = featuresCount;
+    LinearizedOLSMatrix.resize(featuresCount * (featuresCount + 1) / 2);
+    FeatureSums.resize(featuresCount);
+    OLSVector.resize(featuresCount);
+}
+
+bool TWelfordLRSolver::PrepareMeans(const TFeaturesView& features, const double weight) {
     const size_t featuresCount = features.size();
 
     if (FeatureMeans.empty()) {
@@ -69,99 +330,323 @@ bool TWelfordLRSolver::PrepareMeans(const std::vector<double>& features, const d
         return false;
     }
 
+    NVectorKernels::UpdateMeans(featuresCount,
+                                weight,
+                                SumWeights,
+                                features.data(),
+                                FeatureMeans.data(),
+                                FeatureWeightedDeviationFromLastMean.data(),
+                                FeatureDeviationFromNewMean.data());
+
+    return true;
+}
+
+void TWelfordLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
+    if (!PrepareMeans(features, weight)) {
+        return;
+    }
+
+    const size_t featuresCount = features.size();
+
+    double* olsMatrixRow = LinearizedOLSMatrix.data();
+    for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+        const size_t rowSize = featuresCount - featureNumber;
+        NVectorKernels::Axpy(rowSize, FeatureWeightedDeviationFromLastMean[featureNumber], &FeatureDeviationFromNewMean[featureNumber], olsMatrixRow);
+        olsMatrixRow += rowSize;
+    }
+
+    NVectorKernels::Axpy(featuresCount, weight * (goal - GoalsMean), FeatureDeviationFromNewMean.data(), OLSVector.data());
+
+    const double oldGoalsMean = GoalsMean;
+    GoalsMean += weight * (goal - GoalsMean) / SumWeights;
+    GoalsDeviation += weight * (goal - oldGoalsMean) * (goal - GoalsMean);
+}
+
+// Fills an empty solver with the batch statistics. The batch is centered with its own means first,
+// so the scatter matrix is computed from small deviations just like in the per-instance update.
+void TWelfordLRSolver::AccumulateBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) {
+    const size_t batchSize = goals.size();
+    const size_t featuresCount = rows.size() / batchSize;
+
+    for (const double weight : weights) {
+        SumWeights += weight;
+    }
+    if (!SumWeights) {
+        return;
+    }
+
+    FeatureMeans.assign(featuresCount, 0.);
+    for (size_t instanceIdx = 0; instanceIdx < batchSize; ++instanceIdx) {
+        const double weight = weights[instanceIdx];
+        const double* row = &rows[instanceIdx * featuresCount];
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            FeatureMeans[featureNumber] += weight * row[featureNumber];
+        }
+        GoalsMean += weight * goals[instanceIdx];
+    }
+    for (double& featureMean : FeatureMeans) {
+        featureMean /= SumWeights;
+    }
+    GoalsMean /= SumWeights;
+
+    FeatureWeightedDeviationFromLastMean.resize(featuresCount);
+    FeatureDeviationFromNewMean.resize(featuresCount);
+
+    LinearizedOLSMatrix.assign(featuresCount * (featuresCount + 1) / 2, 0.);
+    OLSVector.resize(featuresCount);
+
+    std::vector<double> columns, weightedColumns;
+    NLinearRegressionInner::TransposeBatch(rows, weights, FeatureMeans, columns, weightedColumns);
+    NLinearRegressionInner::AddBatchProduct(weightedColumns, columns, batchSize, LinearizedOLSMatrix);
+
+    std::vector<double> goalDeviations(batchSize);
+    for (size_t instanceIdx = 0; instanceIdx < batchSize; ++instanceIdx) {
+        const double goalDeviation = goals[instanceIdx] - GoalsMean;
+        goalDeviations[instanceIdx] = goalDeviation;
+        GoalsDeviation += weights[instanceIdx] * goalDeviation * goalDeviation;
+    }
     for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
-        const double feature = features[featureNumber];
-        double& featureMean = FeatureMeans[featureNumber];
+        OLSVector[featureNumber] = NVectorKernels::Dot(batchSize, &weightedColumns[featureNumber * batchSize], goalDeviations.data());
+    }
+}
 
-        FeatureWeightedDeviationFromLastMean[featureNumber] = weight * (feature - featureMean);
-        featureMean += weight * (feature - featureMean) / SumWeights;
-        FeatureDeviationFromNewMean[featureNumber] = feature - featureMean;
+void TWelfordLRSolver::AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) {
+    if (goals.empty()) {
+        return;
+    }
+
+    TWelfordLRSolver batchSolver;
+    batchSolver.AccumulateBatch(rows, goals, weights);
+    Merge(batchSolver);
+}
+
+// pairwise update of Chan, Golub & LeVeque: after the call FeatureDeviationFromNewMean holds
+// the differences between the other solver's feature means and the previous own ones
+bool TWelfordLRSolver::PrepareMerge(const TWelfordLRSolver& other, double& leftWeight, double& rightWeight) {
+    if (!other.SumWeights) {
+        return false;
+    }
+    if (!SumWeights) {
+        *this = other;
+        return false;
+    }
+
+    leftWeight = SumWeights;
+    rightWeight = other.SumWeights;
+
+    SumWeights += other.SumWeights;
+    if (!SumWeights) {
+        return false;
+    }
+
+    const size_t featuresCount = FeatureMeans.size();
+    for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+        const double meansDiff = other.FeatureMeans[featureNumber] - FeatureMeans[featureNumber];
+        FeatureDeviationFromNewMean[featureNumber] = meansDiff;
+        FeatureMeans[featureNumber] += rightWeight * meansDiff / SumWeights;
     }
 
     return true;
 }
 
-void TWelfordLRSolver::Add(const std::vector<double>& features, const double goal, const double weight) {
-    if (!PrepareMeans(features, weight)) {
+void TWelfordLRSolver::Merge(const TWelfordLRSolver& other) {
+    double leftWeight, rightWeight;
+    if (!PrepareMerge(other, leftWeight, rightWeight)) {
         return;
     }
 
+    const double mergeFactor = leftWeight * rightWeight / SumWeights;
+
     {
         std::vector<double>::iterator olsMatrixElement = LinearizedOLSMatrix.begin();
-        std::vector<double>::iterator lastMeanDeviation = FeatureWeightedDeviationFromLastMean.begin();
-        std::vector<double>::iterator newMeanDeviation = FeatureDeviationFromNewMean.begin();
-        for (; lastMeanDeviation != FeatureWeightedDeviationFromLastMean.end(); ++lastMeanDeviation, ++newMeanDeviation) {
-            for (std::vector<double>::iterator secondFeatureNewMeanDeviation = newMeanDeviation; secondFeatureNewMeanDeviation != FeatureDeviationFromNewMean.end(); ++secondFeatureNewMeanDeviation) {
-                *olsMatrixElement++ += *lastMeanDeviation * *secondFeatureNewMeanDeviation;
+        std::vector<double>::const_iterator otherOLSMatrixElement = other.LinearizedOLSMatrix.begin();
+        std::vector<double>::const_iterator meansDiff = FeatureDeviationFromNewMean.begin();
+        for (; meansDiff != FeatureDeviationFromNewMean.end(); ++meansDiff) {
+            const double weightedMeansDiff = mergeFactor * *meansDiff;
+            for (std::vector<double>::const_iterator secondMeansDiff = meansDiff; secondMeansDiff != FeatureDeviationFromNewMean.end(); ++secondMeansDiff) {
+                *olsMatrixElement++ += *otherOLSMatrixElement++ + weightedMeansDiff * *secondMeansDiff;
             }
         }
     }
 
-    {
-        std::vector<double>::const_iterator featureNewMeanDeviation = FeatureDeviationFromNewMean.begin();
-        std::vector<double>::iterator olsVectorElement = OLSVector.begin();
-        const double weightedGoalDeviation = weight * (goal - GoalsMean);
-        for (size_t firstFeatureNumber = 0; firstFeatureNumber < features.size(); ++firstFeatureNumber) {
-            *olsVectorElement += weightedGoalDeviation * *featureNewMeanDeviation;
-            ++featureNewMeanDeviation;
-            ++olsVectorElement;
-        }
+    const double goalsMeanDiff = other.GoalsMean - GoalsMean;
+    for (size_t featureNumber = 0; featureNumber < OLSVector.size(); ++featureNumber) {
+        OLSVector[featureNumber] += other.OLSVector[featureNumber] + mergeFactor * FeatureDeviationFromNewMean[featureNumber] * goalsMeanDiff;
     }
 
-    const double oldGoalsMean = GoalsMean;
-    GoalsMean += weight * (goal - GoalsMean) / SumWeights;
-    GoalsDeviation += weight * (goal - oldGoalsMean) * (goal - GoalsMean);
+    GoalsMean += rightWeight * goalsMeanDiff / SumWeights;
+    GoalsDeviation += other.GoalsDeviation + mergeFactor * goalsMeanDiff * goalsMeanDiff;
 }
 
-TLinearModel TWelfordLRSolver::Solve() const {
-    TLinearModel model;
-    model.Coefficients = NLinearRegressionInner::Solve(LinearizedOLSMatrix, OLSVector);
+TLRSolution TWelfordLRSolver::Solution() const {
+    TLRSolution solution;
+    Solution(solution);
+    return solution;
+}
+
+void TWelfordLRSolver::Solution(TLRSolution& solution) const {
+    NLinearRegressionInner::Solve(LinearizedOLSMatrix, OLSVector, GoalsDeviation, solution);
+    FinishModel(solution.Model);
+}
+
+std::vector<TLinearModel> TWelfordLRSolver::RidgePath(const std::vector<double>& regularizationParameters) const {
+    std::vector<TLinearModel> models(regularizationParameters.size());
+
+    std::vector<std::vector<double>> solutions = NLinearRegressionInner::RidgePath(LinearizedOLSMatrix, OLSVector, regularizationParameters);
+    for (size_t modelIdx = 0; modelIdx < models.size(); ++modelIdx) {
+        models[modelIdx].Coefficients.swap(solutions[modelIdx]);
+        FinishModel(models[modelIdx]);
+    }
+
+    return models;
+}
+
+// the OLS matrix is centered, so the intercept contributes weight / sumWeights on its own
+double TWelfordLRSolver::Leverage(const TLRSolution& solution, const TFeaturesView& features, const double weight) const {
+    return weight * (1. / SumWeights + CenteredInverseQuadraticForm(solution, features));
+}
+
+double TWelfordLRSolver::CenteredInverseQuadraticForm(const TLRSolution& solution, const TFeaturesView& features) const {
+    thread_local std::vector<double> featureDeviations;
+    featureDeviations.resize(features.size());
+    for (size_t featureNumber = 0; featureNumber < features.size(); ++featureNumber) {
+        featureDeviations[featureNumber] = features[featureNumber] - FeatureMeans[featureNumber];
+    }
+
+    return solution.InverseQuadraticForm(featureDeviations);
+}
+
+void TWelfordLRSolver::ScaleWeights(const double factor) {
+    SumWeights = SumWeights * factor;
+    for (double& olsMatrixElement : LinearizedOLSMatrix) {
+        olsMatrixElement *= factor;
+    }
+    for (double& olsVectorElement : OLSVector) {
+        olsVectorElement *= factor;
+    }
+    GoalsDeviation *= factor;
+}
+
+void TWelfordLRSolver::FinishModel(TLinearModel& model) const {
     model.Intercept = GoalsMean;
 
     const size_t featuresCount = OLSVector.size();
     for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
         model.Intercept -= FeatureMeans[featureNumber] * model.Coefficients[featureNumber];
     }
+}
 
-    return model;
+TLinearModel TWelfordLRSolver::Solve() const {
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.Model;
 }
 
 double TWelfordLRSolver::SumSquaredErrors() const {
-    const std::vector<double> coefficients = NLinearRegressionInner::Solve(LinearizedOLSMatrix, OLSVector);
-    return NLinearRegressionInner::SumSquaredErrors(LinearizedOLSMatrix, OLSVector, coefficients, GoalsDeviation);
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.SumSquaredErrors;
 }
 
-void TNormalizedWelfordLRSolver::Add(const std::vector<double>& features, const double goal, const double weight) {
+void TNormalizedWelfordLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
     if (!PrepareMeans(features, weight)) {
         return;
     }
 
+    const size_t featuresCount = features.size();
+    const double updateFactor = weight / SumWeights;
+
+    double* olsMatrixRow = LinearizedOLSMatrix.data();
+    for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+        const size_t rowSize = featuresCount - featureNumber;
+        NVectorKernels::NormalizedAxpy(rowSize, FeatureWeightedDeviationFromLastMean[featureNumber], updateFactor, &FeatureDeviationFromNewMean[featureNumber], olsMatrixRow);
+        olsMatrixRow += rowSize;
+    }
+
+    NVectorKernels::NormalizedAxpy(featuresCount, goal - GoalsMean, updateFactor, FeatureDeviationFromNewMean.data(), OLSVector.data());
+
+    const double oldGoalsMean = GoalsMean;
+    GoalsMean += weight * (goal - GoalsMean) / SumWeights;
+    GoalsDeviation += weight * ((goal - oldGoalsMean) * (goal - GoalsMean) - GoalsDeviation) / SumWeights;
+}
+
+void TNormalizedWelfordLRSolver::Merge(const TNormalizedWelfordLRSolver& other) {
+    double leftWeight, rightWeight;
+    if (!PrepareMerge(other, leftWeight, rightWeight)) {
+        return;
+    }
+
+    const double mergeFactor = leftWeight * rightWeight / SumWeights;
+
     {
         std::vector<double>::iterator olsMatrixElement = LinearizedOLSMatrix.begin();
-        std::vector<double>::iterator lastMeanDeviation = FeatureWeightedDeviationFromLastMean.begin();
-        std::vector<double>::iterator newMeanDeviation = FeatureDeviationFromNewMean.begin();
-        for (; lastMeanDeviation != FeatureWeightedDeviationFromLastMean.end(); ++lastMeanDeviation, ++newMeanDeviation) {
-            for (std::vector<double>::iterator secondFeatureNewMeanDeviation = newMeanDeviation; secondFeatureNewMeanDeviation != FeatureDeviationFromNewMean.end(); ++secondFeatureNewMeanDeviation) {
-                *olsMatrixElement += weight * (*lastMeanDeviation * *secondFeatureNewMeanDeviation - *olsMatrixElement) / SumWeights;
+        std::vector<double>::const_iterator otherOLSMatrixElement = other.LinearizedOLSMatrix.begin();
+        std::vector<double>::const_iterator meansDiff = FeatureDeviationFromNewMean.begin();
+        for (; meansDiff != FeatureDeviationFromNewMean.end(); ++meansDiff) {
+            const double weightedMeansDiff = mergeFactor * *meansDiff;
+            for (std::vector<double>::const_iterator secondMeansDiff = meansDiff; secondMeansDiff != FeatureDeviationFromNewMean.end(); ++secondMeansDiff) {
+                *olsMatrixElement += (rightWeight * (*otherOLSMatrixElement - *olsMatrixElement) + weightedMeansDiff * *secondMeansDiff) / SumWeights;
                 ++olsMatrixElement;
+                ++otherOLSMatrixElement;
             }
         }
     }
 
-    {
-        std::vector<double>::const_iterator featureNewMeanDeviation = FeatureDeviationFromNewMean.begin();
-        std::vector<double>::iterator olsVectorElement = OLSVector.begin();
-        const double goalDeviation = goal - GoalsMean;
-        for (size_t firstFeatureNumber = 0; firstFeatureNumber < features.size(); ++firstFeatureNumber) {
-            *olsVectorElement += weight * (goalDeviation * *featureNewMeanDeviation - *olsVectorElement) / SumWeights;
-            ++featureNewMeanDeviation;
-            ++olsVectorElement;
-        }
+    const double goalsMeanDiff = other.GoalsMean - GoalsMean;
+    for (size_t featureNumber = 0; featureNumber < OLSVector.size(); ++featureNumber) {
+        double& olsVectorElement = OLSVector[featureNumber];
+        olsVectorElement += (rightWeight * (other.OLSVector[featureNumber] - olsVectorElement) + mergeFactor * FeatureDeviationFromNewMean[featureNumber] * goalsMeanDiff) / SumWeights;
     }
 
-    const double oldGoalsMean = GoalsMean;
-    GoalsMean += weight * (goal - GoalsMean) / SumWeights;
-    GoalsDeviation += weight * ((goal - oldGoalsMean) * (goal - GoalsMean) - GoalsDeviation) / SumWeights;
+    GoalsMean += rightWeight * goalsMeanDiff / SumWeights;
+    GoalsDeviation += (rightWeight * (other.GoalsDeviation - GoalsDeviation) + mergeFactor * goalsMeanDiff * goalsMeanDiff) / SumWeights;
+}
+
+void TNormalizedWelfordLRSolver::AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) {
+    if (goals.empty()) {
+        return;
+    }
+
+    TNormalizedWelfordLRSolver batchSolver;
+    batchSolver.AccumulateBatch(rows, goals, weights);
+    if (!batchSolver.SumWeights) {
+        return;
+    }
+
+    for (double& olsMatrixElement : batchSolver.LinearizedOLSMatrix) {
+        olsMatrixElement /= batchSolver.SumWeights;
+    }
+    for (double& olsVectorElement : batchSolver.OLSVector) {
+        olsVectorElement /= batchSolver.SumWeights;
+    }
+    batchSolver.GoalsDeviation /= batchSolver.SumWeights;
+
+    Merge(batchSolver);
+}
+
+TLRSolution TNormalizedWelfordLRSolver::Solution() const {
+    TLRSolution solution;
+    Solution(solution);
+    return solution;
+}
+
+void TNormalizedWelfordLRSolver::Solution(TLRSolution& solution) const {
+    TWelfordLRSolver::Solution(solution);
+    solution.SumSquaredErrors *= SumWeights;
+}
+
+// the normalized OLS matrix is divided by the sum of weights
+double TNormalizedWelfordLRSolver::Leverage(const TLRSolution& solution, const TFeaturesView& features, const double weight) const {
+    return weight * (1. + CenteredInverseQuadraticForm(solution, features)) / SumWeights;
+}
+
+// the normalized OLS matrix is divided by the sum of weights, and so are the parameters to regularize it alike
+std::vector<TLinearModel> TNormalizedWelfordLRSolver::RidgePath(const std::vector<double>& regularizationParameters) const {
+    std::vector<double> normalizedParameters(regularizationParameters);
+    for (double& parameter : normalizedParameters) {
+        parameter = SumWeights ? parameter / SumWeights : parameter;
+    }
+    return TWelfordLRSolver::RidgePath(normalizedParameters);
 }
 
 double TNormalizedWelfordLRSolver::MeanSquaredError() const {
@@ -172,121 +657,176 @@ double TNormalizedWelfordLRSolver::SumSquaredErrors() const {
     return MeanSquaredError() * SumWeights;
 }
 
-namespace NLinearRegressionInner {
-    // LDL matrix decomposition, see http://en.wikipedia.org/wiki/Cholesky_decomposition#LDL_decomposition_2
-    bool LDLDecomposition(const std::vector<double>& linearizedOLSMatrix,
-                          const double regularizationThreshold,
-                          const double regularizationParameter,
-                          std::vector<double>& decompositionTrace,
-                          std::vector<std::vector<double>>& decompositionMatrix)
-    {
-        const size_t featuresCount = decompositionTrace.size();
+void TOnlineLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
+    const size_t featuresCount = features.size();
+    if (Decomposition.GetSize() != featuresCount) {
+        Decomposition.ResetToDiagonal(featuresCount, RegularizationParameter);
+    }
 
-        size_t olsMatrixElementIdx = 0;
-        for (size_t rowNumber = 0; rowNumber < featuresCount; ++rowNumber) {
-            double& decompositionTraceElement = decompositionTrace[rowNumber];
-            decompositionTraceElement = linearizedOLSMatrix[olsMatrixElementIdx] + regularizationParameter;
+    TWelfordLRSolver::Add(features, goal, weight);
 
-            std::vector<double>& decompositionRow = decompositionMatrix[rowNumber];
-            for (size_t i = 0; i < rowNumber; ++i) {
-                decompositionTraceElement -= decompositionRow[i] * decompositionRow[i] * decompositionTrace[i];
-            }
+    // the OLS matrix got weight * (x - oldMean) * (x - newMean)^T, which is a multiple of (x - newMean) * (x - newMean)^T
+    const double sumWeights = SumWeights;
+    const double oldSumWeights = sumWeights - weight;
+    if (!weight || !sumWeights || !oldSumWeights) {
+        return;
+    }
+    Decomposition.RankOneUpdate(weight * sumWeights / oldSumWeights, FeatureDeviationFromNewMean);
+}
 
-            if (fabs(decompositionTraceElement) < regularizationThreshold) {
-                return false;
-            }
+void TOnlineLRSolver::AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) {
+    if (goals.empty()) {
+        return;
+    }
 
-            ++olsMatrixElementIdx;
-            decompositionRow[rowNumber] = 1.;
-            for (size_t columnNumber = rowNumber + 1; columnNumber < featuresCount; ++columnNumber) {
-                std::vector<double>& secondDecompositionRow = decompositionMatrix[columnNumber];
-                double& decompositionMatrixElement = secondDecompositionRow[rowNumber];
+    const size_t featuresCount = rows.size() / goals.size();
 
-                decompositionMatrixElement = linearizedOLSMatrix[olsMatrixElementIdx];
+    for (size_t instanceIdx = 0; instanceIdx < goals.size(); ++instanceIdx) {
+        Add(TFeaturesView(rows.data() + instanceIdx * featuresCount, featuresCount), goals[instanceIdx], weights[instanceIdx]);
+    }
+}
 
-                for (size_t j = 0; j < rowNumber; ++j) {
-                    decompositionMatrixElement -= decompositionRow[j] * secondDecompositionRow[j] * decompositionTrace[j];
-                }
+// merged statistics have no rank-one relation to the factors, so they are factorized anew
+void TOnlineLRSolver::Merge(const TOnlineLRSolver& other) {
+    TWelfordLRSolver::Merge(other);
+    Decomposition.Decompose(LinearizedOLSMatrix, OLSVector.size(), 0., RegularizationParameter);
+}
 
-                decompositionMatrixElement /= decompositionTraceElement;
+TLRSolution TOnlineLRSolver::Solution() const {
+    TLRSolution solution;
+    solution.Decomposition = Decomposition;
+    Decomposition.Solve(OLSVector, solution.Model.Coefficients);
+    solution.SumSquaredErrors = NLinearRegressionInner::SumSquaredErrors(LinearizedOLSMatrix, OLSVector, solution.Model.Coefficients, GoalsDeviation);
+    FinishModel(solution.Model);
+    return solution;
+}
 
-                decompositionRow[columnNumber] = decompositionMatrixElement;
-                ++olsMatrixElementIdx;
-            }
-        }
+TLinearModel TOnlineLRSolver::Solve() const {
+    TLinearModel model;
+    Decomposition.Solve(OLSVector, model.Coefficients);
+    FinishModel(model);
+    return model;
+}
 
-        return true;
-    }
+double TOnlineLRSolver::SumSquaredErrors() const {
+    std::vector<double> coefficients;
+    Decomposition.Solve(OLSVector, coefficients);
+    return NLinearRegressionInner::SumSquaredErrors(LinearizedOLSMatrix, OLSVector, coefficients, GoalsDeviation);
+}
 
-    void LDLDecomposition(const std::vector<double>& linearizedOLSMatrix,
-                          std::vector<double>& decompositionTrace,
-                          std::vector<std::vector<double>>& decompositionMatrix)
-    {
-        const double regularizationThreshold = 1e-5;
-        double regularizationParameter = 0.;
-
-        while (!LDLDecomposition(linearizedOLSMatrix,
-                                 regularizationThreshold,
-                                 regularizationParameter,
-                                 decompositionTrace,
-                                 decompositionMatrix))
-        {
-            regularizationParameter = regularizationParameter ? 2 * regularizationParameter : 1e-5;
-        }
+TDecayedWelfordLRSolver::TDecayedWelfordLRSolver(const double halfLife)
+    : DecayFactor(pow(0.5, 1. / halfLife))
+{
+}
+
+void TDecayedWelfordLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
+    WeightsScale /= DecayFactor;
+    TWelfordLRSolver::Add(features, goal, weight * WeightsScale);
+
+    if (WeightsScale > 1e100) {
+        ScaleWeights(1. / WeightsScale);
+        WeightsScale = 1.;
     }
+}
 
-    std::vector<double> SolveLower(const std::vector<std::vector<double>>& decompositionMatrix,
-                                   const std::vector<double>& decompositionTrace,
-                                   const std::vector<double>& olsVector)
-    {
-        const size_t featuresCount = olsVector.size();
+TLRSolution TDecayedWelfordLRSolver::Solution() const {
+    TLRSolution solution;
+    Solution(solution);
+    return solution;
+}
 
-        std::vector<double> solution(featuresCount);
-        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
-            double& solutionElement = solution[featureNumber];
-            solutionElement = olsVector[featureNumber];
+void TDecayedWelfordLRSolver::Solution(TLRSolution& solution) const {
+    TDecayedWelfordLRSolver decayedSolver(*this);
+    decayedSolver.ScaleWeights(1. / WeightsScale);
+    decayedSolver.TWelfordLRSolver::Solution(solution);
+}
 
-            const std::vector<double>& decompositionRow = decompositionMatrix[featureNumber];
-            for (size_t i = 0; i < featureNumber; ++i) {
-                solutionElement -= solution[i] * decompositionRow[i];
-            }
-        }
+TLinearModel TDecayedWelfordLRSolver::Solve() const {
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.Model;
+}
 
-        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
-            solution[featureNumber] /= decompositionTrace[featureNumber];
-        }
+double TDecayedWelfordLRSolver::SumSquaredErrors() const {
+    TLRSolution& solution = TLRSolution::ThreadWorkspace();
+    Solution(solution);
+    return solution.SumSquaredErrors;
+}
+
+TWindowWelfordLRSolver::TWindowWelfordLRSolver(const size_t windowSize)
+    : WindowSize(std::max<size_t>(windowSize, 1))
+{
+}
+
+void TWindowWelfordLRSolver::Add(const TFeaturesView& features, const double goal, const double weight) {
+    Window.push_back({std::vector<double>(features.begin(), features.end()), goal, weight});
+    TWelfordLRSolver::Add(features, goal, weight);
 
-        return solution;
+    if (Window.size() <= WindowSize) {
+        return;
     }
 
-    std::vector<double> SolveUpper(const std::vector<std::vector<double>>& decompositionMatrix,
-                                   const std::vector<double>& lowerSolution)
-    {
-        const size_t featuresCount = lowerSolution.size();
+    const TWindowInstance& oldestInstance = Window.front();
+    TWelfordLRSolver::Add(oldestInstance.Features, oldestInstance.Goal, -oldestInstance.Weight);
+    Window.pop_front();
+
+    if (++RemovalsCount < WindowSize) {
+        return;
+    }
 
-        std::vector<double> solution(featuresCount);
-        for (size_t featureNumber = featuresCount; featureNumber > 0; --featureNumber) {
-            double& solutionElement = solution[featureNumber - 1];
-            solutionElement = lowerSolution[featureNumber - 1];
+    static_cast<TWelfordLRSolver&>(*this) = TWelfordLRSolver();
+    for (const TWindowInstance& instance : Window) {
+        TWelfordLRSolver::Add(instance.Features, instance.Goal, instance.Weight);
+    }
+    RemovalsCount = 0;
+}
 
-            const std::vector<double>& decompositionRow = decompositionMatrix[featureNumber - 1];
-            for (size_t i = featureNumber; i < featuresCount; ++i) {
-                solutionElement -= solution[i] * decompositionRow[i];
-            }
-        }
+TLRSolution& TLRSolution::ThreadWorkspace() {
+    thread_local TLRSolution workspace;
+    return workspace;
+}
+
+std::vector<double> TLRSolution::Solve(const std::vector<double>& rightHandSide) const {
+    std::vector<double> systemSolution;
+    Decomposition.Solve(rightHandSide, systemSolution);
+    return systemSolution;
+}
+
+double TLRSolution::InverseQuadraticForm(const std::vector<double>& vector) const {
+    return Decomposition.InverseQuadraticForm(vector);
+}
 
-        return solution;
+namespace NLinearRegressionInner {
+    void Solve(const std::vector<double>& olsMatrix,
+               const std::vector<double>& olsVector,
+               const double goalsDeviation,
+               TLRSolution& solution)
+    {
+        solution.Decomposition.DecomposeRegularized(olsMatrix, olsVector.size());
+        solution.Decomposition.Solve(olsVector, solution.Model.Coefficients);
+        solution.SumSquaredErrors = SumSquaredErrors(olsMatrix, olsVector, solution.Model.Coefficients, goalsDeviation);
     }
 
-    std::vector<double> Solve(const std::vector<double>& olsMatrix, const std::vector<double>& olsVector) {
-        const size_t featuresCount = olsVector.size();
+    std::vector<std::vector<double>> RidgePath(const std::vector<double>& olsMatrix,
+                                               const std::vector<double>& olsVector,
+                                               const std::vector<double>& regularizationParameters)
+    {
+        TSymmetricEigenDecomposition decomposition;
+        decomposition.Decompose(olsMatrix, olsVector.size());
 
-        std::vector<double> decompositionTrace(featuresCount);
-        std::vector<std::vector<double>> decompositionMatrix(featuresCount, std::vector<double>(featuresCount));
+        std::vector<double> projections;
+        decomposition.Project(olsVector, projections);
 
-        LDLDecomposition(olsMatrix, decompositionTrace, decompositionMatrix);
+        // on rank-deficient matrices small parameters are raised to the floor of DecomposeRegularized,
+        // so that no direction is divided by a vanishing eigenvalue
+        const double minRegularizationParameter = TLDLDecomposition::RegularizationThreshold - decomposition.GetMinEigenvalue();
 
-        return SolveUpper(decompositionMatrix, SolveLower(decompositionMatrix, decompositionTrace, olsVector));
+        std::vector<std::vector<double>> solutions(regularizationParameters.size());
+        for (size_t parameterIdx = 0; parameterIdx < regularizationParameters.size(); ++parameterIdx) {
+            const double regularizationParameter = std::max(regularizationParameters[parameterIdx], minRegularizationParameter);
+            decomposition.SolveProjected(projections, regularizationParameter, solutions[parameterIdx]);
+        }
+        return solutions;
     }
 
     double SumSquaredErrors(const std::vector<double>& olsMatrix,
@@ -310,17 +850,71 @@ namespace NLinearRegressionInner {
         return std::max(0., sumSquaredErrors);
     }
 
-    inline void AddFeaturesProduct(const double weight, const std::vector<double>& features, std::vector<double>& linearizedTriangleMatrix) {
-        std::vector<double>::const_iterator leftFeature = features.begin();
-        std::vector<double>::iterator matrixElement = linearizedTriangleMatrix.begin();
-        for (; leftFeature != features.end(); ++leftFeature, ++matrixElement) {
-            const double weightedFeature = weight * *leftFeature;
-            std::vector<double>::const_iterator rightFeature = leftFeature;
-            for (; rightFeature != features.end(); ++rightFeature, ++matrixElement) {
-                *matrixElement += weightedFeature * *rightFeature;
-            }
-            *matrixElement += weightedFeature;
+    inline void AddFeaturesProduct(const double weight, const TFeaturesView& features, std::vector<double>& linearizedTriangleMatrix) {
+        const size_t featuresCount = features.size();
+
+        double* matrixRow = linearizedTriangleMatrix.data();
+        for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+            const size_t rowSize = featuresCount - featureNumber;
+            const double weightedFeature = weight * features[featureNumber];
+            NVectorKernels::Axpy(rowSize, weightedFeature, features.data() + featureNumber, matrixRow);
+            matrixRow[rowSize] += weightedFeature;
+            matrixRow += rowSize + 1;
         }
         linearizedTriangleMatrix.back() += weight;
     }
+
+    // stores the batch column by column, features shifted by the means, along with the weighted copy
+    void TransposeBatch(const std::vector<double>& rows,
+                        const std::vector<double>& weights,
+                        const std::vector<double>& means,
+                        std::vector<double>& columns,
+                        std::vector<double>& weightedColumns)
+    {
+        const size_t batchSize = weights.size();
+        const size_t featuresCount = means.size();
+
+        columns.resize(featuresCount * batchSize);
+        weightedColumns.resize(featuresCount * batchSize);
+
+        for (size_t instanceIdx = 0; instanceIdx < batchSize; ++instanceIdx) {
+            const double weight = weights[instanceIdx];
+            const double* row = &rows[instanceIdx * featuresCount];
+            for (size_t featureNumber = 0; featureNumber < featuresCount; ++featureNumber) {
+                const double deviation = row[featureNumber] - means[featureNumber];
+                columns[featureNumber * batchSize + instanceIdx] = deviation;
+                weightedColumns[featureNumber * batchSize + instanceIdx] = weight * deviation;
+            }
+        }
+    }
+
+    // SYRK-like update of the packed upper triangle with the batch Gram matrix: element (i, j) gets the dot product
+    // of the i-th weighted column and the j-th column. The triangle is walked in square tiles, so the columns
+    // of both tile sides stay in cache while every matrix element is touched once per batch.
+    void AddBatchProduct(const std::vector<double>& weightedColumns,
+                         const std::vector<double>& columns,
+                         const size_t batchSize,
+                         std::vector<double>& linearizedTriangleMatrix)
+    {
+        const size_t tileSize = 32;
+        const size_t columnsCount = columns.size() / batchSize;
+
+        for (size_t rowTile = 0; rowTile < columnsCount; rowTile += tileSize) {
+            const size_t rowTileEnd = std::min(rowTile + tileSize, columnsCount);
+            for (size_t columnTile = rowTile; columnTile < columnsCount; columnTile += tileSize) {
+                const size_t columnTileEnd = std::min(columnTile + tileSize, columnsCount);
+                for (size_t row = rowTile; row < rowTileEnd; ++row) {
+                    double* matrixRow = &linearizedTriangleMatrix[row * columnsCount - row * (row - 1) / 2 - row];
+                    const double* weightedColumn = &weightedColumns[row * batchSize];
+                    size_t column = std::max(row, columnTile);
+                    for (; column + 4 <= columnTileEnd; column += 4) {
+                        NVectorKernels::AddDots4(batchSize, weightedColumn, &columns[column * batchSize], matrixRow + column);
+                    }
+                    for (; column < columnTileEnd; ++column) {
+                        matrixRow[column] += NVectorKernels::Dot(batchSize, weightedColumn, &columns[column * batchSize]);
+                    }
+                }
+            }
+        }
+    }
 }
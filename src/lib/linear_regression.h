@@ -1,8 +1,51 @@
 #pragma once
 
+#include "ldl_decomposition.h"
 #include "linear_model.h"
+#include "metrics.h"
 #include "welford.h"
 
+#include <deque>
+
+// The outcome of a single factorization of the OLS system: the model, its sum of squared errors and the LDL
+// factors of the regularized OLS matrix, which are reused for solving the system with other right-hand sides.
+struct TLRSolution {
+    TLinearModel Model;
+    double SumSquaredErrors = 0.;
+
+    TLDLDecomposition Decomposition;
+
+    std::vector<double> Solve(const std::vector<double>& rightHandSide) const;
+    double InverseQuadraticForm(const std::vector<double>& vector) const;
+
+    double RegularizationParameter() const {
+        return Decomposition.GetRegularizationParameter();
+    }
+
+    // the solution object of the calling thread, for the solves which keep only the model or the errors:
+    // its factors and coefficients buffers are reused by every such solve of the thread
+    static TLRSolution& ThreadWorkspace();
+};
+
+namespace NLinearRegressionInner {
+    // factorizes the OLS matrix into solution.Decomposition, puts the solution of the system into
+    // solution.Model.Coefficients and its sum of squared errors into solution.SumSquaredErrors
+    void Solve(const std::vector<double>& olsMatrix,
+               const std::vector<double>& olsVector,
+               const double goalsDeviation,
+               TLRSolution& solution);
+
+    // solutions of the OLS system regularized with every parameter, all from a single eigendecomposition
+    std::vector<std::vector<double>> RidgePath(const std::vector<double>& olsMatrix,
+                                               const std::vector<double>& olsVector,
+                                               const std::vector<double>& regularizationParameters);
+
+    double SumSquaredErrors(const std::vector<double>& olsMatrix,
+                            const std::vector<double>& olsVector,
+                            const std::vector<double>& solution,
+                            const double goalsDeviation);
+}
+
 class TFastLRSolver {
 private:
     TKahanAccumulator SumSquaredGoals;
@@ -11,13 +54,69 @@ private:
     std::vector<double> OLSVector;
 
 public:
-    void Add(const std::vector<double>& features, const double goal, const double weight = 1.);
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+    void AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights);
+    void Merge(const TFastLRSolver& other);
+    TLRSolution Solution() const;
+    void Solution(TLRSolution& solution) const;
     TLinearModel Solve() const;
     double SumSquaredErrors() const;
 
+    // models for every ridge regularization parameter, the parameter being added to the diagonal of the centered
+    // features scatter matrix, so that the intercept is not regularized
+    std::vector<TLinearModel> RidgePath(const std::vector<double>& regularizationParameters) const;
+
+    // the diagonal element of the hat matrix for the instance, given the solution of this solver
+    double Leverage(const TLRSolution& solution, const TFeaturesView& features, const double weight) const;
+
     static const std::string Name() {
         return "fast LR";
     }
+
+private:
+    // turns the solution of the OLS system into the model
+    void FinishModel(TLinearModel& linearModel) const;
+};
+
+struct TSparseFeature {
+    size_t Index;
+    double Value;
+};
+
+// The same OLS system as TFastLRSolver's, updated only in the cells of the instance's non-zero features:
+// an instance costs O(nnz^2) instead of O(d^2). The features part is a packed lower triangle, which keeps
+// its layout when new features appear, while the intercept row lives in FeatureSums and SumWeights.
+class TSparseLRSolver {
+private:
+    TKahanAccumulator SumSquaredGoals;
+    double SumGoals = 0.;
+    double SumWeights = 0.;
+
+    size_t FeaturesCount = 0;
+    std::vector<double> LinearizedOLSMatrix;
+    std::vector<double> FeatureSums;
+    std::vector<double> OLSVector;
+
+public:
+    // the non-zero features of an instance; the rows out of the ascending order of indices are sorted first,
+    // the values of a repeated index being summed
+    void Add(const std::vector<TSparseFeature>& features, const double goal, const double weight = 1.);
+
+    // adds the non-zero features of a dense row, the features count being at least its size
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+
+    void Merge(const TSparseLRSolver& other);
+    TLRSolution Solution() const;
+    void Solution(TLRSolution& solution) const;
+    TLinearModel Solve() const;
+    double SumSquaredErrors() const;
+
+    static const std::string Name() {
+        return "sparse LR";
+    }
+
+private:
+    void Resize(const size_t featuresCount);
 };
 
 class TWelfordLRSolver {
@@ -35,21 +134,44 @@ protected:
     TKahanAccumulator SumWeights;
 
 public:
-    void Add(const std::vector<double>& features, const double goal, const double weight = 1.);
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+    void AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights);
+    void Merge(const TWelfordLRSolver& other);
+    TLRSolution Solution() const;
+    void Solution(TLRSolution& solution) const;
     TLinearModel Solve() const;
     double SumSquaredErrors() const;
 
+    // models for every ridge regularization parameter, the parameter being added to the diagonal of the centered
+    // features scatter matrix, so that the intercept is not regularized
+    std::vector<TLinearModel> RidgePath(const std::vector<double>& regularizationParameters) const;
+
+    // the diagonal element of the hat matrix for the instance, given the solution of this solver
+    double Leverage(const TLRSolution& solution, const TFeaturesView& features, const double weight) const;
+
     static const std::string Name() {
         return "Welford LR";
     }
 
 protected:
-    bool PrepareMeans(const std::vector<double>& features, const double weight);
+    void FinishModel(TLinearModel& model) const;
+    // multiplies the weights of all the instances added so far by the factor
+    void ScaleWeights(const double factor);
+    double CenteredInverseQuadraticForm(const TLRSolution& solution, const TFeaturesView& features) const;
+    bool PrepareMeans(const TFeaturesView& features, const double weight);
+    bool PrepareMerge(const TWelfordLRSolver& other, double& leftWeight, double& rightWeight);
+    void AccumulateBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights);
 };
 
 class TNormalizedWelfordLRSolver: public TWelfordLRSolver {
 public:
-    void Add(const std::vector<double>& features, const double goal, const double weight = 1.);
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+    void AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights);
+    void Merge(const TNormalizedWelfordLRSolver& other);
+    TLRSolution Solution() const;
+    void Solution(TLRSolution& solution) const;
+    std::vector<TLinearModel> RidgePath(const std::vector<double>& regularizationParameters) const;
+    double Leverage(const TLRSolution& solution, const TFeaturesView& features, const double weight) const;
     double MeanSquaredError() const;
     double SumSquaredErrors() const;
 
@@ -57,3 +179,103 @@ public:
         return "normalized Welford LR";
     }
 };
+
+// Welford LR keeping the LDL factors of its OLS matrix up to date with a rank-one update per instance, so that fresh
+// coefficients take O(features^2) at any moment instead of a full factorization. A negative weight removes an instance
+// with a rank-one downdate. The factors start from RegularizationParameter * I, which stays in the system.
+class TOnlineLRSolver: public TWelfordLRSolver {
+private:
+    static constexpr double RegularizationParameter = 1e-5;
+
+    TLDLDecomposition Decomposition;
+
+public:
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+    void AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights);
+    void Merge(const TOnlineLRSolver& other);
+    TLRSolution Solution() const;
+    TLinearModel Solve() const;
+    double SumSquaredErrors() const;
+
+    static const std::string Name() {
+        return "online LR";
+    }
+};
+
+// Welford LR where every instance loses half of its weight after halfLife further instances. Instead of decaying
+// the whole state on every instance, the weights of new instances grow, and the state is rescaled once they get large.
+class TDecayedWelfordLRSolver: public TWelfordLRSolver {
+private:
+    double DecayFactor;
+    double WeightsScale = 1.;
+
+public:
+    explicit TDecayedWelfordLRSolver(const double halfLife = 1e5);
+
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+    void AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) = delete;
+    void Merge(const TDecayedWelfordLRSolver& other) = delete;
+    TLRSolution Solution() const;
+    void Solution(TLRSolution& solution) const;
+    TLinearModel Solve() const;
+    double SumSquaredErrors() const;
+
+    static const std::string Name() {
+        return "decayed Welford LR";
+    }
+};
+
+// Welford LR over the last windowSize instances: the instance leaving the window is removed with a negative weight,
+// and the state is rebuilt from the window after every windowSize removals to stop the rounding errors from piling up.
+class TWindowWelfordLRSolver: public TWelfordLRSolver {
+private:
+    struct TWindowInstance {
+        std::vector<double> Features;
+        double Goal;
+        double Weight;
+    };
+
+    size_t WindowSize;
+    std::deque<TWindowInstance> Window;
+    size_t RemovalsCount = 0;
+
+public:
+    explicit TWindowWelfordLRSolver(const size_t windowSize = 100000);
+
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.);
+    void AddBatch(const std::vector<double>& rows, const std::vector<double>& goals, const std::vector<double>& weights) = delete;
+    void Merge(const TWindowWelfordLRSolver& other) = delete;
+
+    static const std::string Name() {
+        return "window Welford LR";
+    }
+};
+
+// Leave-one-out metrics from a single factorization: the prediction for an instance by the model learned without it
+// differs from the full model's one by the PRESS residual, residual / (1 - leverage).
+// An instance with a leverage close to one is the only support of some direction, so the model learned without it
+// is not defined; such instances are skipped and counted in skippedCount.
+template <typename TSolver>
+TRegressionMetricsCalculator LeaveOneOutMetrics(const TPool& pool, const size_t threadsCount = 1, const size_t batchSize = 0, size_t* skippedCount = nullptr) {
+    const double minLeverageComplement = 1e-8;
+
+    const TSolver solver = ParallelAccumulate<TSolver>(pool.Iterator(), threadsCount, batchSize);
+    const TLRSolution solution = solver.Solution();
+
+    TRegressionMetricsCalculator rmc;
+    size_t skippedInstancesCount = 0;
+    for (const TInstanceView& instance : pool) {
+        const double residual = instance.Goal - solution.Model.Prediction(instance);
+        const double leverage = solver.Leverage(solution, instance.Features, instance.Weight);
+        if (!(1. - leverage >= minLeverageComplement)) {
+            ++skippedInstancesCount;
+            continue;
+        }
+        rmc.Add(instance.Goal - residual / (1. - leverage), instance.Goal, instance.Weight);
+    }
+
+    if (skippedCount) {
+        *skippedCount = skippedInstancesCount;
+    }
+    return rmc;
+}
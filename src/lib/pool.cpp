@@ -1,9 +1,13 @@
+#include "binary_pool.h"
+#include "features_reader.h"
 #include "pool.h"
 
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <thread>
 
 TInstance TInstance::FromFeaturesString(const std::string& featuresString) {
     TInstance instance;
@@ -24,7 +28,26 @@ TInstance TInstance::FromFeaturesString(const std::string& featuresString) {
     return instance;
 }
 
-std::string TInstance::ToFeaturesString() const {
+TInstance TInstance::FromView(const TInstanceView& instanceView) {
+    TInstance instance;
+    instance.QueryId = instanceView.QueryId;
+    instance.Url = instanceView.Url;
+    instance.Features.assign(instanceView.Features.begin(), instanceView.Features.end());
+    instance.Goal = instanceView.Goal;
+    instance.Weight = instanceView.Weight;
+    return instance;
+}
+
+TInstanceView::TInstanceView(const TInstance& instance)
+    : QueryId(instance.QueryId)
+    , Url(instance.Url)
+    , Features(instance.Features)
+    , Goal(instance.Goal)
+    , Weight(instance.Weight)
+{
+}
+
+std::string TInstanceView::ToFeaturesString() const {
     std::stringstream ss;
 
     ss << QueryId << "\t";
@@ -41,7 +64,7 @@ std::string TInstance::ToFeaturesString() const {
     return ss.str();
 }
 
-std::string TInstance::ToVowpalWabbitString() const {
+std::string TInstanceView::ToVowpalWabbitString() const {
     std::stringstream ss;
 
     ss << Goal << " ";
@@ -58,7 +81,7 @@ std::string TInstance::ToVowpalWabbitString() const {
     return ss.str();
 }
 
-std::string TInstance::ToSVMLightString() const {
+std::string TInstanceView::ToSVMLightString() const {
     std::stringstream ss;
 
     ss << Goal;
@@ -73,121 +96,443 @@ std::string TInstance::ToSVMLightString() const {
     return ss.str();
 }
 
-const TInstance& TPool::TCVIterator::operator*() const {
-    return ParentPool[Current - InstanceFoldNumbers.begin()];
+uint32_t TStringTable::Add(const std::string_view value) {
+    const auto idIt = Ids.find(value);
+    if (idIt != Ids.end()) {
+        return idIt->second;
+    }
+
+    // the deque never moves its strings, so the keys of the map stay valid
+    Strings.emplace_back(value);
+    const uint32_t id = Strings.size() - 1;
+    Ids.emplace(Strings.back(), id);
+    return id;
 }
 
-const TInstance* TPool::TCVIterator::operator->() const {
-    return &ParentPool[Current - InstanceFoldNumbers.begin()];
+const TInstanceView& TPool::TCVIterator::operator*() const {
+    const size_t instanceIdx = GetInstanceIdx();
+    if (CurrentInstance.InstanceIdx != instanceIdx) {
+        CurrentInstance.Instance = ParentPool->Get(instanceIdx, Transform, CurrentInstance.TransformedFeatures);
+        CurrentInstance.InstanceIdx = instanceIdx;
+    }
+    return CurrentInstance.Instance;
+}
+
+const TInstanceView* TPool::TCVIterator::operator->() const {
+    return &**this;
 }
 
 TPool::TCVIterator& TPool::TCVIterator::operator++() {
-    Advance();
+    ++Current;
+    if (IteratorType == IT_LEARN) {
+        SkipTestInstances();
+    }
     return *this;
 }
 
-void TPool::TCVIterator::Advance() {
-    while (IsValid()) {
+size_t TPool::TCVIterator::GetInstanceIdx() const {
+    return IteratorType == IT_LEARN ? Current : TestInstances()[Current];
+}
+
+const std::vector<size_t>& TPool::TCVIterator::GetInstanceFoldNumbers() const {
+    return Partition->InstanceFoldNumbers;
+}
+
+const std::vector<size_t>& TPool::TCVIterator::GetFoldInstances(const size_t foldNumber) const {
+    return Partition->FoldInstances[foldNumber];
+}
+
+const std::vector<size_t>& TPool::TCVIterator::TestInstances() const {
+    static const std::vector<size_t> noInstances;
+    return TestFoldNumber < FoldsCount ? Partition->FoldInstances[TestFoldNumber] : noInstances;
+}
+
+void TPool::TCVIterator::SkipTestInstances() {
+    const std::vector<size_t>& testInstances = TestInstances();
+    while (TestPosition < testInstances.size() && testInstances[TestPosition] == Current) {
         ++Current;
-        if (IsValid() && TakeCurrent()) {
-            break;
+        ++TestPosition;
+    }
+}
+
+TPool::TInstanceIterator TPool::begin() const {
+    return TInstanceIterator(*this, 0);
+}
+
+TPool::TInstanceIterator TPool::end() const {
+    return TInstanceIterator(*this, InstancesCount);
+}
+
+void TPool::SetFeaturesCount(const size_t featuresCount) {
+    if (!InstancesCount) {
+        Mapping.reset();
+        RowSize = featuresCount;
+    }
+}
+
+void TPool::reserve(const size_t instancesCount) {
+    Detach();
+
+    Features.reserve(instancesCount * RowSize);
+    Goals.reserve(instancesCount);
+    Weights.reserve(instancesCount);
+    QueryIds.reserve(instancesCount);
+    Urls.reserve(instancesCount);
+}
+
+void TPool::push_back(const TInstanceView& instance) {
+    Detach();
+
+    if (!InstancesCount && !RowSize) {
+        RowSize = instance.Features.size();
+        Features.reserve(Goals.capacity() * RowSize);
+    }
+
+    const size_t copiedCount = std::min(RowSize, instance.Features.size());
+    Features.insert(Features.end(), instance.Features.begin(), instance.Features.begin() + copiedCount);
+    Features.resize(Features.size() + RowSize - copiedCount, 0.);
+
+    Goals.push_back(instance.Goal);
+    Weights.push_back(instance.Weight);
+
+    TStringTable& strings = MutableStrings();
+    QueryIds.push_back(strings.Add(instance.QueryId));
+    Urls.push_back(strings.Add(instance.Url));
+
+    ++InstancesCount;
+}
+
+void TPool::Append(const TPool& other) {
+    if (!InstancesCount && !RowSize) {
+        SetFeaturesCount(other.RowSize);
+    }
+    if (other.Mapping || other.RowSize != RowSize) {
+        reserve(InstancesCount + other.InstancesCount);
+        for (const TInstanceView& instance : other) {
+            push_back(instance);
         }
+        return;
     }
+
+    Detach();
+
+    Features.insert(Features.end(), other.Features.begin(), other.Features.end());
+    Goals.insert(Goals.end(), other.Goals.begin(), other.Goals.end());
+    Weights.insert(Weights.end(), other.Weights.begin(), other.Weights.end());
+
+    if (other.Strings == Strings) {
+        QueryIds.insert(QueryIds.end(), other.QueryIds.begin(), other.QueryIds.end());
+        Urls.insert(Urls.end(), other.Urls.begin(), other.Urls.end());
+    } else {
+        TStringTable& strings = MutableStrings();
+        std::vector<uint32_t> stringIds(other.Strings->size());
+        for (size_t stringIdx = 0; stringIdx < stringIds.size(); ++stringIdx) {
+            stringIds[stringIdx] = strings.Add(other.Strings->Get(stringIdx));
+        }
+        for (const uint32_t queryId : other.QueryIds) {
+            QueryIds.push_back(stringIds[queryId]);
+        }
+        for (const uint32_t url : other.Urls) {
+            Urls.push_back(stringIds[url]);
+        }
+    }
+
+    InstancesCount += other.InstancesCount;
+}
+
+size_t TPool::AllocatedBytes() const {
+    return (Features.capacity() + Goals.capacity() + Weights.capacity()) * sizeof(double) +
+           (QueryIds.capacity() + Urls.capacity()) * sizeof(uint32_t);
 }
 
-bool TPool::TCVIterator::TakeCurrent() const {
-    switch (IteratorType) {
-        case IT_LEARN:
-            return *Current != TestFoldNumber;
-        case IT_TEST:
-            return *Current == TestFoldNumber;
+TInstanceView TPool::MappedInstance(const size_t instanceIdx) const {
+    TInstanceView instance;
+    instance.QueryId = Mapping->QueryId(instanceIdx);
+    instance.Url = Mapping->Url(instanceIdx);
+    instance.Features = TFeaturesView(Mapping->InstanceFeatures(instanceIdx), RowSize);
+    instance.Goal = Mapping->Goal(instanceIdx);
+    instance.Weight = Mapping->Weight(instanceIdx);
+    return instance;
+}
+
+void TPool::Detach() {
+    if (!Mapping) {
+        return;
     }
-    return false;
+
+    TPool mappedPool;
+    std::swap(*this, mappedPool);
+    Append(mappedPool);
 }
 
-size_t TPool::TCVIterator::GetInstanceIdx() const {
-    return Current - InstanceFoldNumbers.begin();
+TStringTable& TPool::MutableStrings() {
+    if (Strings.use_count() > 1) {
+        std::shared_ptr<TStringTable> strings = std::make_shared<TStringTable>();
+        for (size_t stringIdx = 0; stringIdx < Strings->size(); ++stringIdx) {
+            strings->Add(Strings->Get(stringIdx));
+        }
+        Strings = std::move(strings);
+    }
+    return *Strings;
 }
 
-size_t TPool::FeaturesCount() const {
-    if (this->empty()) {
-        return 0;
+namespace {
+    bool IsSparseFormat(const EPoolFormat format) {
+        return format == PF_SVM_LIGHT || format == PF_VOWPAL_WABBIT;
+    }
+
+    // a row of a sparse format ends with its last non-zero feature, so the pool is widened to the longest row;
+    // the widening moves every row, so it is done once per batch of rows rather than for every wider row
+    void ReadInstances(TFeaturesReader& featuresReader, const EPoolFormat format, TPool& pool) {
+        if (!IsSparseFormat(format)) {
+            TInstance instance;
+            while (featuresReader.Next(instance)) {
+                pool.push_back(instance);
+            }
+            return;
+        }
+
+        std::vector<TInstance> batch(1 << 14);
+        size_t batchInstancesCount = 0;
+        size_t featuresCount = 0;
+        const auto flushBatch = [&]() {
+            pool.Widen(featuresCount);
+            for (size_t instanceIdx = 0; instanceIdx < batchInstancesCount; ++instanceIdx) {
+                pool.push_back(batch[instanceIdx]);
+            }
+            batchInstancesCount = 0;
+        };
+
+        while (featuresReader.Next(batch[batchInstancesCount])) {
+            featuresCount = std::max(featuresCount, batch[batchInstancesCount].Features.size());
+            if (++batchInstancesCount == batch.size()) {
+                flushBatch();
+            }
+        }
+        flushBatch();
     }
+}
 
-    return this->front().Features.size();
+bool ParsePoolFormat(const std::string& formatName, EPoolFormat& format) {
+    const std::pair<const char*, EPoolFormat> formats[] = {
+        {"auto", PF_AUTO},
+        {"features", PF_FEATURES},
+        {"svm-light", PF_SVM_LIGHT},
+        {"vowpal-wabbit", PF_VOWPAL_WABBIT},
+        {"binary", PF_BINARY},
+    };
+    for (const auto& nameWithFormat : formats) {
+        if (formatName == nameWithFormat.first) {
+            format = nameWithFormat.second;
+            return true;
+        }
+    }
+    return false;
 }
 
-void TPool::ReadFromFeatures(const std::string& featuresPath) {
-    std::ifstream featuresIn(featuresPath);
+size_t TPool::ReadFromFeatures(const std::string& featuresPath, const size_t threadsCount, const EPoolFormat format) {
+    std::error_code errorCode;
+    const size_t fileSize = std::filesystem::file_size(featuresPath, errorCode);
+    if (threadsCount <= 1 || errorCode) {
+        TFeaturesReader featuresReader(featuresPath, format);
+        ReadInstances(featuresReader, format, *this);
+        return featuresReader.GetBytesRead();
+    }
+
+    // the chunks have to pad and cut the rows the way a serial read would, so the features count comes from the first line
+    size_t featuresCount = RowSize;
+    if (!InstancesCount && !featuresCount && !IsSparseFormat(format)) {
+        TFeaturesReader featuresReader(featuresPath, format);
 
-    std::string featuresString;
-    while (getline(featuresIn, featuresString)) {
-        if (featuresString.empty()) {
-            continue;
+        TInstance instance;
+        if (!featuresReader.Next(instance)) {
+            return featuresReader.GetBytesRead();
+        }
+        featuresCount = instance.Features.size();
+    }
+
+    // every chunk takes the lines starting within its range, so the concatenation keeps the file order
+    std::vector<TPool> chunks(threadsCount);
+    for (TPool& chunk : chunks) {
+        chunk.SetFeaturesCount(featuresCount);
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t chunkIdx = 0; chunkIdx < threadsCount; ++chunkIdx) {
+        workers.emplace_back([&featuresPath, &chunks, fileSize, chunkIdx, threadsCount, format]() {
+            TFeaturesReader featuresReader(featuresPath, format, fileSize * chunkIdx / threadsCount, fileSize * (chunkIdx + 1) / threadsCount);
+            ReadInstances(featuresReader, format, chunks[chunkIdx]);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t instancesCount = InstancesCount;
+    for (const TPool& chunk : chunks) {
+        instancesCount += chunk.size();
+        featuresCount = std::max(featuresCount, chunk.FeaturesCount());
+    }
+    if (IsSparseFormat(format)) {
+        Widen(featuresCount);
+        for (TPool& chunk : chunks) {
+            chunk.Widen(featuresCount);
         }
-        this->push_back(TInstance::FromFeaturesString(featuresString));
     }
+    reserve(instancesCount);
+
+    for (TPool& chunk : chunks) {
+        Append(chunk);
+        chunk = TPool();
+    }
+
+    return fileSize;
+}
+
+void TPool::Widen(const size_t featuresCount) {
+    if (featuresCount <= RowSize) {
+        return;
+    }
+    if (!InstancesCount) {
+        SetFeaturesCount(featuresCount);
+        return;
+    }
+
+    Detach();
+
+    // the rows move to the back, so they are moved starting from the last one
+    const size_t oldRowSize = RowSize;
+    Features.resize(InstancesCount * featuresCount);
+    for (size_t instanceIdx = InstancesCount; instanceIdx > 0; --instanceIdx) {
+        double* oldRow = Features.data() + (instanceIdx - 1) * oldRowSize;
+        double* row = Features.data() + (instanceIdx - 1) * featuresCount;
+        std::copy_backward(oldRow, oldRow + oldRowSize, row + oldRowSize);
+        std::fill(row + oldRowSize, row + featuresCount, 0.);
+    }
+    RowSize = featuresCount;
+}
+
+size_t TPool::ReadFromBinary(const std::string& binaryPath) {
+    std::shared_ptr<TMappedPool> mapping = std::make_shared<TMappedPool>();
+    if (!mapping->Open(binaryPath)) {
+        return 0;
+    }
+
+    TPool mappedPool;
+    mappedPool.RowSize = mapping->FeaturesCount();
+    mappedPool.InstancesCount = mapping->InstancesCount();
+    mappedPool.Mapping = mapping;
+
+    if (empty()) {
+        *this = std::move(mappedPool);
+    } else {
+        Append(mappedPool);
+    }
+
+    return mapping->GetFileSize();
+}
+
+size_t TPool::Read(const std::string& path, const size_t threadsCount, EPoolFormat format) {
+    if (format == PF_AUTO) {
+        format = NBinaryPool::IsBinaryPool(path) ? PF_BINARY : TFeaturesReader::DetectFormat(path);
+    }
+    if (format == PF_BINARY) {
+        return ReadFromBinary(path);
+    }
+    return ReadFromFeatures(path, threadsCount, format);
 }
 
 TPool TPool::InjuredPool(const double injureFactor, const double injureOffset) const {
     TPool injuredPool(*this);
+    injuredPool.Detach();
 
-    for (TInstance& instance : injuredPool) {
-        for (double& feature : instance.Features) {
-            feature = feature * injureFactor + injureOffset;
-        }
-        instance.Goal = instance.Goal * injureFactor + injureOffset;
+    for (double& feature : injuredPool.Features) {
+        feature = feature * injureFactor + injureOffset;
+    }
+    for (double& goal : injuredPool.Goals) {
+        goal = goal * injureFactor + injureOffset;
     }
 
     return injuredPool;
 }
 
+TInstanceView TPool::Get(const size_t instanceIdx, const TAffineTransform& transform, std::vector<double>& featuresBuffer) const {
+    TInstanceView instance = (*this)[instanceIdx];
+    if (transform.IsIdentity()) {
+        return instance;
+    }
+
+    featuresBuffer.resize(instance.Features.size());
+    for (size_t featureIdx = 0; featureIdx < featuresBuffer.size(); ++featureIdx) {
+        featuresBuffer[featureIdx] = transform(instance.Features[featureIdx]);
+    }
+    instance.Features = TFeaturesView(featuresBuffer);
+    instance.Goal = transform(instance.Goal);
+    return instance;
+}
+
+TPoolView TPool::InjuredView(const double injureFactor, const double injureOffset) const {
+    return TPoolView(*this, TAffineTransform{injureFactor, injureOffset});
+}
+
+void TPoolView::PrintForFeatures(std::ostream& out) const {
+    std::vector<double> featuresBuffer;
+    for (size_t instanceIdx = 0; instanceIdx < size(); ++instanceIdx) {
+        out << Get(instanceIdx, featuresBuffer).ToFeaturesString() << "\n";
+    }
+}
+
 void TPool::PrintForFeatures(std::ostream& out) const {
-    for (const TInstance& instance : *this) {
+    for (const TInstanceView& instance : *this) {
         out << instance.ToFeaturesString() << "\n";
     }
 }
 
 void TPool::PrintForVowpalWabbit(std::ostream& out) const {
-    for (const TInstance& instance : *this) {
+    for (const TInstanceView& instance : *this) {
         out << instance.ToVowpalWabbitString() << "\n";
     }
 }
 
 void TPool::PrintForSVMLight(std::ostream& out) const {
-    for (const TInstance& instance : *this) {
+    for (const TInstanceView& instance : *this) {
         out << instance.ToSVMLightString() << "\n";
     }
 }
 
-TPool::TSimpleIterator TPool::Iterator() const {
-    return TSimpleIterator(*this);
+TPool::TSimpleIterator TPool::Iterator(const TAffineTransform& transform) const {
+    return TSimpleIterator(*this, transform);
 }
 
-TPool::TCVIterator TPool::LearnIterator(const size_t foldsCount) const {
-    return TPool::TCVIterator(*this, foldsCount, TPool::IT_LEARN);
+TPool::TCVIterator TPool::LearnIterator(const size_t foldsCount, const TAffineTransform& transform) const {
+    return TPool::TCVIterator(*this, foldsCount, TPool::IT_LEARN, transform);
 }
 
-TPool::TCVIterator TPool::TestIterator(const size_t foldsCount) const {
-    return TPool::TCVIterator(*this, foldsCount, TPool::IT_TEST);
+TPool::TCVIterator TPool::TestIterator(const size_t foldsCount, const TAffineTransform& transform) const {
+    return TPool::TCVIterator(*this, foldsCount, TPool::IT_TEST, transform);
 }
 
-TPool::TSimpleIterator::TSimpleIterator(const TPool& parentPool)
-    : ParentPool(parentPool)
-    , Current(ParentPool.begin())
+TPool::TSimpleIterator::TSimpleIterator(const TPool& parentPool, const TAffineTransform& transform)
+    : ParentPool(&parentPool)
+    , Current(0)
+    , Transform(transform)
 {
 }
 
 bool TPool::TSimpleIterator::IsValid() const {
-    return Current != ParentPool.end();
+    return Current != ParentPool->size();
 }
 
-const TInstance& TPool::TSimpleIterator::operator*() const {
-    return *Current;
+const TInstanceView& TPool::TSimpleIterator::operator*() const {
+    if (CurrentInstance.InstanceIdx != Current) {
+        CurrentInstance.Instance = ParentPool->Get(Current, Transform, CurrentInstance.TransformedFeatures);
+        CurrentInstance.InstanceIdx = Current;
+    }
+    return CurrentInstance.Instance;
 }
 
-const TInstance* TPool::TSimpleIterator::operator->() const {
-    return &*Current;
+const TInstanceView* TPool::TSimpleIterator::operator->() const {
+    return &**this;
 }
 
 TPool::TSimpleIterator& TPool::TSimpleIterator::operator++() {
@@ -196,52 +541,75 @@ TPool::TSimpleIterator& TPool::TSimpleIterator::operator++() {
 }
 
 size_t TPool::TSimpleIterator::GetInstanceIdx() const {
-    return Current - ParentPool.begin();
+    return Current;
 }
 
-TPool::TCVIterator::TCVIterator(const TPool& parentPool, const size_t foldsCount, const TPool::ECVIteratorType iteratorType)
-    : ParentPool(parentPool)
+TPool::TCVIterator::TCVIterator(const TPool& parentPool, const size_t foldsCount, const TPool::ECVIteratorType iteratorType, const TAffineTransform& transform)
+    : ParentPool(&parentPool)
     , FoldsCount(foldsCount)
     , IteratorType(iteratorType)
     , TestFoldNumber((size_t)-1)
-    , InstanceFoldNumbers(ParentPool.size())
-    , Current(InstanceFoldNumbers.begin())
+    , Transform(transform)
 {
     ResetShuffle();
 }
 
-TPool::TCVIterator::TCVIterator(const TCVIterator& source)
-    : ParentPool(source.ParentPool)
-    , FoldsCount(source.FoldsCount)
-    , IteratorType(source.IteratorType)
-    , TestFoldNumber(source.TestFoldNumber)
-    , InstanceFoldNumbers(source.InstanceFoldNumbers)
-    , Current(InstanceFoldNumbers.begin() + (source.Current - source.InstanceFoldNumbers.begin()))
-    , RandomGenerator(source.RandomGenerator)
-{
-}
-
 void TPool::TCVIterator::ResetShuffle() {
-    std::vector<size_t> instanceNumbers(ParentPool.size());
-    for (size_t instanceNumber = 0; instanceNumber < ParentPool.size(); ++instanceNumber) {
+    std::vector<size_t> instanceNumbers(ParentPool->size());
+    for (size_t instanceNumber = 0; instanceNumber < ParentPool->size(); ++instanceNumber) {
         instanceNumbers[instanceNumber] = instanceNumber;
     }
     shuffle(instanceNumbers.begin(), instanceNumbers.end(), RandomGenerator);
 
-    for (size_t instancePosition = 0; instancePosition < ParentPool.size(); ++instancePosition) {
-        InstanceFoldNumbers[instanceNumbers[instancePosition]] = instancePosition % FoldsCount;
+    // the iterator copies made before keep the previous partition
+    std::shared_ptr<TFoldPartition> partition = std::make_shared<TFoldPartition>();
+    partition->InstanceFoldNumbers.resize(ParentPool->size());
+    for (size_t instancePosition = 0; instancePosition < ParentPool->size(); ++instancePosition) {
+        partition->InstanceFoldNumbers[instanceNumbers[instancePosition]] = instancePosition % FoldsCount;
+    }
+
+    partition->FoldInstances.resize(FoldsCount);
+    for (size_t fold = 0; fold < FoldsCount; ++fold) {
+        partition->FoldInstances[fold].reserve(ParentPool->size() / FoldsCount + 1);
+    }
+    for (size_t instanceIdx = 0; instanceIdx < ParentPool->size(); ++instanceIdx) {
+        partition->FoldInstances[partition->InstanceFoldNumbers[instanceIdx]].push_back(instanceIdx);
     }
-    Current = InstanceFoldNumbers.begin();
+
+    Partition = std::move(partition);
+    SetTestFold(TestFoldNumber);
+}
+
+void TPool::TCVIterator::ResetShuffle(const uint32_t seed) {
+    RandomGenerator.seed(seed);
+    ResetShuffle();
 }
 
 void TPool::TCVIterator::SetTestFold(const size_t testFoldNumber) {
     TestFoldNumber = testFoldNumber;
-    Current = InstanceFoldNumbers.begin();
-    if (!TakeCurrent()) {
-        Advance();
+    Current = 0;
+    TestPosition = 0;
+    if (IteratorType == IT_LEARN) {
+        SkipTestInstances();
     }
 }
 
+TPool::TCVIterator TPool::TCVIterator::LearnSide(const TAffineTransform& transform) const {
+    TCVIterator learnIterator(*this);
+    learnIterator.IteratorType = IT_LEARN;
+    learnIterator.Transform = transform;
+    learnIterator.SetTestFold(TestFoldNumber);
+    return learnIterator;
+}
+
+TPool::TCVIterator TPool::TCVIterator::TestSide(const TAffineTransform& transform) const {
+    TCVIterator testIterator(*this);
+    testIterator.IteratorType = IT_TEST;
+    testIterator.Transform = transform;
+    testIterator.SetTestFold(TestFoldNumber);
+    return testIterator;
+}
+
 bool TPool::TCVIterator::IsValid() const {
-    return Current != InstanceFoldNumbers.end();
+    return Current < (IteratorType == IT_LEARN ? ParentPool->size() : TestInstances().size());
 }
@@ -1,9 +1,74 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
 #include <vector>
 #include <random>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+
+enum EPoolFormat {
+    PF_AUTO,
+    PF_FEATURES,
+    PF_SVM_LIGHT,
+    PF_VOWPAL_WABBIT,
+    PF_BINARY,
+};
+
+// takes the names of the --format options: auto, features, svm-light, vowpal-wabbit and binary
+bool ParsePoolFormat(const std::string& formatName, EPoolFormat& format);
+
+// Non-owning view of the features of an instance, a stand-in for std::span<const double>.
+class TFeaturesView {
+private:
+    const double* Data = nullptr;
+    size_t Size = 0;
+
+public:
+    TFeaturesView() = default;
+
+    TFeaturesView(const double* data, const size_t size)
+        : Data(data)
+        , Size(size)
+    {
+    }
+
+    TFeaturesView(const std::vector<double>& features)
+        : Data(features.data())
+        , Size(features.size())
+    {
+    }
+
+    const double* data() const {
+        return Data;
+    }
+
+    size_t size() const {
+        return Size;
+    }
+
+    bool empty() const {
+        return !Size;
+    }
+
+    const double* begin() const {
+        return Data;
+    }
+
+    const double* end() const {
+        return Data + Size;
+    }
+
+    double operator[](const size_t featureIdx) const {
+        return Data[featureIdx];
+    }
+};
+
+struct TInstanceView;
 
 struct TInstance {
     std::string QueryId;
@@ -14,86 +79,363 @@ struct TInstance {
     double Weight;
 
     static TInstance FromFeaturesString(const std::string& featuresString);
+    static TInstance FromView(const TInstanceView& instanceView);
+};
+
+// An instance of a pool as the iterators give it out: the features and the strings point into the pool storage.
+struct TInstanceView {
+    std::string_view QueryId;
+    std::string_view Url;
+
+    TFeaturesView Features;
+    double Goal = 0.;
+    double Weight = 1.;
+
+    TInstanceView() = default;
+    TInstanceView(const TInstance& instance);
+
     std::string ToFeaturesString() const;
     std::string ToVowpalWabbitString() const;
     std::string ToSVMLightString() const;
 };
 
-class TPool: public std::vector<TInstance> {
+// Distinct strings of a pool, each stored once; the ids stay valid while new strings are added.
+class TStringTable {
+private:
+    std::deque<std::string> Strings;
+    std::unordered_map<std::string_view, uint32_t> Ids;
+
+public:
+    TStringTable() = default;
+    // the map keys point into Strings, so a copy would refer to the strings of its source
+    TStringTable(const TStringTable&) = delete;
+    TStringTable& operator=(const TStringTable&) = delete;
+
+    uint32_t Add(const std::string_view value);
+
+    std::string_view Get(const uint32_t id) const {
+        return Strings[id];
+    }
+
+    size_t size() const {
+        return Strings.size();
+    }
+};
+
+class TMappedPool;
+class TPoolView;
+
+// value * Factor + Offset, the identity by default
+struct TAffineTransform {
+    double Factor = 1.;
+    double Offset = 0.;
+
+    bool IsIdentity() const {
+        return Factor == 1. && Offset == 0.;
+    }
+
+    double operator()(const double value) const {
+        return value * Factor + Offset;
+    }
+};
+
+// Instances stored column by column: a row-major features matrix, the goals and the weights, and the ids
+// of QueryId and Url in a string table shared by the copies of the pool. Every row has the features count
+// of the first instance added, shorter ones are padded with zeros and longer ones are cut.
+// A pool read from a binary file refers to the mapping of the file and copies it only when instances are added.
+class TPool {
 private:
     enum ECVIteratorType {
         IT_LEARN,
         IT_TEST,
     };
 
+    size_t RowSize = 0;
+    size_t InstancesCount = 0;
+
+    std::vector<double> Features;
+    std::vector<double> Goals;
+    std::vector<double> Weights;
+
+    std::vector<uint32_t> QueryIds;
+    std::vector<uint32_t> Urls;
+    std::shared_ptr<TStringTable> Strings = std::make_shared<TStringTable>();
+
+    std::shared_ptr<const TMappedPool> Mapping;
+
 public:
     class TSimpleIterator;
     class TCVIterator;
+    class TInstanceIterator;
+
+    size_t size() const {
+        return InstancesCount;
+    }
+
+    bool empty() const {
+        return !InstancesCount;
+    }
+
+    size_t FeaturesCount() const {
+        return RowSize;
+    }
+
+    TInstanceView operator[](const size_t instanceIdx) const {
+        if (Mapping) {
+            return MappedInstance(instanceIdx);
+        }
+
+        TInstanceView instance;
+        instance.QueryId = Strings->Get(QueryIds[instanceIdx]);
+        instance.Url = Strings->Get(Urls[instanceIdx]);
+        instance.Features = TFeaturesView(Features.data() + instanceIdx * RowSize, RowSize);
+        instance.Goal = Goals[instanceIdx];
+        instance.Weight = Weights[instanceIdx];
+        return instance;
+    }
+
+    TInstanceIterator begin() const;
+    TInstanceIterator end() const;
+
+    // fixes the features count of an empty pool instead of taking it from the first instance
+    void SetFeaturesCount(const size_t featuresCount);
+
+    void reserve(const size_t instancesCount);
+    void push_back(const TInstanceView& instance);
+    void Append(const TPool& other);
 
-    size_t FeaturesCount() const;
+    // bytes taken by the instances, the string table and the mapped file excluded
+    size_t AllocatedBytes() const;
 
-    void ReadFromFeatures(const std::string& featuresPath);
+    // parses newline-aligned chunks of the file on threadsCount threads, keeping the order of the lines;
+    // returns the size of the file read
+    size_t ReadFromFeatures(const std::string& featuresPath, const size_t threadsCount = 1, const EPoolFormat format = PF_FEATURES);
 
+    // pads every row with zeros up to the features count
+    void Widen(const size_t featuresCount);
+
+    // maps a binary pool file written by the to-binary mode, copying it only if the pool is not empty;
+    // returns the size of the file or zero if it is not a valid binary pool
+    size_t ReadFromBinary(const std::string& binaryPath);
+
+    // reads a pool of any format, detecting it by the beginning of the file for PF_AUTO
+    size_t Read(const std::string& path, const size_t threadsCount = 1, EPoolFormat format = PF_AUTO);
+
+    // the instance with the transform applied to its features and goal, the features transformed into the buffer
+    TInstanceView Get(const size_t instanceIdx, const TAffineTransform& transform, std::vector<double>& featuresBuffer) const;
+
+    // a copy of the pool with feature = feature * factor + offset, the same for the goals
     TPool InjuredPool(const double injureFactor, const double injureOffset) const;
+    // the same transform applied on the fly, without copying the pool
+    TPoolView InjuredView(const double injureFactor, const double injureOffset) const;
 
     void PrintForFeatures(std::ostream& out) const;
     void PrintForVowpalWabbit(std::ostream& out) const;
     void PrintForSVMLight(std::ostream& out) const;
 
-    TSimpleIterator Iterator() const;
+    TSimpleIterator Iterator(const TAffineTransform& transform = TAffineTransform()) const;
+
+    TCVIterator LearnIterator(const size_t foldsCount, const TAffineTransform& transform = TAffineTransform()) const;
+    TCVIterator TestIterator(const size_t foldsCount, const TAffineTransform& transform = TAffineTransform()) const;
+
+private:
+    TInstanceView MappedInstance(const size_t instanceIdx) const;
+    // copies the mapped instances into the pool's own storage
+    void Detach();
+    // copies of a pool share their strings; the table is copied before a shared one would be modified
+    TStringTable& MutableStrings();
+
+    // The view of the instance an iterator dereferenced last, rebuilt only when the iterator moves. The view may point
+    // into the features buffer, so a copy of an iterator starts with an empty cache instead of sharing the source's one.
+    struct TCurrentInstance {
+        TInstanceView Instance;
+        size_t InstanceIdx = (size_t)-1;
+        std::vector<double> TransformedFeatures;
+
+        TCurrentInstance() = default;
+
+        TCurrentInstance(const TCurrentInstance&) {
+        }
+
+        TCurrentInstance& operator=(const TCurrentInstance&) {
+            InstanceIdx = (size_t)-1;
+            return *this;
+        }
+    };
+
+public:
+    class TInstanceIterator {
+    private:
+        const TPool* ParentPool;
+        size_t InstanceIdx;
+
+    public:
+        TInstanceIterator(const TPool& parentPool, const size_t instanceIdx)
+            : ParentPool(&parentPool)
+            , InstanceIdx(instanceIdx)
+        {
+        }
+
+        TInstanceView operator*() const {
+            return (*ParentPool)[InstanceIdx];
+        }
 
-    TCVIterator LearnIterator(const size_t foldsCount) const;
-    TCVIterator TestIterator(const size_t foldsCount) const;
+        TInstanceIterator& operator++() {
+            ++InstanceIdx;
+            return *this;
+        }
 
+        bool operator!=(const TInstanceIterator& other) const {
+            return InstanceIdx != other.InstanceIdx;
+        }
+    };
+
+    // The iterators apply the transform given to every instance they give out; the transformed features live
+    // in a buffer of the iterator, so the views of the instances are then valid only until it moves.
     class TSimpleIterator {
     private:
-        const TPool& ParentPool;
-        TPool::const_iterator Current;
+        const TPool* ParentPool;
+        size_t Current;
+
+        TAffineTransform Transform;
+
+        mutable TCurrentInstance CurrentInstance;
 
     public:
-        TSimpleIterator(const TPool& parentPool);
+        TSimpleIterator(const TPool& parentPool, const TAffineTransform& transform = TAffineTransform());
+
+        bool HasTransientInstances() const {
+            return !Transform.IsIdentity();
+        }
 
         bool IsValid() const;
-        const TInstance& operator*() const;
-        const TInstance* operator->() const;
+        const TInstanceView& operator*() const;
+        const TInstanceView* operator->() const;
         TSimpleIterator& operator++();
         size_t GetInstanceIdx() const;
     };
 
+    // Iterates over the learn or the test part of a cross-validation fold in the order of the pool.
+    // The fold numbers and the sorted instance indices of every fold are computed once per shuffle
+    // and shared by the copies of the iterator, so a copy costs O(1), the test part is walked through
+    // its index list and the learn part skips the test indices as it meets them.
     class TCVIterator {
     private:
-        const TPool& ParentPool;
+        struct TFoldPartition {
+            std::vector<size_t> InstanceFoldNumbers;
+            std::vector<std::vector<size_t>> FoldInstances;
+        };
+
+        const TPool* ParentPool;
 
         size_t FoldsCount;
 
         TPool::ECVIteratorType IteratorType;
         size_t TestFoldNumber;
 
-        std::vector<size_t> InstanceFoldNumbers;
-        std::vector<size_t>::const_iterator Current;
+        std::shared_ptr<const TFoldPartition> Partition;
+
+        // the instance index for the learn iterator and the position in the test fold for the test one
+        size_t Current = 0;
+        // the position in the test fold of the first test instance after the current one
+        size_t TestPosition = 0;
 
         std::mt19937 RandomGenerator;
 
+        TAffineTransform Transform;
+
+        mutable TCurrentInstance CurrentInstance;
+
     public:
         TCVIterator(const TPool& parentPool,
                     const size_t foldsCount,
-                    const TPool::ECVIteratorType iteratorType);
-        TCVIterator(const TCVIterator& source);
+                    const TPool::ECVIteratorType iteratorType,
+                    const TAffineTransform& transform = TAffineTransform());
+
+        bool HasTransientInstances() const {
+            return !Transform.IsIdentity();
+        }
 
         void ResetShuffle();
+        // reseeds the generator first, so that the folds depend on the seed only
+        void ResetShuffle(const uint32_t seed);
 
         void SetTestFold(const size_t testFoldNumber);
 
+        size_t GetFoldsCount() const {
+            return FoldsCount;
+        }
+
+        // the learn or the test iterator over the same folds of the pool seen through the transform, sharing the partition
+        TCVIterator LearnSide(const TAffineTransform& transform = TAffineTransform()) const;
+        TCVIterator TestSide(const TAffineTransform& transform = TAffineTransform()) const;
+
         bool IsValid() const;
 
-        const TInstance& operator*() const;
-        const TInstance* operator->() const;
+        const TInstanceView& operator*() const;
+        const TInstanceView* operator->() const;
         TCVIterator& operator++();
 
         size_t GetInstanceIdx() const;
 
+        // fold number for every instance of the pool under the current shuffle
+        const std::vector<size_t>& GetInstanceFoldNumbers() const;
+
+        // ascending indices of the instances of the fold under the current shuffle
+        const std::vector<size_t>& GetFoldInstances(const size_t foldNumber) const;
+
     private:
-        void Advance();
-        bool TakeCurrent() const;
+        const std::vector<size_t>& TestInstances() const;
+        void SkipTestInstances();
     };
 };
+
+// A pool seen through an affine transform of its features and goals: the transform is applied by the iterators
+// on the fly, so a view costs nothing beyond the pool it refers to. A pool converts to its identity view.
+class TPoolView {
+private:
+    const TPool* Pool;
+    TAffineTransform Transform;
+
+public:
+    TPoolView(const TPool& pool, const TAffineTransform& transform = TAffineTransform())
+        : Pool(&pool)
+        , Transform(transform)
+    {
+    }
+
+    size_t size() const {
+        return Pool->size();
+    }
+
+    size_t FeaturesCount() const {
+        return Pool->FeaturesCount();
+    }
+
+    const TPool& GetPool() const {
+        return *Pool;
+    }
+
+    const TAffineTransform& GetTransform() const {
+        return Transform;
+    }
+
+    TInstanceView Get(const size_t instanceIdx, std::vector<double>& featuresBuffer) const {
+        return Pool->Get(instanceIdx, Transform, featuresBuffer);
+    }
+
+    TPool::TSimpleIterator Iterator() const {
+        return Pool->Iterator(Transform);
+    }
+
+    TPool::TCVIterator LearnIterator(const size_t foldsCount) const {
+        return Pool->LearnIterator(foldsCount, Transform);
+    }
+
+    TPool::TCVIterator TestIterator(const size_t foldsCount) const {
+        return Pool->TestIterator(foldsCount, Transform);
+    }
+
+    // writes the transformed instances one by one
+    void PrintForFeatures(std::ostream& out) const;
+};
@@ -21,6 +21,28 @@ void TWelfordSLRSolver::Add(const double feature, const double goal, const doubl
     Covariation += weightedFeatureDiff * (goal - GoalsMean);
 }
 
+void TWelfordSLRSolver::Merge(const TWelfordSLRSolver& other) {
+    const double leftWeight = SumWeights;
+    const double rightWeight = other.SumWeights;
+
+    SumWeights += other.SumWeights;
+    if (!SumWeights) {
+        return;
+    }
+
+    const double mergeFactor = leftWeight * rightWeight / SumWeights;
+    const double featuresMeanDiff = other.FeaturesMean - FeaturesMean;
+    const double goalsMeanDiff = other.GoalsMean - GoalsMean;
+
+    FeaturesMean += rightWeight * featuresMeanDiff / SumWeights;
+    FeaturesDeviation += other.FeaturesDeviation + mergeFactor * featuresMeanDiff * featuresMeanDiff;
+
+    GoalsMean += rightWeight * goalsMeanDiff / SumWeights;
+    GoalsDeviation += other.GoalsDeviation + mergeFactor * goalsMeanDiff * goalsMeanDiff;
+
+    Covariation += other.Covariation + mergeFactor * featuresMeanDiff * goalsMeanDiff;
+}
+
 double TWelfordSLRSolver::SumSquaredErrors(const double regularizationParameter) const {
     double factor, offset;
     Solve(factor, offset, regularizationParameter);
@@ -45,6 +67,28 @@ void TNormalizedWelfordSLRSolver::Add(const double feature, const double goal, c
     Covariation += weight * ((goal - oldGoalsMean) * (feature - FeaturesMean) - Covariation) / SumWeights;
 }
 
+void TNormalizedWelfordSLRSolver::Merge(const TNormalizedWelfordSLRSolver& other) {
+    const double leftWeight = SumWeights;
+    const double rightWeight = other.SumWeights;
+
+    SumWeights += other.SumWeights;
+    if (!SumWeights) {
+        return;
+    }
+
+    const double mergeFactor = leftWeight * rightWeight / SumWeights;
+    const double featuresMeanDiff = other.FeaturesMean - FeaturesMean;
+    const double goalsMeanDiff = other.GoalsMean - GoalsMean;
+
+    FeaturesMean += rightWeight * featuresMeanDiff / SumWeights;
+    FeaturesDeviation += (rightWeight * (other.FeaturesDeviation - FeaturesDeviation) + mergeFactor * featuresMeanDiff * featuresMeanDiff) / SumWeights;
+
+    GoalsMean += rightWeight * goalsMeanDiff / SumWeights;
+    GoalsDeviation += (rightWeight * (other.GoalsDeviation - GoalsDeviation) + mergeFactor * goalsMeanDiff * goalsMeanDiff) / SumWeights;
+
+    Covariation += (rightWeight * (other.Covariation - Covariation) + mergeFactor * featuresMeanDiff * goalsMeanDiff) / SumWeights;
+}
+
 double TNormalizedWelfordSLRSolver::MeanSquaredError(const double regularizationParameter) const {
     return TWelfordSLRSolver::SumSquaredErrors(regularizationParameter);
 }
@@ -2,8 +2,11 @@
 
 #include "kahan.h"
 #include "linear_model.h"
+#include "vector_kernels.h"
 #include "welford.h"
 
+#include <type_traits>
+
 #define DefaultRegularizationParameter (1e-10)
 
 template <typename TStoreType>
@@ -32,6 +35,18 @@ public:
         SumWeights += weight;
     }
 
+    void Merge(const TTypedFastSLRSolver& other) {
+        SumFeatures += other.SumFeatures;
+        SumSquaredFeatures += other.SumSquaredFeatures;
+
+        SumGoals += other.SumGoals;
+        SumSquaredGoals += other.SumSquaredGoals;
+
+        SumProducts += other.SumProducts;
+
+        SumWeights += other.SumWeights;
+    }
+
     template <typename TFloatType>
     void Solve(TFloatType& factor, TFloatType& intercept, const double regularizationParameter = DefaultRegularizationParameter) const {
         if (!(double)SumGoals) {
@@ -104,6 +119,7 @@ protected:
 
 public:
     void Add(const double feature, const double goal, const double weight = 1.);
+    void Merge(const TWelfordSLRSolver& other);
 
     template <typename TFloatType>
     void Solve(TFloatType& factor, TFloatType& intercept, const double regularizationParameter = DefaultRegularizationParameter) const {
@@ -127,6 +143,7 @@ public:
 class TNormalizedWelfordSLRSolver: public TWelfordSLRSolver {
 public:
     void Add(const double feature, const double goal, const double weight = 1.);
+    void Merge(const TNormalizedWelfordSLRSolver& other);
     double MeanSquaredError(const double regularizationParameter = DefaultRegularizationParameter) const;
     double SumSquaredErrors(const double regularizationParameter = DefaultRegularizationParameter) const;
 
@@ -141,7 +158,7 @@ private:
     std::vector<TSLRSolverType> SLRSolvers;
 
 public:
-    void Add(const std::vector<double>& features, const double goal, const double weight = 1.) {
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.) {
         if (SLRSolvers.empty()) {
             SLRSolvers.resize(features.size());
         }
@@ -151,11 +168,24 @@ public:
         }
     }
 
+    void Merge(const TTypedBestSLRSolver& other) {
+        if (SLRSolvers.empty()) {
+            SLRSolvers.resize(other.SLRSolvers.size());
+        }
+
+        for (size_t featureNumber = 0; featureNumber < other.SLRSolvers.size(); ++featureNumber) {
+            SLRSolvers[featureNumber].Merge(other.SLRSolvers[featureNumber]);
+        }
+    }
+
     TLinearModel Solve(const double regularizationParameter = DefaultRegularizationParameter) const {
         const TSLRSolverType* bestSolver = nullptr;
+        double bestSumSquaredErrors = 0.;
         for (const TSLRSolverType& solver : SLRSolvers) {
-            if (!bestSolver || solver.SumSquaredErrors(regularizationParameter) < bestSolver->SumSquaredErrors(regularizationParameter)) {
+            const double sumSquaredErrors = solver.SumSquaredErrors(regularizationParameter);
+            if (!bestSolver || sumSquaredErrors < bestSumSquaredErrors) {
                 bestSolver = &solver;
+                bestSumSquaredErrors = sumSquaredErrors;
             }
         }
 
@@ -185,10 +215,316 @@ public:
     }
 };
 
+// Best simple regression with the statistics of all the features in arrays of their own instead of a solver
+// per feature: an instance updates every feature in a single vectorized sweep, and the goal statistics,
+// the same for all the features, are kept once. The best feature is found in a single pass over the features.
+template <typename TStoreType>
+class TTypedVectorizedFastBestSLRSolver {
+private:
+    static constexpr bool IsCompensated = std::is_same<TStoreType, TKahanAccumulator>::value;
+
+    size_t FeaturesCount = 0;
+
+    // sums of weighted features, squared features and products with goals, FeaturesCount values each
+    std::vector<double> Moments;
+    std::vector<double> Compensations;
+
+    TStoreType SumGoals = TStoreType();
+    TStoreType SumSquaredGoals = TStoreType();
+
+    TStoreType SumWeights = TStoreType();
+
+public:
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.) {
+        if (Moments.empty()) {
+            Resize(features.size());
+        }
+
+        if constexpr (IsCompensated) {
+            NVectorKernels::AddKahanSLRMoments(FeaturesCount, weight, goal, features.data(), Moments.data(), Compensations.data());
+        } else {
+            NVectorKernels::AddSLRMoments(FeaturesCount, weight, goal, features.data(), Moments.data());
+        }
+
+        SumGoals += goal * weight;
+        SumSquaredGoals += goal * goal * weight;
+
+        SumWeights += weight;
+    }
+
+    void Merge(const TTypedVectorizedFastBestSLRSolver& other) {
+        if (Moments.empty()) {
+            Resize(other.FeaturesCount);
+        }
+
+        for (size_t momentIdx = 0; momentIdx < other.Moments.size(); ++momentIdx) {
+            if constexpr (IsCompensated) {
+                // the same steps as in TKahanAccumulator::operator+=
+                const double y = other.Moment(momentIdx) - Compensations[momentIdx];
+                const double t = Moments[momentIdx] + y;
+                Compensations[momentIdx] = (t - Moments[momentIdx]) - y;
+                Moments[momentIdx] = t;
+            } else {
+                Moments[momentIdx] += other.Moments[momentIdx];
+            }
+        }
+
+        SumGoals += other.SumGoals;
+        SumSquaredGoals += other.SumSquaredGoals;
+
+        SumWeights += other.SumWeights;
+    }
+
+    TLinearModel Solve(const double regularizationParameter = DefaultRegularizationParameter) const {
+        double sumSquaredErrors;
+        const size_t bestFeature = BestFeature(regularizationParameter, sumSquaredErrors);
+
+        TLinearModel model;
+        if (bestFeature < FeaturesCount) {
+            model.Coefficients.resize(FeaturesCount);
+            SolveFeature(bestFeature, model.Coefficients[bestFeature], model.Intercept, regularizationParameter);
+        }
+
+        return model;
+    }
+
+    double SumSquaredErrors(const double regularizationParameter = DefaultRegularizationParameter) const {
+        double sumSquaredErrors = 0.;
+        BestFeature(regularizationParameter, sumSquaredErrors);
+        return sumSquaredErrors;
+    }
+
+    static const std::string Name() {
+        return IsCompensated ? "vectorized Kahan bslr" : "vectorized fast bslr";
+    }
+
+private:
+    void Resize(const size_t featuresCount) {
+        FeaturesCount = featuresCount;
+        Moments.resize(3 * featuresCount);
+        if constexpr (IsCompensated) {
+            Compensations.resize(3 * featuresCount);
+        }
+    }
+
+    double Moment(const size_t momentIdx) const {
+        if constexpr (IsCompensated) {
+            return Moments[momentIdx] + Compensations[momentIdx];
+        }
+        return Moments[momentIdx];
+    }
+
+    // the same solution as the one of TTypedFastSLRSolver
+    void SetupSolutionFactors(const size_t featureNumber, double& productsDeviation, double& featuresDeviation) const {
+        productsDeviation = featuresDeviation = 0.;
+        if (!(double)SumWeights) {
+            return;
+        }
+
+        const double sumFeatures = Moment(featureNumber);
+        featuresDeviation = Moment(FeaturesCount + featureNumber) - sumFeatures / (double)SumWeights * sumFeatures;
+        if (!featuresDeviation) {
+            return;
+        }
+        productsDeviation = Moment(2 * FeaturesCount + featureNumber) - sumFeatures / (double)SumWeights * (double)SumGoals;
+    }
+
+    void SolveFeature(const size_t featureNumber, double& factor, double& intercept, const double regularizationParameter) const {
+        if (!(double)SumGoals) {
+            factor = intercept = 0.;
+            return;
+        }
+
+        double productsDeviation, featuresDeviation;
+        SetupSolutionFactors(featureNumber, productsDeviation, featuresDeviation);
+
+        if (!featuresDeviation) {
+            factor = 0.;
+            intercept = (double)SumGoals / (double)SumWeights;
+            return;
+        }
+
+        factor = productsDeviation / (featuresDeviation + regularizationParameter);
+        intercept = (double)SumGoals / (double)SumWeights - factor * Moment(featureNumber) / (double)SumWeights;
+    }
+
+    // the feature with the least sum of squared errors, FeaturesCount if there are no features
+    size_t BestFeature(const double regularizationParameter, double& bestSumSquaredErrors) const {
+        // every feature is as good as the first one on an empty pool
+        bestSumSquaredErrors = 0.;
+        if (!(double)SumWeights) {
+            return 0;
+        }
+
+        const double sumGoalSquaredDeviations = (double)SumSquaredGoals - (double)SumGoals / (double)SumWeights * (double)SumGoals;
+
+        size_t bestFeature = FeaturesCount;
+        for (size_t featureNumber = 0; featureNumber < FeaturesCount; ++featureNumber) {
+            double productsDeviation, featuresDeviation;
+            SetupSolutionFactors(featureNumber, productsDeviation, featuresDeviation);
+
+            double sumSquaredErrors = sumGoalSquaredDeviations;
+            if (featuresDeviation) {
+                const double factor = productsDeviation / (featuresDeviation + regularizationParameter);
+                sumSquaredErrors = std::max(0., factor * factor * featuresDeviation - 2 * factor * productsDeviation + sumGoalSquaredDeviations);
+            }
+
+            if (bestFeature == FeaturesCount || sumSquaredErrors < bestSumSquaredErrors) {
+                bestFeature = featureNumber;
+                bestSumSquaredErrors = sumSquaredErrors;
+            }
+        }
+
+        return bestFeature;
+    }
+};
+
+template <bool Normalized>
+class TTypedVectorizedWelfordBestSLRSolver {
+private:
+    size_t FeaturesCount = 0;
+
+    std::vector<double> FeaturesMeans;
+    std::vector<double> FeaturesDeviations;
+    std::vector<double> Covariations;
+
+    double GoalsMean = 0.;
+    double GoalsDeviation = 0.;
+
+    TKahanAccumulator SumWeights;
+
+public:
+    void Add(const TFeaturesView& features, const double goal, const double weight = 1.) {
+        if (FeaturesMeans.empty()) {
+            Resize(features.size());
+        }
+
+        SumWeights += weight;
+        if (!SumWeights) {
+            return;
+        }
+
+        const double sumWeights = SumWeights;
+        const double lastGoalsMean = GoalsMean;
+        GoalsMean += weight * (goal - GoalsMean) / sumWeights;
+
+        if constexpr (Normalized) {
+            GoalsDeviation += weight * ((goal - lastGoalsMean) * (goal - GoalsMean) - GoalsDeviation) / sumWeights;
+            NVectorKernels::UpdateNormalizedWelfordSLR(FeaturesCount, weight, sumWeights, goal - lastGoalsMean, features.data(), FeaturesMeans.data(), FeaturesDeviations.data(), Covariations.data());
+        } else {
+            GoalsDeviation += weight * (goal - lastGoalsMean) * (goal - GoalsMean);
+            NVectorKernels::UpdateWelfordSLR(FeaturesCount, weight, sumWeights, goal - GoalsMean, features.data(), FeaturesMeans.data(), FeaturesDeviations.data(), Covariations.data());
+        }
+    }
+
+    // the same pairwise update as in TWelfordSLRSolver::Merge and TNormalizedWelfordSLRSolver::Merge
+    void Merge(const TTypedVectorizedWelfordBestSLRSolver& other) {
+        if (FeaturesMeans.empty()) {
+            Resize(other.FeaturesCount);
+        }
+
+        const double leftWeight = SumWeights;
+        const double rightWeight = other.SumWeights;
+
+        SumWeights += other.SumWeights;
+        if (!SumWeights) {
+            return;
+        }
+
+        const double sumWeights = SumWeights;
+        const double mergeFactor = leftWeight * rightWeight / sumWeights;
+        const double goalsMeanDiff = other.GoalsMean - GoalsMean;
+
+        for (size_t featureNumber = 0; featureNumber < other.FeaturesCount; ++featureNumber) {
+            const double featuresMeanDiff = other.FeaturesMeans[featureNumber] - FeaturesMeans[featureNumber];
+
+            FeaturesMeans[featureNumber] += rightWeight * featuresMeanDiff / sumWeights;
+            MergeElement(FeaturesDeviations[featureNumber], other.FeaturesDeviations[featureNumber], mergeFactor * featuresMeanDiff * featuresMeanDiff, rightWeight, sumWeights);
+            MergeElement(Covariations[featureNumber], other.Covariations[featureNumber], mergeFactor * featuresMeanDiff * goalsMeanDiff, rightWeight, sumWeights);
+        }
+
+        GoalsMean += rightWeight * goalsMeanDiff / sumWeights;
+        MergeElement(GoalsDeviation, other.GoalsDeviation, mergeFactor * goalsMeanDiff * goalsMeanDiff, rightWeight, sumWeights);
+    }
+
+    TLinearModel Solve(const double regularizationParameter = DefaultRegularizationParameter) const {
+        double sumSquaredErrors;
+        const size_t bestFeature = BestFeature(regularizationParameter, sumSquaredErrors);
+
+        TLinearModel model;
+        if (bestFeature < FeaturesCount) {
+            model.Coefficients.resize(FeaturesCount);
+            SolveFeature(bestFeature, model.Coefficients[bestFeature], model.Intercept, regularizationParameter);
+        }
+
+        return model;
+    }
+
+    double SumSquaredErrors(const double regularizationParameter = DefaultRegularizationParameter) const {
+        double sumSquaredErrors = 0.;
+        BestFeature(regularizationParameter, sumSquaredErrors);
+        return sumSquaredErrors;
+    }
+
+    static const std::string Name() {
+        return Normalized ? "vectorized normalized Welford bslr" : "vectorized Welford bslr";
+    }
+
+private:
+    void Resize(const size_t featuresCount) {
+        FeaturesCount = featuresCount;
+        FeaturesMeans.resize(featuresCount);
+        FeaturesDeviations.resize(featuresCount);
+        Covariations.resize(featuresCount);
+    }
+
+    static void MergeElement(double& element, const double otherElement, const double meansCorrection, const double rightWeight, const double sumWeights) {
+        if (Normalized) {
+            element += (rightWeight * (otherElement - element) + meansCorrection) / sumWeights;
+        } else {
+            element += otherElement + meansCorrection;
+        }
+    }
+
+    // the same solution as the one of TWelfordSLRSolver
+    void SolveFeature(const size_t featureNumber, double& factor, double& intercept, const double regularizationParameter) const {
+        if (!FeaturesDeviations[featureNumber]) {
+            factor = 0.;
+            intercept = GoalsMean;
+            return;
+        }
+
+        factor = Covariations[featureNumber] / (FeaturesDeviations[featureNumber] + regularizationParameter);
+        intercept = GoalsMean - factor * FeaturesMeans[featureNumber];
+    }
+
+    // the feature with the least sum of squared errors, FeaturesCount if there are no features
+    size_t BestFeature(const double regularizationParameter, double& bestSumSquaredErrors) const {
+        size_t bestFeature = FeaturesCount;
+        bestSumSquaredErrors = 0.;
+        for (size_t featureNumber = 0; featureNumber < FeaturesCount; ++featureNumber) {
+            double factor, intercept;
+            SolveFeature(featureNumber, factor, intercept, regularizationParameter);
+
+            double sumSquaredErrors = factor * factor * FeaturesDeviations[featureNumber] - 2 * factor * Covariations[featureNumber] + GoalsDeviation;
+            if (Normalized) {
+                sumSquaredErrors *= SumWeights;
+            }
+
+            if (bestFeature == FeaturesCount || sumSquaredErrors < bestSumSquaredErrors) {
+                bestFeature = featureNumber;
+                bestSumSquaredErrors = sumSquaredErrors;
+            }
+        }
+        return bestFeature;
+    }
+};
+
 using TFastSLRSolver = TTypedFastSLRSolver<double>;
 using TKahanSLRSolver = TTypedFastSLRSolver<TKahanAccumulator>;
 
-using TFastBestSLRSolver = TTypedBestSLRSolver<TFastSLRSolver>;
-using TKahanBestSLRSolver = TTypedBestSLRSolver<TKahanSLRSolver>;
-using TWelfordBestSLRSolver = TTypedBestSLRSolver<TWelfordSLRSolver>;
-using TNormalizedWelfordBestSLRSolver = TTypedBestSLRSolver<TNormalizedWelfordSLRSolver>;
+// the solvers of the learning modes; TTypedBestSLRSolver over the simple solvers is the per-feature reference
+using TFastBestSLRSolver = TTypedVectorizedFastBestSLRSolver<double>;
+using TKahanBestSLRSolver = TTypedVectorizedFastBestSLRSolver<TKahanAccumulator>;
+using TWelfordBestSLRSolver = TTypedVectorizedWelfordBestSLRSolver<false>;
+using TNormalizedWelfordBestSLRSolver = TTypedVectorizedWelfordBestSLRSolver<true>;
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Waits of one side of a queue: how many times it found the queue full (for the producer) or empty
+// (for the consumer) and how long it waited in total.
+struct TQueueStalls {
+    size_t Count = 0;
+    double Seconds = 0.;
+};
+
+// Bounded lock-free ring buffer for a single producer thread and a single consumer thread: the positions
+// only grow, each of them is written by its own side, and the slot is published by the release store
+// of the position. The blocking calls spin with yields, which keeps them usable on a single core.
+// The producer-side and the consumer-side counters may be read once both threads are done.
+template <typename T>
+class TSPSCQueue {
+private:
+    std::vector<T> Slots;
+    size_t Mask;
+
+    alignas(64) std::atomic<size_t> Head{0};
+    alignas(64) std::atomic<size_t> Tail{0};
+    std::atomic<bool> Closed{false};
+
+    // producer side
+    alignas(64) size_t PushesCount = 0;
+    size_t OccupancySum = 0;
+    TQueueStalls FullStalls;
+
+    // consumer side
+    alignas(64) TQueueStalls EmptyStalls;
+
+public:
+    // the capacity is rounded up to a power of two
+    explicit TSPSCQueue(const size_t capacity) {
+        size_t slotsCount = 1;
+        while (slotsCount < capacity) {
+            slotsCount *= 2;
+        }
+        Slots.resize(slotsCount);
+        Mask = slotsCount - 1;
+    }
+
+    bool TryPush(T& value) {
+        const size_t tail = Tail.load(std::memory_order_relaxed);
+        const size_t occupancy = tail - Head.load(std::memory_order_acquire);
+        if (occupancy == Slots.size()) {
+            return false;
+        }
+
+        Slots[tail & Mask] = std::move(value);
+        Tail.store(tail + 1, std::memory_order_release);
+
+        ++PushesCount;
+        OccupancySum += occupancy;
+        return true;
+    }
+
+    bool TryPop(T& value) {
+        const size_t head = Head.load(std::memory_order_relaxed);
+        if (head == Tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        value = std::move(Slots[head & Mask]);
+        Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // waits for a free slot, returns false if the stop flag is raised meanwhile
+    bool Push(T& value, const std::atomic<bool>& stop) {
+        bool isPushed = TryPush(value);
+        if (!isPushed) {
+            Wait(FullStalls, [&]() {
+                isPushed = TryPush(value);
+                return isPushed || stop.load(std::memory_order_relaxed);
+            });
+        }
+        return isPushed;
+    }
+
+    // waits for a value, returns false once the queue is closed and drained
+    bool Pop(T& value) {
+        bool isPopped = TryPop(value);
+        if (!isPopped) {
+            Wait(EmptyStalls, [&]() {
+                isPopped = TryPop(value);
+                return isPopped || Closed.load(std::memory_order_acquire);
+            });
+        }
+        // the values pushed right before closing are visible once the closing is
+        return isPopped || TryPop(value);
+    }
+
+    // no values are pushed after closing
+    void Close() {
+        Closed.store(true, std::memory_order_release);
+    }
+
+    size_t Capacity() const {
+        return Slots.size();
+    }
+
+    size_t GetPushesCount() const {
+        return PushesCount;
+    }
+
+    // the mean number of values waiting in the queue as seen by the producer on its pushes
+    double GetMeanOccupancy() const {
+        return PushesCount ? (double)OccupancySum / PushesCount : 0.;
+    }
+
+    const TQueueStalls& GetFullStalls() const {
+        return FullStalls;
+    }
+
+    const TQueueStalls& GetEmptyStalls() const {
+        return EmptyStalls;
+    }
+
+private:
+    template <typename TCondition>
+    static void Wait(TQueueStalls& stalls, TCondition&& condition) {
+        const auto start = std::chrono::steady_clock::now();
+        ++stalls.Count;
+        while (!condition()) {
+            std::this_thread::yield();
+        }
+        stalls.Seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
@@ -0,0 +1,103 @@
+#include "thread_pool.h"
+
+namespace {
+    // the pool and the deque of the worker running on the current thread
+    thread_local const TWorkStealingPool* CurrentPool = nullptr;
+    thread_local size_t CurrentWorkerIdx = 0;
+}
+
+TWorkStealingPool::TWorkStealingPool(const size_t threadsCount) {
+    for (size_t workerIdx = 0; workerIdx < std::max<size_t>(threadsCount, 1); ++workerIdx) {
+        Queues.emplace_back(new TWorkerQueue());
+    }
+    for (size_t workerIdx = 0; workerIdx < Queues.size(); ++workerIdx) {
+        Workers.emplace_back([this, workerIdx]() {
+            Work(workerIdx);
+        });
+    }
+}
+
+TWorkStealingPool::~TWorkStealingPool() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> guard(StateMutex);
+        Stop = true;
+    }
+    JobAdded.notify_all();
+    for (std::thread& worker : Workers) {
+        worker.join();
+    }
+}
+
+void TWorkStealingPool::Add(std::function<void()> job) {
+    const size_t queueIdx = CurrentPool == this ? CurrentWorkerIdx : NextQueueIdx++ % Queues.size();
+
+    ++PendingCount;
+    {
+        std::lock_guard<std::mutex> guard(Queues[queueIdx]->Mutex);
+        Queues[queueIdx]->Jobs.push_back(std::move(job));
+    }
+    {
+        // counted under the state mutex, so that a worker going to sleep cannot miss the job
+        std::lock_guard<std::mutex> guard(StateMutex);
+        ++QueuedCount;
+    }
+    JobAdded.notify_one();
+}
+
+void TWorkStealingPool::Wait() {
+    std::unique_lock<std::mutex> lock(StateMutex);
+    JobsDone.wait(lock, [this]() {
+        return !PendingCount;
+    });
+}
+
+void TWorkStealingPool::Work(const size_t workerIdx) {
+    CurrentPool = this;
+    CurrentWorkerIdx = workerIdx;
+
+    std::function<void()> job;
+    while (true) {
+        if (!TakeJob(workerIdx, job)) {
+            std::unique_lock<std::mutex> lock(StateMutex);
+            JobAdded.wait(lock, [this]() {
+                return QueuedCount || Stop;
+            });
+            if (Stop && !QueuedCount) {
+                return;
+            }
+            continue;
+        }
+
+        job();
+        job = nullptr;
+
+        if (!--PendingCount) {
+            std::lock_guard<std::mutex> guard(StateMutex);
+            JobsDone.notify_all();
+        }
+    }
+}
+
+bool TWorkStealingPool::TakeJob(const size_t workerIdx, std::function<void()>& job) {
+    for (size_t shift = 0; shift < Queues.size(); ++shift) {
+        TWorkerQueue& queue = *Queues[(workerIdx + shift) % Queues.size()];
+
+        std::lock_guard<std::mutex> guard(queue.Mutex);
+        if (queue.Jobs.empty()) {
+            continue;
+        }
+
+        if (shift) {
+            job = std::move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+            ++StealsCount;
+        } else {
+            job = std::move(queue.Jobs.back());
+            queue.Jobs.pop_back();
+        }
+        --QueuedCount;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs func(jobIdx) for every job from [0, jobsCount) on threadsCount threads, each thread taking
+// the next job not started yet; the calling thread is one of them. The jobs must only share read-only
+// data or write to their own slots of the results.
+template <typename TFunc>
+void ParallelFor(const size_t jobsCount, size_t threadsCount, TFunc&& func) {
+    threadsCount = std::max<size_t>(1, std::min(threadsCount, jobsCount));
+
+    std::atomic<size_t> nextJobIdx{0};
+    const auto runJobs = [&]() {
+        for (size_t jobIdx = nextJobIdx++; jobIdx < jobsCount; jobIdx = nextJobIdx++) {
+            func(jobIdx);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t threadIdx = 1; threadIdx < threadsCount; ++threadIdx) {
+        workers.emplace_back(runJobs);
+    }
+    runJobs();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Pool of threads for jobs of very different costs which may add more jobs. Every worker has a deque
+// of its own: it pushes the jobs it adds to the back and takes its next job from the back too,
+// finishing the work it has just spawned first, while an idle worker steals the oldest job from
+// the front of another deque. The jobs added from outside the pool are dealt round-robin.
+class TWorkStealingPool {
+private:
+    struct TWorkerQueue {
+        std::mutex Mutex;
+        std::deque<std::function<void()>> Jobs;
+    };
+
+    std::vector<std::unique_ptr<TWorkerQueue>> Queues;
+    std::vector<std::thread> Workers;
+
+    // the jobs waiting in the deques and the jobs added but not finished yet
+    std::atomic<size_t> QueuedCount{0};
+    std::atomic<size_t> PendingCount{0};
+    std::atomic<size_t> NextQueueIdx{0};
+    std::atomic<size_t> StealsCount{0};
+    bool Stop = false;
+
+    std::mutex StateMutex;
+    std::condition_variable JobAdded;
+    std::condition_variable JobsDone;
+
+public:
+    explicit TWorkStealingPool(const size_t threadsCount);
+    ~TWorkStealingPool();
+
+    TWorkStealingPool(const TWorkStealingPool&) = delete;
+    TWorkStealingPool& operator=(const TWorkStealingPool&) = delete;
+
+    void Add(std::function<void()> job);
+
+    // waits for all the jobs, including the ones added by the jobs meanwhile
+    void Wait();
+
+    // jobs taken from the deque of another worker
+    size_t GetStealsCount() const {
+        return StealsCount;
+    }
+
+private:
+    void Work(const size_t workerIdx);
+    bool TakeJob(const size_t workerIdx, std::function<void()>& job);
+};
@@ -0,0 +1,684 @@
+#include "vector_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VECTOR_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    // reference implementations, also used on hosts without AVX2
+    namespace NScalar {
+        void Axpy(const size_t size, const double alpha, const double* x, double* y) {
+            for (size_t idx = 0; idx < size; ++idx) {
+                y[idx] += alpha * x[idx];
+            }
+        }
+
+        void NormalizedAxpy(const size_t size, const double alpha, const double factor, const double* x, double* y) {
+            for (size_t idx = 0; idx < size; ++idx) {
+                y[idx] += factor * (alpha * x[idx] - y[idx]);
+            }
+        }
+
+        void UpdateMeans(const size_t size,
+                         const double weight,
+                         const double sumWeights,
+                         const double* features,
+                         double* means,
+                         double* weightedLastDeviations,
+                         double* newDeviations)
+        {
+            for (size_t idx = 0; idx < size; ++idx) {
+                const double weightedDeviation = weight * (features[idx] - means[idx]);
+                weightedLastDeviations[idx] = weightedDeviation;
+                means[idx] += weightedDeviation / sumWeights;
+                newDeviations[idx] = features[idx] - means[idx];
+            }
+        }
+
+        double Dot(const size_t size, const double* x, const double* y) {
+            double sums[4] = {0., 0., 0., 0.};
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                sums[0] += x[idx] * y[idx];
+                sums[1] += x[idx + 1] * y[idx + 1];
+                sums[2] += x[idx + 2] * y[idx + 2];
+                sums[3] += x[idx + 3] * y[idx + 3];
+            }
+            for (; idx < size; ++idx) {
+                sums[0] += x[idx] * y[idx];
+            }
+
+            return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        }
+
+        void AddDots4(const size_t size, const double* left, const double* columns, double* result) {
+            double sums[4] = {0., 0., 0., 0.};
+            for (size_t idx = 0; idx < size; ++idx) {
+                const double leftValue = left[idx];
+                sums[0] += leftValue * columns[idx];
+                sums[1] += leftValue * columns[size + idx];
+                sums[2] += leftValue * columns[2 * size + idx];
+                sums[3] += leftValue * columns[3 * size + idx];
+            }
+
+            for (size_t i = 0; i < 4; ++i) {
+                result[i] += sums[i];
+            }
+        }
+
+        void AddSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments) {
+            double* sumFeatures = moments;
+            double* sumSquaredFeatures = moments + size;
+            double* sumProducts = moments + 2 * size;
+            for (size_t idx = 0; idx < size; ++idx) {
+                const double feature = features[idx];
+                sumFeatures[idx] += feature * weight;
+                sumSquaredFeatures[idx] += feature * feature * weight;
+                sumProducts[idx] += goal * feature * weight;
+            }
+        }
+
+        // the same steps as in TKahanAccumulator::operator+=
+        inline void KahanAdd(double& sum, double& addition, const double value) {
+            const double y = value - addition;
+            const double t = sum + y;
+            addition = (t - sum) - y;
+            sum = t;
+        }
+
+        void AddKahanSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments, double* compensations) {
+            for (size_t idx = 0; idx < size; ++idx) {
+                const double feature = features[idx];
+                KahanAdd(moments[idx], compensations[idx], feature * weight);
+                KahanAdd(moments[size + idx], compensations[size + idx], feature * feature * weight);
+                KahanAdd(moments[2 * size + idx], compensations[2 * size + idx], goal * feature * weight);
+            }
+        }
+
+        void UpdateWelfordSLR(const size_t size,
+                              const double weight,
+                              const double sumWeights,
+                              const double goalDeviation,
+                              const double* features,
+                              double* means,
+                              double* deviations,
+                              double* covariations)
+        {
+            for (size_t idx = 0; idx < size; ++idx) {
+                const double weightedDeviation = weight * (features[idx] - means[idx]);
+                means[idx] += weightedDeviation / sumWeights;
+                deviations[idx] += weightedDeviation * (features[idx] - means[idx]);
+                covariations[idx] += weightedDeviation * goalDeviation;
+            }
+        }
+
+        void UpdateNormalizedWelfordSLR(const size_t size,
+                                        const double weight,
+                                        const double sumWeights,
+                                        const double lastGoalDeviation,
+                                        const double* features,
+                                        double* means,
+                                        double* deviations,
+                                        double* covariations)
+        {
+            for (size_t idx = 0; idx < size; ++idx) {
+                const double lastDeviation = features[idx] - means[idx];
+                means[idx] += weight * lastDeviation / sumWeights;
+                const double newDeviation = features[idx] - means[idx];
+                deviations[idx] += weight * (lastDeviation * newDeviation - deviations[idx]) / sumWeights;
+                covariations[idx] += weight * (lastGoalDeviation * newDeviation - covariations[idx]) / sumWeights;
+            }
+        }
+    }
+
+#ifdef VECTOR_KERNELS_X86
+    namespace NAvx2 {
+        __attribute__((target("avx2,fma")))
+        inline double HorizontalSum(const __m256d values) {
+            __m128d low = _mm256_castpd256_pd128(values);
+            const __m128d high = _mm256_extractf128_pd(values, 1);
+            low = _mm_add_pd(low, high);
+            return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+        }
+
+        __attribute__((target("avx2,fma")))
+        void Axpy(const size_t size, const double alpha, const double* x, double* y) {
+            const __m256d alphas = _mm256_set1_pd(alpha);
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                _mm256_storeu_pd(y + idx, _mm256_fmadd_pd(alphas, _mm256_loadu_pd(x + idx), _mm256_loadu_pd(y + idx)));
+            }
+            for (; idx < size; ++idx) {
+                y[idx] += alpha * x[idx];
+            }
+        }
+
+        __attribute__((target("avx2,fma")))
+        void NormalizedAxpy(const size_t size, const double alpha, const double factor, const double* x, double* y) {
+            const __m256d alphas = _mm256_set1_pd(alpha);
+            const __m256d factors = _mm256_set1_pd(factor);
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d ys = _mm256_loadu_pd(y + idx);
+                const __m256d diffs = _mm256_fmsub_pd(alphas, _mm256_loadu_pd(x + idx), ys);
+                _mm256_storeu_pd(y + idx, _mm256_fmadd_pd(factors, diffs, ys));
+            }
+            for (; idx < size; ++idx) {
+                y[idx] += factor * (alpha * x[idx] - y[idx]);
+            }
+        }
+
+        __attribute__((target("avx2,fma")))
+        void UpdateMeans(const size_t size,
+                         const double weight,
+                         const double sumWeights,
+                         const double* features,
+                         double* means,
+                         double* weightedLastDeviations,
+                         double* newDeviations)
+        {
+            const __m256d weights = _mm256_set1_pd(weight);
+            const __m256d sumsWeights = _mm256_set1_pd(sumWeights);
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d featureValues = _mm256_loadu_pd(features + idx);
+                const __m256d weightedDeviations = _mm256_mul_pd(weights, _mm256_sub_pd(featureValues, _mm256_loadu_pd(means + idx)));
+                const __m256d newMeans = _mm256_add_pd(_mm256_loadu_pd(means + idx), _mm256_div_pd(weightedDeviations, sumsWeights));
+
+                _mm256_storeu_pd(weightedLastDeviations + idx, weightedDeviations);
+                _mm256_storeu_pd(means + idx, newMeans);
+                _mm256_storeu_pd(newDeviations + idx, _mm256_sub_pd(featureValues, newMeans));
+            }
+            NScalar::UpdateMeans(size - idx, weight, sumWeights, features + idx, means + idx, weightedLastDeviations + idx, newDeviations + idx);
+        }
+
+        __attribute__((target("avx2,fma")))
+        double Dot(const size_t size, const double* x, const double* y) {
+            __m256d sums[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+
+            size_t idx = 0;
+            for (; idx + 16 <= size; idx += 16) {
+                for (size_t i = 0; i < 4; ++i) {
+                    sums[i] = _mm256_fmadd_pd(_mm256_loadu_pd(x + idx + 4 * i), _mm256_loadu_pd(y + idx + 4 * i), sums[i]);
+                }
+            }
+            for (; idx + 4 <= size; idx += 4) {
+                sums[0] = _mm256_fmadd_pd(_mm256_loadu_pd(x + idx), _mm256_loadu_pd(y + idx), sums[0]);
+            }
+
+            double result = HorizontalSum(_mm256_add_pd(_mm256_add_pd(sums[0], sums[1]), _mm256_add_pd(sums[2], sums[3])));
+            for (; idx < size; ++idx) {
+                result += x[idx] * y[idx];
+            }
+            return result;
+        }
+
+        __attribute__((target("avx2,fma")))
+        void AddDots4(const size_t size, const double* left, const double* columns, double* result) {
+            __m256d sums[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d leftValues = _mm256_loadu_pd(left + idx);
+                for (size_t i = 0; i < 4; ++i) {
+                    sums[i] = _mm256_fmadd_pd(leftValues, _mm256_loadu_pd(columns + i * size + idx), sums[i]);
+                }
+            }
+
+            for (size_t i = 0; i < 4; ++i) {
+                double sum = HorizontalSum(sums[i]);
+                for (size_t tailIdx = idx; tailIdx < size; ++tailIdx) {
+                    sum += left[tailIdx] * columns[i * size + tailIdx];
+                }
+                result[i] += sum;
+            }
+        }
+
+        __attribute__((target("avx2,fma")))
+        void AddSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments) {
+            const __m256d weights = _mm256_set1_pd(weight);
+            const __m256d goals = _mm256_set1_pd(goal);
+
+            double* sumFeatures = moments;
+            double* sumSquaredFeatures = moments + size;
+            double* sumProducts = moments + 2 * size;
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d featureValues = _mm256_loadu_pd(features + idx);
+                const __m256d weightedFeatures = _mm256_mul_pd(featureValues, weights);
+                _mm256_storeu_pd(sumFeatures + idx, _mm256_add_pd(_mm256_loadu_pd(sumFeatures + idx), weightedFeatures));
+                _mm256_storeu_pd(sumSquaredFeatures + idx, _mm256_fmadd_pd(weightedFeatures, featureValues, _mm256_loadu_pd(sumSquaredFeatures + idx)));
+                _mm256_storeu_pd(sumProducts + idx, _mm256_fmadd_pd(weightedFeatures, goals, _mm256_loadu_pd(sumProducts + idx)));
+            }
+            for (; idx < size; ++idx) {
+                const double feature = features[idx];
+                sumFeatures[idx] += feature * weight;
+                sumSquaredFeatures[idx] += feature * feature * weight;
+                sumProducts[idx] += goal * feature * weight;
+            }
+        }
+
+        __attribute__((target("avx2,fma")))
+        inline void KahanAdd(double* sums, double* additions, const __m256d values) {
+            const __m256d oldSums = _mm256_loadu_pd(sums);
+            const __m256d ys = _mm256_sub_pd(values, _mm256_loadu_pd(additions));
+            const __m256d ts = _mm256_add_pd(oldSums, ys);
+            _mm256_storeu_pd(additions, _mm256_sub_pd(_mm256_sub_pd(ts, oldSums), ys));
+            _mm256_storeu_pd(sums, ts);
+        }
+
+        __attribute__((target("avx2,fma")))
+        void AddKahanSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments, double* compensations) {
+            const __m256d weights = _mm256_set1_pd(weight);
+            const __m256d goals = _mm256_set1_pd(goal);
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d featureValues = _mm256_loadu_pd(features + idx);
+                KahanAdd(moments + idx, compensations + idx, _mm256_mul_pd(featureValues, weights));
+                KahanAdd(moments + size + idx, compensations + size + idx, _mm256_mul_pd(_mm256_mul_pd(featureValues, featureValues), weights));
+                KahanAdd(moments + 2 * size + idx, compensations + 2 * size + idx, _mm256_mul_pd(_mm256_mul_pd(goals, featureValues), weights));
+            }
+            for (; idx < size; ++idx) {
+                const double feature = features[idx];
+                NScalar::KahanAdd(moments[idx], compensations[idx], feature * weight);
+                NScalar::KahanAdd(moments[size + idx], compensations[size + idx], feature * feature * weight);
+                NScalar::KahanAdd(moments[2 * size + idx], compensations[2 * size + idx], goal * feature * weight);
+            }
+        }
+
+        __attribute__((target("avx2,fma")))
+        void UpdateWelfordSLR(const size_t size,
+                              const double weight,
+                              const double sumWeights,
+                              const double goalDeviation,
+                              const double* features,
+                              double* means,
+                              double* deviations,
+                              double* covariations)
+        {
+            const __m256d weights = _mm256_set1_pd(weight);
+            const __m256d sumsWeights = _mm256_set1_pd(sumWeights);
+            const __m256d goalDeviations = _mm256_set1_pd(goalDeviation);
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d featureValues = _mm256_loadu_pd(features + idx);
+                const __m256d oldMeans = _mm256_loadu_pd(means + idx);
+                const __m256d weightedDeviations = _mm256_mul_pd(weights, _mm256_sub_pd(featureValues, oldMeans));
+                const __m256d newMeans = _mm256_add_pd(oldMeans, _mm256_div_pd(weightedDeviations, sumsWeights));
+
+                _mm256_storeu_pd(means + idx, newMeans);
+                _mm256_storeu_pd(deviations + idx, _mm256_fmadd_pd(weightedDeviations, _mm256_sub_pd(featureValues, newMeans), _mm256_loadu_pd(deviations + idx)));
+                _mm256_storeu_pd(covariations + idx, _mm256_fmadd_pd(weightedDeviations, goalDeviations, _mm256_loadu_pd(covariations + idx)));
+            }
+            NScalar::UpdateWelfordSLR(size - idx, weight, sumWeights, goalDeviation, features + idx, means + idx, deviations + idx, covariations + idx);
+        }
+
+        __attribute__((target("avx2,fma")))
+        void UpdateNormalizedWelfordSLR(const size_t size,
+                                        const double weight,
+                                        const double sumWeights,
+                                        const double lastGoalDeviation,
+                                        const double* features,
+                                        double* means,
+                                        double* deviations,
+                                        double* covariations)
+        {
+            const __m256d weights = _mm256_set1_pd(weight);
+            const __m256d sumsWeights = _mm256_set1_pd(sumWeights);
+            const __m256d lastGoalDeviations = _mm256_set1_pd(lastGoalDeviation);
+
+            size_t idx = 0;
+            for (; idx + 4 <= size; idx += 4) {
+                const __m256d featureValues = _mm256_loadu_pd(features + idx);
+                const __m256d oldMeans = _mm256_loadu_pd(means + idx);
+                const __m256d lastDeviations = _mm256_sub_pd(featureValues, oldMeans);
+                const __m256d newMeans = _mm256_add_pd(oldMeans, _mm256_div_pd(_mm256_mul_pd(weights, lastDeviations), sumsWeights));
+                const __m256d newDeviations = _mm256_sub_pd(featureValues, newMeans);
+
+                const __m256d oldDeviations = _mm256_loadu_pd(deviations + idx);
+                const __m256d deviationsDiffs = _mm256_fmsub_pd(lastDeviations, newDeviations, oldDeviations);
+                const __m256d oldCovariations = _mm256_loadu_pd(covariations + idx);
+                const __m256d covariationsDiffs = _mm256_fmsub_pd(lastGoalDeviations, newDeviations, oldCovariations);
+
+                _mm256_storeu_pd(means + idx, newMeans);
+                _mm256_storeu_pd(deviations + idx, _mm256_add_pd(oldDeviations, _mm256_div_pd(_mm256_mul_pd(weights, deviationsDiffs), sumsWeights)));
+                _mm256_storeu_pd(covariations + idx, _mm256_add_pd(oldCovariations, _mm256_div_pd(_mm256_mul_pd(weights, covariationsDiffs), sumsWeights)));
+            }
+            NScalar::UpdateNormalizedWelfordSLR(size - idx, weight, sumWeights, lastGoalDeviation, features + idx, means + idx, deviations + idx, covariations + idx);
+        }
+    }
+
+    namespace NAvx512 {
+        __attribute__((target("avx512f")))
+        inline __mmask8 TailMask(const size_t tailSize) {
+            return (__mmask8)((1u << tailSize) - 1);
+        }
+
+        // _mm512_reduce_add_pd and _mm512_extractf64x4_pd make gcc warn of their undefined pass-through operand,
+        // so the halves are extracted with an explicit one
+        __attribute__((target("avx512f")))
+        inline double HorizontalSum(const __m512d values) {
+            const __m256d low = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, values, 0);
+            const __m256d high = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, values, 1);
+            const __m256d halves = _mm256_add_pd(low, high);
+            const __m128d quarters = _mm_add_pd(_mm256_castpd256_pd128(halves), _mm256_extractf128_pd(halves, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(quarters, _mm_unpackhi_pd(quarters, quarters)));
+        }
+
+        __attribute__((target("avx512f")))
+        void Axpy(const size_t size, const double alpha, const double* x, double* y) {
+            const __m512d alphas = _mm512_set1_pd(alpha);
+
+            size_t idx = 0;
+            for (; idx + 8 <= size; idx += 8) {
+                _mm512_storeu_pd(y + idx, _mm512_fmadd_pd(alphas, _mm512_loadu_pd(x + idx), _mm512_loadu_pd(y + idx)));
+            }
+            if (idx < size) {
+                const __mmask8 mask = TailMask(size - idx);
+                const __m512d ys = _mm512_maskz_loadu_pd(mask, y + idx);
+                _mm512_mask_storeu_pd(y + idx, mask, _mm512_fmadd_pd(alphas, _mm512_maskz_loadu_pd(mask, x + idx), ys));
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        void NormalizedAxpy(const size_t size, const double alpha, const double factor, const double* x, double* y) {
+            const __m512d alphas = _mm512_set1_pd(alpha);
+            const __m512d factors = _mm512_set1_pd(factor);
+
+            size_t idx = 0;
+            for (; idx + 8 <= size; idx += 8) {
+                const __m512d ys = _mm512_loadu_pd(y + idx);
+                const __m512d diffs = _mm512_fmsub_pd(alphas, _mm512_loadu_pd(x + idx), ys);
+                _mm512_storeu_pd(y + idx, _mm512_fmadd_pd(factors, diffs, ys));
+            }
+            if (idx < size) {
+                const __mmask8 mask = TailMask(size - idx);
+                const __m512d ys = _mm512_maskz_loadu_pd(mask, y + idx);
+                const __m512d diffs = _mm512_fmsub_pd(alphas, _mm512_maskz_loadu_pd(mask, x + idx), ys);
+                _mm512_mask_storeu_pd(y + idx, mask, _mm512_fmadd_pd(factors, diffs, ys));
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        void UpdateMeans(const size_t size,
+                         const double weight,
+                         const double sumWeights,
+                         const double* features,
+                         double* means,
+                         double* weightedLastDeviations,
+                         double* newDeviations)
+        {
+            const __m512d weights = _mm512_set1_pd(weight);
+            const __m512d sumsWeights = _mm512_set1_pd(sumWeights);
+
+            for (size_t idx = 0; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+
+                const __m512d featureValues = _mm512_maskz_loadu_pd(mask, features + idx);
+                const __m512d oldMeans = _mm512_maskz_loadu_pd(mask, means + idx);
+                const __m512d weightedDeviations = _mm512_mul_pd(weights, _mm512_sub_pd(featureValues, oldMeans));
+                const __m512d newMeans = _mm512_add_pd(oldMeans, _mm512_div_pd(weightedDeviations, sumsWeights));
+
+                _mm512_mask_storeu_pd(weightedLastDeviations + idx, mask, weightedDeviations);
+                _mm512_mask_storeu_pd(means + idx, mask, newMeans);
+                _mm512_mask_storeu_pd(newDeviations + idx, mask, _mm512_sub_pd(featureValues, newMeans));
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        double Dot(const size_t size, const double* x, const double* y) {
+            __m512d sums[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+
+            size_t idx = 0;
+            for (; idx + 32 <= size; idx += 32) {
+                for (size_t i = 0; i < 4; ++i) {
+                    sums[i] = _mm512_fmadd_pd(_mm512_loadu_pd(x + idx + 8 * i), _mm512_loadu_pd(y + idx + 8 * i), sums[i]);
+                }
+            }
+            for (; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+                sums[0] = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + idx), _mm512_maskz_loadu_pd(mask, y + idx), sums[0]);
+            }
+
+            return HorizontalSum(_mm512_add_pd(_mm512_add_pd(sums[0], sums[1]), _mm512_add_pd(sums[2], sums[3])));
+        }
+
+        __attribute__((target("avx512f")))
+        void AddDots4(const size_t size, const double* left, const double* columns, double* result) {
+            __m512d sums[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+
+            for (size_t idx = 0; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+                const __m512d leftValues = _mm512_maskz_loadu_pd(mask, left + idx);
+                for (size_t i = 0; i < 4; ++i) {
+                    sums[i] = _mm512_fmadd_pd(leftValues, _mm512_maskz_loadu_pd(mask, columns + i * size + idx), sums[i]);
+                }
+            }
+
+            for (size_t i = 0; i < 4; ++i) {
+                result[i] += HorizontalSum(sums[i]);
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        void AddSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments) {
+            const __m512d weights = _mm512_set1_pd(weight);
+            const __m512d goals = _mm512_set1_pd(goal);
+
+            double* sumFeatures = moments;
+            double* sumSquaredFeatures = moments + size;
+            double* sumProducts = moments + 2 * size;
+
+            for (size_t idx = 0; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+
+                const __m512d featureValues = _mm512_maskz_loadu_pd(mask, features + idx);
+                const __m512d weightedFeatures = _mm512_mul_pd(featureValues, weights);
+                _mm512_mask_storeu_pd(sumFeatures + idx, mask, _mm512_add_pd(_mm512_maskz_loadu_pd(mask, sumFeatures + idx), weightedFeatures));
+                _mm512_mask_storeu_pd(sumSquaredFeatures + idx, mask, _mm512_fmadd_pd(weightedFeatures, featureValues, _mm512_maskz_loadu_pd(mask, sumSquaredFeatures + idx)));
+                _mm512_mask_storeu_pd(sumProducts + idx, mask, _mm512_fmadd_pd(weightedFeatures, goals, _mm512_maskz_loadu_pd(mask, sumProducts + idx)));
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        inline void KahanAdd(const __mmask8 mask, double* sums, double* additions, const __m512d values) {
+            const __m512d oldSums = _mm512_maskz_loadu_pd(mask, sums);
+            const __m512d ys = _mm512_sub_pd(values, _mm512_maskz_loadu_pd(mask, additions));
+            const __m512d ts = _mm512_add_pd(oldSums, ys);
+            _mm512_mask_storeu_pd(additions, mask, _mm512_sub_pd(_mm512_sub_pd(ts, oldSums), ys));
+            _mm512_mask_storeu_pd(sums, mask, ts);
+        }
+
+        __attribute__((target("avx512f")))
+        void AddKahanSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments, double* compensations) {
+            const __m512d weights = _mm512_set1_pd(weight);
+            const __m512d goals = _mm512_set1_pd(goal);
+
+            for (size_t idx = 0; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+
+                const __m512d featureValues = _mm512_maskz_loadu_pd(mask, features + idx);
+                KahanAdd(mask, moments + idx, compensations + idx, _mm512_mul_pd(featureValues, weights));
+                KahanAdd(mask, moments + size + idx, compensations + size + idx, _mm512_mul_pd(_mm512_mul_pd(featureValues, featureValues), weights));
+                KahanAdd(mask, moments + 2 * size + idx, compensations + 2 * size + idx, _mm512_mul_pd(_mm512_mul_pd(goals, featureValues), weights));
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        void UpdateWelfordSLR(const size_t size,
+                              const double weight,
+                              const double sumWeights,
+                              const double goalDeviation,
+                              const double* features,
+                              double* means,
+                              double* deviations,
+                              double* covariations)
+        {
+            const __m512d weights = _mm512_set1_pd(weight);
+            const __m512d sumsWeights = _mm512_set1_pd(sumWeights);
+            const __m512d goalDeviations = _mm512_set1_pd(goalDeviation);
+
+            for (size_t idx = 0; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+
+                const __m512d featureValues = _mm512_maskz_loadu_pd(mask, features + idx);
+                const __m512d oldMeans = _mm512_maskz_loadu_pd(mask, means + idx);
+                const __m512d weightedDeviations = _mm512_mul_pd(weights, _mm512_sub_pd(featureValues, oldMeans));
+                const __m512d newMeans = _mm512_add_pd(oldMeans, _mm512_div_pd(weightedDeviations, sumsWeights));
+
+                _mm512_mask_storeu_pd(means + idx, mask, newMeans);
+                _mm512_mask_storeu_pd(deviations + idx, mask, _mm512_fmadd_pd(weightedDeviations, _mm512_sub_pd(featureValues, newMeans), _mm512_maskz_loadu_pd(mask, deviations + idx)));
+                _mm512_mask_storeu_pd(covariations + idx, mask, _mm512_fmadd_pd(weightedDeviations, goalDeviations, _mm512_maskz_loadu_pd(mask, covariations + idx)));
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        void UpdateNormalizedWelfordSLR(const size_t size,
+                                        const double weight,
+                                        const double sumWeights,
+                                        const double lastGoalDeviation,
+                                        const double* features,
+                                        double* means,
+                                        double* deviations,
+                                        double* covariations)
+        {
+            const __m512d weights = _mm512_set1_pd(weight);
+            const __m512d sumsWeights = _mm512_set1_pd(sumWeights);
+            const __m512d lastGoalDeviations = _mm512_set1_pd(lastGoalDeviation);
+
+            for (size_t idx = 0; idx < size; idx += 8) {
+                const __mmask8 mask = idx + 8 <= size ? (__mmask8)0xFF : TailMask(size - idx);
+
+                const __m512d featureValues = _mm512_maskz_loadu_pd(mask, features + idx);
+                const __m512d oldMeans = _mm512_maskz_loadu_pd(mask, means + idx);
+                const __m512d lastDeviations = _mm512_sub_pd(featureValues, oldMeans);
+                const __m512d newMeans = _mm512_add_pd(oldMeans, _mm512_div_pd(_mm512_mul_pd(weights, lastDeviations), sumsWeights));
+                const __m512d newDeviations = _mm512_sub_pd(featureValues, newMeans);
+
+                const __m512d oldDeviations = _mm512_maskz_loadu_pd(mask, deviations + idx);
+                const __m512d deviationsDiffs = _mm512_fmsub_pd(lastDeviations, newDeviations, oldDeviations);
+                const __m512d oldCovariations = _mm512_maskz_loadu_pd(mask, covariations + idx);
+                const __m512d covariationsDiffs = _mm512_fmsub_pd(lastGoalDeviations, newDeviations, oldCovariations);
+
+                _mm512_mask_storeu_pd(means + idx, mask, newMeans);
+                _mm512_mask_storeu_pd(deviations + idx, mask, _mm512_add_pd(oldDeviations, _mm512_div_pd(_mm512_mul_pd(weights, deviationsDiffs), sumsWeights)));
+                _mm512_mask_storeu_pd(covariations + idx, mask, _mm512_add_pd(oldCovariations, _mm512_div_pd(_mm512_mul_pd(weights, covariationsDiffs), sumsWeights)));
+            }
+        }
+    }
+#endif
+
+    const NVectorKernels::TKernels ScalarKernels = {
+        NVectorKernels::IS_SCALAR,
+        &NScalar::Axpy,
+        &NScalar::NormalizedAxpy,
+        &NScalar::UpdateMeans,
+        &NScalar::Dot,
+        &NScalar::AddDots4,
+        &NScalar::AddSLRMoments,
+        &NScalar::AddKahanSLRMoments,
+        &NScalar::UpdateWelfordSLR,
+        &NScalar::UpdateNormalizedWelfordSLR,
+    };
+
+#ifdef VECTOR_KERNELS_X86
+    const NVectorKernels::TKernels Avx2Kernels = {
+        NVectorKernels::IS_AVX2,
+        &NAvx2::Axpy,
+        &NAvx2::NormalizedAxpy,
+        &NAvx2::UpdateMeans,
+        &NAvx2::Dot,
+        &NAvx2::AddDots4,
+        &NAvx2::AddSLRMoments,
+        &NAvx2::AddKahanSLRMoments,
+        &NAvx2::UpdateWelfordSLR,
+        &NAvx2::UpdateNormalizedWelfordSLR,
+    };
+
+    const NVectorKernels::TKernels Avx512Kernels = {
+        NVectorKernels::IS_AVX512,
+        &NAvx512::Axpy,
+        &NAvx512::NormalizedAxpy,
+        &NAvx512::UpdateMeans,
+        &NAvx512::Dot,
+        &NAvx512::AddDots4,
+        &NAvx512::AddSLRMoments,
+        &NAvx512::AddKahanSLRMoments,
+        &NAvx512::UpdateWelfordSLR,
+        &NAvx512::UpdateNormalizedWelfordSLR,
+    };
+#endif
+}
+
+namespace NVectorKernels {
+    bool IsSupported(const EInstructionSet instructionSet) {
+        switch (instructionSet) {
+            case IS_SCALAR:
+                return true;
+#ifdef VECTOR_KERNELS_X86
+            case IS_AVX2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case IS_AVX512:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx512f");
+#else
+            default:
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    EInstructionSet BestSupported() {
+        if (IsSupported(IS_AVX512)) {
+            return IS_AVX512;
+        }
+        if (IsSupported(IS_AVX2)) {
+            return IS_AVX2;
+        }
+        return IS_SCALAR;
+    }
+
+    std::string ToString(const EInstructionSet instructionSet) {
+        switch (instructionSet) {
+            case IS_SCALAR:
+                return "scalar";
+            case IS_AVX2:
+                return "avx2";
+            case IS_AVX512:
+                return "avx512";
+        }
+        return "unknown";
+    }
+
+    const TKernels& GetKernels(const EInstructionSet instructionSet) {
+#ifdef VECTOR_KERNELS_X86
+        if (IsSupported(instructionSet)) {
+            switch (instructionSet) {
+                case IS_SCALAR:
+                    return ScalarKernels;
+                case IS_AVX2:
+                    return Avx2Kernels;
+                case IS_AVX512:
+                    return Avx512Kernels;
+            }
+        }
+#endif
+        return ScalarKernels;
+    }
+
+    const TKernels* Active = &GetKernels(BestSupported());
+
+    void SetActive(const EInstructionSet instructionSet) {
+        Active = &GetKernels(instructionSet);
+    }
+}
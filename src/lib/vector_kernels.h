@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Hot loops of the solvers with explicit SIMD implementations; the instruction set is chosen at runtime
+// from the CPUID flags, so the same binary runs on hosts with and without AVX2 / AVX-512.
+namespace NVectorKernels {
+    enum EInstructionSet {
+        IS_SCALAR,
+        IS_AVX2,
+        IS_AVX512,
+    };
+
+    struct TKernels {
+        EInstructionSet InstructionSet;
+
+        // y += alpha * x
+        void (*Axpy)(const size_t size, const double alpha, const double* x, double* y);
+
+        // y += factor * (alpha * x - y)
+        void (*NormalizedAxpy)(const size_t size, const double alpha, const double factor, const double* x, double* y);
+
+        // weightedLastDeviations = weight * (features - means)
+        // means += weight * (features - means) / sumWeights
+        // newDeviations = features - means
+        void (*UpdateMeans)(const size_t size,
+                            const double weight,
+                            const double sumWeights,
+                            const double* features,
+                            double* means,
+                            double* weightedLastDeviations,
+                            double* newDeviations);
+
+        double (*Dot)(const size_t size, const double* x, const double* y);
+
+        // result[i] += dot(left, columns + i * size) for i < 4
+        void (*AddDots4)(const size_t size, const double* left, const double* columns, double* result);
+
+        // the moments of the simple regressions on every feature, laid out as size sums of each kind:
+        // moments[i] += weight * x[i], moments[size + i] += weight * x[i] * x[i], moments[2 * size + i] += weight * goal * x[i]
+        void (*AddSLRMoments)(const size_t size, const double weight, const double goal, const double* features, double* moments);
+
+        // the same sums with Kahan summation, the compensations are laid out as the moments
+        void (*AddKahanSLRMoments)(const size_t size, const double weight, const double goal, const double* features, double* moments, double* compensations);
+
+        // Welford updates of the simple regressions on every feature, goalDeviation is the one from the new goals mean:
+        // weightedDeviations = weight * (features - means)
+        // means += weightedDeviations / sumWeights
+        // deviations += weightedDeviations * (features - means)
+        // covariations += weightedDeviations * goalDeviation
+        void (*UpdateWelfordSLR)(const size_t size,
+                                 const double weight,
+                                 const double sumWeights,
+                                 const double goalDeviation,
+                                 const double* features,
+                                 double* means,
+                                 double* deviations,
+                                 double* covariations);
+
+        // the same for the normalized statistics, lastGoalDeviation is the one from the previous goals mean:
+        // means += weight * (features - lastMeans) / sumWeights
+        // deviations += weight * ((features - lastMeans) * (features - means) - deviations) / sumWeights
+        // covariations += weight * (lastGoalDeviation * (features - means) - covariations) / sumWeights
+        void (*UpdateNormalizedWelfordSLR)(const size_t size,
+                                           const double weight,
+                                           const double sumWeights,
+                                           const double lastGoalDeviation,
+                                           const double* features,
+                                           double* means,
+                                           double* deviations,
+                                           double* covariations);
+    };
+
+    bool IsSupported(const EInstructionSet instructionSet);
+    EInstructionSet BestSupported();
+    std::string ToString(const EInstructionSet instructionSet);
+
+    const TKernels& GetKernels(const EInstructionSet instructionSet);
+
+    // kernels used by the solvers, the best supported ones unless overridden
+    extern const TKernels* Active;
+    void SetActive(const EInstructionSet instructionSet);
+
+    inline void Axpy(const size_t size, const double alpha, const double* x, double* y) {
+        Active->Axpy(size, alpha, x, y);
+    }
+
+    inline void NormalizedAxpy(const size_t size, const double alpha, const double factor, const double* x, double* y) {
+        Active->NormalizedAxpy(size, alpha, factor, x, y);
+    }
+
+    inline void UpdateMeans(const size_t size,
+                            const double weight,
+                            const double sumWeights,
+                            const double* features,
+                            double* means,
+                            double* weightedLastDeviations,
+                            double* newDeviations)
+    {
+        Active->UpdateMeans(size, weight, sumWeights, features, means, weightedLastDeviations, newDeviations);
+    }
+
+    inline double Dot(const size_t size, const double* x, const double* y) {
+        return Active->Dot(size, x, y);
+    }
+
+    inline void AddDots4(const size_t size, const double* left, const double* columns, double* result) {
+        Active->AddDots4(size, left, columns, result);
+    }
+
+    inline void AddSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments) {
+        Active->AddSLRMoments(size, weight, goal, features, moments);
+    }
+
+    inline void AddKahanSLRMoments(const size_t size, const double weight, const double goal, const double* features, double* moments, double* compensations) {
+        Active->AddKahanSLRMoments(size, weight, goal, features, moments, compensations);
+    }
+
+    inline void UpdateWelfordSLR(const size_t size,
+                                 const double weight,
+                                 const double sumWeights,
+                                 const double goalDeviation,
+                                 const double* features,
+                                 double* means,
+                                 double* deviations,
+                                 double* covariations)
+    {
+        Active->UpdateWelfordSLR(size, weight, sumWeights, goalDeviation, features, means, deviations, covariations);
+    }
+
+    inline void UpdateNormalizedWelfordSLR(const size_t size,
+                                           const double weight,
+                                           const double sumWeights,
+                                           const double lastGoalDeviation,
+                                           const double* features,
+                                           double* means,
+                                           double* deviations,
+                                           double* covariations)
+    {
+        Active->UpdateNormalizedWelfordSLR(size, weight, sumWeights, lastGoalDeviation, features, means, deviations, covariations);
+    }
+}